@@ -13,8 +13,9 @@
 
 namespace AudioCore::Codec {
 
-StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state) {
+void DecodeADPCM(const u8* const data, const std::size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state,
+                 std::span<std::array<s16, 2>> out) {
     // GC-ADPCM with scale factor and variable coefficients.
     // Frames are 8 bytes long containing 14 samples each.
     // Samples are 4 bits (one nibble) long.
@@ -25,9 +26,7 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
         0, 1, 2, 3, 4, 5, 6, 7, -8, -7, -6, -5, -4, -3, -2, -1,
     };
 
-    const std::size_t ret_size =
-        sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
-    StereoBuffer16 ret(ret_size);
+    ASSERT(out.size() >= GetADPCMDecodedLength(sample_count));
 
     int yn1 = state.yn1, yn2 = state.yn2;
 
@@ -62,11 +61,11 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
         std::size_t datai = framei * FRAME_LEN + 1;
         for (std::size_t i = 0; i < SAMPLES_PER_FRAME && outputi < sample_count; i += 2) {
             const s16 sample1 = decode_sample(SIGNED_NIBBLES[data[datai] >> 4]);
-            ret[outputi].fill(sample1);
+            out[outputi].fill(sample1);
             outputi++;
 
             const s16 sample2 = decode_sample(SIGNED_NIBBLES[data[datai] & 0xF]);
-            ret[outputi].fill(sample2);
+            out[outputi].fill(sample2);
             outputi++;
 
             datai++;
@@ -75,52 +74,43 @@ StereoBuffer16 DecodeADPCM(const u8* const data, const std::size_t sample_count,
 
     state.yn1 = static_cast<s16>(yn1);
     state.yn2 = static_cast<s16>(yn2);
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const std::size_t sample_count) {
+void DecodePCM8(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                std::span<std::array<s16, 2>> out) {
     ASSERT(num_channels == 1 || num_channels == 2);
+    ASSERT(out.size() >= sample_count);
 
     const auto decode_sample = [](u8 sample) {
         return static_cast<s16>(static_cast<u16>(sample) << 8);
     };
 
-    StereoBuffer16 ret(sample_count);
-
     if (num_channels == 1) {
         for (std::size_t i = 0; i < sample_count; i++) {
-            ret[i].fill(decode_sample(data[i]));
+            out[i].fill(decode_sample(data[i]));
         }
     } else {
         for (std::size_t i = 0; i < sample_count; i++) {
-            ret[i][0] = decode_sample(data[i * 2 + 0]);
-            ret[i][1] = decode_sample(data[i * 2 + 1]);
+            out[i][0] = decode_sample(data[i * 2 + 0]);
+            out[i][1] = decode_sample(data[i * 2 + 1]);
         }
     }
-
-    return ret;
 }
 
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const std::size_t sample_count) {
+void DecodePCM16(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                 std::span<std::array<s16, 2>> out) {
     ASSERT(num_channels == 1 || num_channels == 2);
-
-    StereoBuffer16 ret(sample_count);
+    ASSERT(out.size() >= sample_count);
 
     if (num_channels == 1) {
         for (std::size_t i = 0; i < sample_count; i++) {
             s16 sample;
             std::memcpy(&sample, data + i * sizeof(s16), sizeof(s16));
-            ret[i].fill(sample);
+            out[i].fill(sample);
         }
     } else {
-        for (std::size_t i = 0; i < sample_count; ++i) {
-            std::memcpy(&ret[i], data + i * sizeof(s16) * 2, 2 * sizeof(s16));
-        }
+        // Interleaved stereo PCM16 has the same layout as the output
+        std::memcpy(out.data(), data, sample_count * 2 * sizeof(s16));
     }
-
-    return ret;
 }
 } // namespace AudioCore::Codec
@@ -5,6 +5,8 @@
 #pragma once
 
 #include <array>
+#include <cstddef>
+#include <span>
 #include "audio_core/audio_types.h"
 #include "common/common_types.h"
 
@@ -18,31 +20,38 @@ struct ADPCMState {
     s16 yn2; ///< y[n-2]
 };
 
+/// Returns the number of samples DecodeADPCM writes for a buffer of sample_count samples.
+constexpr std::size_t GetADPCMDecodedLength(std::size_t sample_count) {
+    return sample_count % 2 == 0 ? sample_count : sample_count + 1; // Ensure multiple of two.
+}
+
 /**
  * @param data Pointer to buffer that contains ADPCM data to decode
  * @param sample_count Length of buffer in terms of number of samples
  * @param adpcm_coeff ADPCM coefficients
  * @param state ADPCM state, this is updated with new state
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param out Where to write the decoded stereo signed PCM16 data, at least
+ *            GetADPCMDecodedLength(sample_count) in length
  */
-StereoBuffer16 DecodeADPCM(const u8* data, const std::size_t sample_count,
-                           const std::array<s16, 16>& adpcm_coeff, ADPCMState& state);
+void DecodeADPCM(const u8* data, const std::size_t sample_count,
+                 const std::array<s16, 16>& adpcm_coeff, ADPCMState& state,
+                 std::span<std::array<s16, 2>> out);
 
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM8 data to decode
  * @param sample_count Length of buffer in terms of number of samples
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param out Where to write the decoded stereo signed PCM16 data, at least sample_count in length
  */
-StereoBuffer16 DecodePCM8(const unsigned num_channels, const u8* const data,
-                          const std::size_t sample_count);
+void DecodePCM8(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                std::span<std::array<s16, 2>> out);
 
 /**
  * @param num_channels Number of channels
  * @param data Pointer to buffer that contains PCM16 data to decode
  * @param sample_count Length of buffer in terms of number of samples
- * @return Decoded stereo signed PCM16 data, sample_count in length
+ * @param out Where to write the decoded stereo signed PCM16 data, at least sample_count in length
  */
-StereoBuffer16 DecodePCM16(const unsigned num_channels, const u8* const data,
-                           const std::size_t sample_count);
+void DecodePCM16(const unsigned num_channels, const u8* const data, const std::size_t sample_count,
+                 std::span<std::array<s16, 2>> out);
 } // namespace AudioCore::Codec
@@ -7,6 +7,7 @@
 #include "audio_core/sink.h"
 #include "audio_core/sink_details.h"
 #include "common/assert.h"
+#include "common/logging/log.h"
 #include "common/settings.h"
 #include "core/core.h"
 #include "core/dumping/backend.h"
@@ -14,7 +15,14 @@
 namespace AudioCore {
 
 DspInterface::DspInterface() = default;
-DspInterface::~DspInterface() = default;
+
+DspInterface::~DspInterface() {
+    const AudioOutputStats stats = GetOutputStats();
+    LOG_DEBUG(Audio,
+              "Audio output: {} underruns ({} frames), {} overruns ({} frames), {} ms max latency",
+              stats.underruns, stats.underrun_frames, stats.overruns, stats.overrun_frames,
+              stats.max_latency_us / 1000);
+}
 
 void DspInterface::SetSink(AudioCore::SinkType sink_type, std::string_view audio_device) {
     // Dispose of the current sink first to avoid contention.
@@ -41,11 +49,28 @@ void DspInterface::EnableStretching(bool enable) {
     perform_time_stretching = enable;
 }
 
+AudioOutputStats DspInterface::GetOutputStats() const {
+    return {underruns.load(std::memory_order_relaxed),
+            underrun_frames.load(std::memory_order_relaxed),
+            overruns.load(std::memory_order_relaxed),
+            overrun_frames.load(std::memory_order_relaxed),
+            latency_us.load(std::memory_order_relaxed),
+            max_latency_us.load(std::memory_order_relaxed)};
+}
+
+void DspInterface::PushFrames(const void* frames, std::size_t num_frames) {
+    const std::size_t pushed = fifo.Push(frames, num_frames);
+    if (pushed < num_frames) [[unlikely]] {
+        overruns.fetch_add(1, std::memory_order_relaxed);
+        overrun_frames.fetch_add(num_frames - pushed, std::memory_order_relaxed);
+    }
+}
+
 void DspInterface::OutputFrame(StereoFrame16 frame) {
     if (!sink)
         return;
 
-    fifo.Push(frame.data(), frame.size());
+    PushFrames(frame.data(), frame.size());
 
     auto video_dumper = Core::System::GetInstance().GetVideoDumper();
     if (video_dumper && video_dumper->IsDumping()) {
@@ -57,7 +82,7 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
     if (!sink)
         return;
 
-    fifo.Push(&sample, 1);
+    PushFrames(&sample, 1);
 
     auto video_dumper = Core::System::GetInstance().GetVideoDumper();
     if (video_dumper && video_dumper->IsDumping()) {
@@ -68,9 +93,8 @@ void DspInterface::OutputSample(std::array<s16, 2> sample) {
 void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
     std::size_t frames_written = 0;
     if (perform_time_stretching) {
-        const std::vector<s16> in{fifo.Pop()};
-        const std::size_t num_in{in.size() / 2};
-        frames_written = time_stretcher.Process(in.data(), num_in, buffer, num_frames);
+        const std::size_t num_in = fifo.Pop(stretch_buffer.data(), FIFO_CAPACITY);
+        frames_written = time_stretcher.Process(stretch_buffer.data(), num_in, buffer, num_frames);
     } else {
         if (flushing_time_stretcher) {
             time_stretcher.Flush();
@@ -93,6 +117,19 @@ void DspInterface::OutputCallback(s16* buffer, std::size_t num_frames) {
         std::memcpy(buffer + 2 * i, &last_frame[0], 2 * sizeof(s16));
     }
 
+    if (frames_written < num_frames) {
+        underruns.fetch_add(1, std::memory_order_relaxed);
+        underrun_frames.fetch_add(num_frames - frames_written, std::memory_order_relaxed);
+    }
+
+    // Audio still queued after this callback, which is played before anything output from now on
+    const std::size_t queued_frames = fifo.Size() + time_stretcher.GetBacklog();
+    const u64 latency = queued_frames * 1'000'000 / native_sample_rate;
+    latency_us.store(latency, std::memory_order_relaxed);
+    if (latency > max_latency_us.load(std::memory_order_relaxed)) {
+        max_latency_us.store(latency, std::memory_order_relaxed);
+    }
+
     // Implementation of the hardware volume slider
     // A cubic curve is used to approximate a linear change in human-perceived loudness
     const float linear_volume = std::clamp(Settings::Volume(), 0.0f, 1.0f);
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <span>
 #include <boost/serialization/access.hpp>
@@ -22,6 +24,16 @@ namespace AudioCore {
 class Sink;
 enum class SinkType : u32;
 
+/// Counters of the audio output path, for tuning buffer sizes
+struct AudioOutputStats {
+    u64 underruns;        ///< Sink callbacks that could not be fully filled with audio
+    u64 underrun_frames;  ///< Frames of silence (held last frame) emitted by those callbacks
+    u64 overruns;         ///< Output pushes that did not fit in the output ring
+    u64 overrun_frames;   ///< Frames dropped by those pushes
+    u64 latency_us;       ///< Audio queued ahead of the sink at the last callback
+    u64 max_latency_us;   ///< Largest latency observed at a callback
+};
+
 class DspInterface {
 public:
     DspInterface();
@@ -101,20 +113,38 @@ public:
     Sink& GetSink();
     /// Enable/Disable audio stretching.
     void EnableStretching(bool enable);
+    /// Returns the counters of the audio output path. Can be called from any thread.
+    AudioOutputStats GetOutputStats() const;
 
 protected:
     void OutputFrame(StereoFrame16 frame);
     void OutputSample(std::array<s16, 2> sample);
 
 private:
+    static constexpr std::size_t FIFO_CAPACITY = 0x2000; ///< In frames
+
     void FlushResidualStretcherAudio();
+    void PushFrames(const void* frames, std::size_t num_frames);
     void OutputCallback(s16* buffer, std::size_t num_frames);
 
     std::atomic<bool> perform_time_stretching = false;
     std::atomic<bool> flushing_time_stretcher = false;
-    Common::RingBuffer<s16, 0x2000, 2> fifo;
+    Common::RingBuffer<s16, FIFO_CAPACITY, 2> fifo;
+    /// Frames drained from the fifo for the time stretcher. Preallocated so that the sink
+    /// callback, which runs on a real-time thread, never allocates.
+    std::array<s16, FIFO_CAPACITY * 2> stretch_buffer;
     std::array<s16, 2> last_frame{};
     TimeStretcher time_stretcher;
+
+    // Written by the emulation thread
+    std::atomic<u64> overruns = 0;
+    std::atomic<u64> overrun_frames = 0;
+    // Written by the sink thread
+    std::atomic<u64> underruns = 0;
+    std::atomic<u64> underrun_frames = 0;
+    std::atomic<u64> latency_us = 0;
+    std::atomic<u64> max_latency_us = 0;
+
     std::unique_ptr<Sink> sink;
 
     template <class Archive>
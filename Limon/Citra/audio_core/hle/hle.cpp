@@ -23,6 +23,8 @@
 #include "common/common_types.h"
 #include "common/hash.h"
 #include "common/logging/log.h"
+#include "common/settings.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/core_timing.h"
 
@@ -49,6 +51,12 @@ SERIALIZE_IMPL(DspHle)
 // This value has been verified against a rough hardware test with hardware and LLE
 static constexpr u64 audio_frame_ticks = samples_per_frame * 4096 * 2ull; ///< Units: ARM11 cycles
 
+// When sources are ticked in parallel, they are split into this many groups of consecutive sources.
+// The emulation thread ticks the first group and the source workers tick the rest.
+static constexpr std::size_t num_source_groups = 4;
+static constexpr std::size_t sources_per_group = HLE::num_sources / num_source_groups;
+static_assert(HLE::num_sources % num_source_groups == 0);
+
 struct DspHle::Impl final {
 public:
     explicit Impl(DspHle& parent, Memory::MemorySystem& memory, Core::Timing& timing);
@@ -76,6 +84,8 @@ private:
     HLE::SharedMemory& ReadRegion();
     HLE::SharedMemory& WriteRegion();
 
+    /// Ticks the sources in [begin, end) and mixes their output into mixes.
+    void TickSources(std::size_t begin, std::size_t end, std::array<QuadFrame32, 3>& mixes);
     StereoFrame16 GenerateCurrentFrame();
     bool Tick();
     void AudioTickCallback(s64 cycles_late);
@@ -99,6 +109,9 @@ private:
 
     std::unique_ptr<HLE::DecoderBase> decoder{};
 
+    /// Ticks sources alongside the emulation thread. Null if sources are ticked serially.
+    std::unique_ptr<Common::ThreadWorker> source_workers;
+
     std::function<void(Service::DSP::InterruptType type, DspPipe pipe)> interrupt_handler{};
 
     template <class Archive>
@@ -134,6 +147,11 @@ DspHle::Impl::Impl(DspHle& parent_, Memory::MemorySystem& memory, Core::Timing&
         source.SetMemory(memory);
     }
 
+    if (Settings::values.parallel_audio_sources.GetValue()) {
+        source_workers =
+            std::make_unique<Common::ThreadWorker>(num_source_groups - 1, "DspHleSources");
+    }
+
     for (auto& factory : decoder_backends) {
         decoder = factory(memory);
         if (decoder && decoder->IsValid()) {
@@ -397,6 +415,20 @@ HLE::SharedMemory& DspHle::Impl::WriteRegion() {
     return CurrentRegionIndex() != 0 ? dsp_memory.region_0 : dsp_memory.region_1;
 }
 
+void DspHle::Impl::TickSources(std::size_t begin, std::size_t end,
+                               std::array<QuadFrame32, 3>& mixes) {
+    HLE::SharedMemory& read = ReadRegion();
+    HLE::SharedMemory& write = WriteRegion();
+
+    for (std::size_t i = begin; i < end; i++) {
+        write.source_statuses.status[i] =
+            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
+        for (std::size_t mix = 0; mix < 3; mix++) {
+            sources[i].MixInto(mixes[mix], mix);
+        }
+    }
+}
+
 StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
     HLE::SharedMemory& read = ReadRegion();
     HLE::SharedMemory& write = WriteRegion();
@@ -404,12 +436,32 @@ StereoFrame16 DspHle::Impl::GenerateCurrentFrame() {
     std::array<QuadFrame32, 3> intermediate_mixes = {};
 
     // Generate intermediate mixes
-    for (std::size_t i = 0; i < HLE::num_sources; i++) {
-        write.source_statuses.status[i] =
-            sources[i].Tick(read.source_configurations.config[i], read.adpcm_coefficients.coeff[i]);
-        for (std::size_t mix = 0; mix < 3; mix++) {
-            sources[i].MixInto(intermediate_mixes[mix], mix);
+    if (source_workers) {
+        // Sources only touch their own state and shared memory entries, so the groups can be
+        // ticked concurrently. Each group is mixed separately and the group mixes are then summed
+        // in order; mixing is integer addition, so the result is identical to the serial mix.
+        std::array<std::array<QuadFrame32, 3>, num_source_groups - 1> group_mixes{};
+        for (std::size_t group = 1; group < num_source_groups; group++) {
+            source_workers->QueueWork([this, group, &group_mixes] {
+                TickSources(group * sources_per_group, (group + 1) * sources_per_group,
+                            group_mixes[group - 1]);
+            });
+        }
+        TickSources(0, sources_per_group, intermediate_mixes);
+        source_workers->WaitForRequests();
+
+        for (const auto& group_mix : group_mixes) {
+            for (std::size_t mix = 0; mix < 3; mix++) {
+                for (std::size_t samplei = 0; samplei < samples_per_frame; samplei++) {
+                    for (std::size_t channeli = 0; channeli < 4; channeli++) {
+                        intermediate_mixes[mix][samplei][channeli] +=
+                            group_mix[mix][samplei][channeli];
+                    }
+                }
+            }
         }
+    } else {
+        TickSources(0, HLE::num_sources, intermediate_mixes);
     }
 
     // Generate final mix
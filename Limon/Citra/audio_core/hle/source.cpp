@@ -178,8 +178,8 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
         // the same buffer?), flags2_raw.is_looping, and length.
 
         // A quick and dirty way of extending the current buffer is to just read the whole thing
-        // again with the new length. Note that this uses the latched physical address instead of
-        // whatever is in config, because that may be invalid.
+        // again with the new length, into the same storage. Note that this uses the latched
+        // physical address instead of whatever is in config, because that may be invalid.
         const u8* const memory =
             memory_system->GetPhysicalPointer(state.current_buffer_physical_address & 0xFFFFFFFC);
 
@@ -196,7 +196,8 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                 // state.current_buffer = Codec::DecodePCM8(num_channels, memory, config.length);
                 break;
             case Format::PCM16:
-                state.current_buffer = Codec::DecodePCM16(num_channels, memory, config.length);
+                Codec::DecodePCM16(num_channels, memory, config.length,
+                                   state.current_buffer.Prepare(config.length));
                 valid = true;
                 break;
             case Format::ADPCM:
@@ -212,21 +213,18 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
                 break;
             }
 
-            // Again, because our interpolation consumes samples instead of using an index, let's
-            // just re-consume the samples up to the current sample number. There may be some
-            // imprecision here with the current sample number, as Detective Pikachu sounds a little
-            // rough at times.
+            // Skip the samples that were already played, up to the current sample number. There
+            // may be some imprecision here with the current sample number, as Detective Pikachu
+            // sounds a little rough at times.
             if (valid) {
 
                 // TODO(xperia64): Tomodachi life apparently can decrease config.length when the
                 // user skips dialog. I don't know the correct behavior, but to avoid crashing, just
                 // reset the current sample number to 0 and don't try to truncate the buffer
-                if (state.current_buffer.size() < state.current_sample_number) {
+                if (state.current_buffer.Size() < state.current_sample_number) {
                     state.current_sample_number = 0;
                 } else {
-                    state.current_buffer.erase(
-                        state.current_buffer.begin(),
-                        std::next(state.current_buffer.begin(), state.current_sample_number));
+                    state.current_buffer.Consume(state.current_sample_number);
                 }
             }
         }
@@ -321,7 +319,7 @@ void Source::ParseConfig(SourceConfiguration::Configuration& config,
 void Source::GenerateFrame() {
     current_frame.fill({});
 
-    if (state.current_buffer.empty() && !DequeueBuffer()) {
+    if (state.current_buffer.Empty() && !DequeueBuffer()) {
         state.enabled = false;
         state.buffer_update = true;
         state.current_buffer_id = 0;
@@ -332,28 +330,32 @@ void Source::GenerateFrame() {
 
     state.current_sample_number = state.next_sample_number;
     while (frame_position < current_frame.size()) {
-        if (state.current_buffer.empty() && !DequeueBuffer()) {
+        if (state.current_buffer.Empty() && !DequeueBuffer()) {
             break;
         }
 
+        const auto input = state.current_buffer.GetInput();
+        std::size_t consumed = 0;
         switch (state.interpolation_mode) {
         case InterpolationMode::None:
-            AudioInterp::None(state.interp_state, state.current_buffer, state.rate_multiplier,
-                              current_frame, frame_position);
+            consumed = AudioInterp::None(state.interp_state, input, state.rate_multiplier,
+                                         current_frame, frame_position);
             break;
         case InterpolationMode::Linear:
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier,
-                                current_frame, frame_position);
+            consumed = AudioInterp::Linear(state.interp_state, input, state.rate_multiplier,
+                                           current_frame, frame_position);
             break;
         case InterpolationMode::Polyphase:
-            // TODO(merry): Implement polyphase interpolation
-            AudioInterp::Linear(state.interp_state, state.current_buffer, state.rate_multiplier,
-                                current_frame, frame_position);
+            consumed = AudioInterp::Polyphase(state.interp_state, input, state.rate_multiplier,
+                                              current_frame, frame_position);
             break;
         default:
             UNIMPLEMENTED();
+            // Drop the buffer rather than spinning on it
+            consumed = state.current_buffer.Size();
             break;
         }
+        state.current_buffer.Consume(consumed);
     }
     // TODO(jroweboy): Keep track of frame_position independently so that it doesn't lose precision
     // over time
@@ -363,7 +365,7 @@ void Source::GenerateFrame() {
 }
 
 bool Source::DequeueBuffer() {
-    ASSERT_MSG(state.current_buffer.empty(),
+    ASSERT_MSG(state.current_buffer.Empty(),
                "Shouldn't dequeue; we still have data in current_buffer");
 
     if (state.input_queue.empty())
@@ -384,25 +386,29 @@ bool Source::DequeueBuffer() {
         const unsigned num_channels = buf.mono_or_stereo == MonoOrStereo::Stereo ? 2 : 1;
         switch (buf.format) {
         case Format::PCM8:
-            state.current_buffer = Codec::DecodePCM8(num_channels, memory, buf.length);
+            Codec::DecodePCM8(num_channels, memory, buf.length,
+                              state.current_buffer.Prepare(buf.length));
             break;
         case Format::PCM16:
-            state.current_buffer = Codec::DecodePCM16(num_channels, memory, buf.length);
+            Codec::DecodePCM16(num_channels, memory, buf.length,
+                               state.current_buffer.Prepare(buf.length));
             break;
         case Format::ADPCM:
             DEBUG_ASSERT(num_channels == 1);
-            state.current_buffer =
-                Codec::DecodeADPCM(memory, buf.length, state.adpcm_coeffs, state.adpcm_state);
+            Codec::DecodeADPCM(
+                memory, buf.length, state.adpcm_coeffs, state.adpcm_state,
+                state.current_buffer.Prepare(Codec::GetADPCMDecodedLength(buf.length)));
             break;
         default:
             UNIMPLEMENTED();
+            state.current_buffer.Clear();
             break;
         }
     } else {
         LOG_WARNING(Audio_DSP,
                     "source_id={} buffer_id={} length={}: Invalid physical address {:#010x}",
                     source_id, buf.buffer_id, buf.length, buf.physical_address);
-        state.current_buffer.clear();
+        state.current_buffer.Clear();
         return true;
     }
 
@@ -419,7 +425,7 @@ bool Source::DequeueBuffer() {
     }
 
     LOG_TRACE(Audio_DSP, "source_id={} buffer_id={} from_queue={} current_buffer.size()={}",
-              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.size());
+              source_id, buf.buffer_id, buf.from_queue, state.current_buffer.Size());
     return true;
 }
 
@@ -7,7 +7,6 @@
 #include <array>
 #include <vector>
 #include <boost/serialization/array.hpp>
-#include <boost/serialization/deque.hpp>
 #include <boost/serialization/priority_queue.hpp>
 #include <boost/serialization/vector.hpp>
 #include <queue>
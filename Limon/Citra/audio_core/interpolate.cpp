@@ -3,27 +3,118 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <numbers>
 #include "audio_core/interpolate.h"
 #include "common/assert.h"
 
 namespace AudioCore::AudioInterp {
 
+using Sample = std::array<s16, 2>;
+
 // Calculations are done in fixed point with 24 fractional bits.
 // (This is not verified. This was chosen for minimal error.)
 constexpr u64 scale_factor = 1 << 24;
 constexpr u64 scale_mask = scale_factor - 1;
 
+namespace {
+
+// The polyphase filter is a Blackman windowed sinc, sampled at polyphase_phases fractional
+// positions between the two centre taps. Coefficients are fixed point with 14 fractional bits.
+constexpr std::size_t polyphase_taps = 8;
+constexpr u32 polyphase_phase_bits = 8;
+constexpr std::size_t polyphase_phases = 1 << polyphase_phase_bits;
+constexpr s32 polyphase_coeff_bits = 14;
+/// Cutoff frequency, relative to the Nyquist frequency of the input.
+constexpr double polyphase_cutoff = 0.9;
+
+static_assert(polyphase_taps - 1 <= history_length);
+
+using PolyphaseCoefficients = std::array<std::array<s16, polyphase_taps>, polyphase_phases>;
+
+/// std::sin isn't constexpr, so the coefficient table uses this Taylor series instead.
+constexpr double ConstexprSin(double x) {
+    constexpr double pi = std::numbers::pi;
+    // Reduce to [-pi, pi]
+    x -= 2 * pi * static_cast<s64>(x / (2 * pi));
+    if (x > pi) {
+        x -= 2 * pi;
+    } else if (x < -pi) {
+        x += 2 * pi;
+    }
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 12; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double ConstexprCos(double x) {
+    return ConstexprSin(x + std::numbers::pi / 2);
+}
+
+constexpr double WindowedSinc(double x) {
+    constexpr double pi = std::numbers::pi;
+    constexpr double half_width = polyphase_taps / 2;
+    if (x <= -half_width || x >= half_width) {
+        return 0.0;
+    }
+    const double window = 0.42 + 0.5 * ConstexprCos(pi * x / half_width) +
+                          0.08 * ConstexprCos(2 * pi * x / half_width);
+    const double arg = pi * polyphase_cutoff * x;
+    const double sinc = x == 0.0 ? 1.0 : ConstexprSin(arg) / arg;
+    return sinc * window;
+}
+
+constexpr PolyphaseCoefficients MakePolyphaseCoefficients() {
+    constexpr s32 one = 1 << polyphase_coeff_bits;
+    PolyphaseCoefficients table{};
+    for (std::size_t phase = 0; phase < polyphase_phases; phase++) {
+        const double fraction = static_cast<double>(phase) / polyphase_phases;
+        std::array<double, polyphase_taps> weights{};
+        double weight_sum = 0.0;
+        for (std::size_t tap = 0; tap < polyphase_taps; tap++) {
+            // The output lies between taps polyphase_taps / 2 - 1 and polyphase_taps / 2
+            const double x = static_cast<double>(tap) - (polyphase_taps / 2 - 1) - fraction;
+            weights[tap] = WindowedSinc(x);
+            weight_sum += weights[tap];
+        }
+        // Normalise every phase to unity gain, so that DC passes through exactly
+        s32 sum = 0;
+        std::size_t largest = 0;
+        for (std::size_t tap = 0; tap < polyphase_taps; tap++) {
+            const double value = weights[tap] / weight_sum * one;
+            const s32 rounded = static_cast<s32>(value < 0 ? value - 0.5 : value + 0.5);
+            table[phase][tap] = static_cast<s16>(rounded);
+            sum += rounded;
+            if (weights[tap] > weights[largest]) {
+                largest = tap;
+            }
+        }
+        table[phase][largest] = static_cast<s16>(table[phase][largest] + one - sum);
+    }
+    return table;
+}
+
+constexpr PolyphaseCoefficients polyphase_coefficients = MakePolyphaseCoefficients();
+
+} // Anonymous namespace
+
 /// Here we step over the input in steps of rate, until we consume all of the input.
-/// Three adjacent samples are passed to fn each step.
-template <typename Function>
-static void StepOverSamples(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-                            std::size_t& outputi, Function fn) {
+/// The window of num_taps adjacent samples starting at the current position is passed to fn each
+/// step; its first num_taps - 1 samples are in the past.
+template <std::size_t num_taps, typename Function>
+static std::size_t StepOverSamples(State& state, std::span<Sample> input, float rate,
+                                   StereoFrame16& output, std::size_t& outputi, Function fn) {
     ASSERT(rate > 0);
+    static_assert(num_taps - 1 <= history_length);
 
-    if (input.empty())
-        return;
+    if (input.size() == history_length)
+        return 0;
 
-    input.insert(input.begin(), {state.xn2, state.xn1});
+    std::copy(state.history.begin(), state.history.end(), input.begin());
+    const std::span<const Sample> window = input.subspan(history_length - (num_taps - 1));
 
     const u64 step_size = static_cast<u64>(rate * scale_factor);
     u64 fposition = state.fposition;
@@ -32,45 +123,71 @@ static void StepOverSamples(State& state, StereoBuffer16& input, float rate, Ste
     while (outputi < output.size()) {
         inputi = static_cast<std::size_t>(fposition / scale_factor);
 
-        if (inputi + 2 >= input.size()) {
-            inputi = input.size() - 2;
+        if (inputi + num_taps - 1 >= window.size()) {
+            inputi = window.size() - (num_taps - 1);
             break;
         }
 
         u64 fraction = fposition & scale_mask;
-        output[outputi++] = fn(fraction, input[inputi], input[inputi + 1], input[inputi + 2]);
+        const std::span<const Sample, num_taps> taps{&window[inputi], num_taps};
+        output[outputi++] = fn(fraction, taps);
 
         fposition += step_size;
     }
 
-    state.xn2 = input[inputi];
-    state.xn1 = input[inputi + 1];
+    std::copy_n(input.begin() + inputi, history_length, state.history.begin());
     state.fposition = fposition - inputi * scale_factor;
 
-    input.erase(input.begin(), std::next(input.begin(), inputi + 2));
+    return inputi;
 }
 
-void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-          std::size_t& outputi) {
-    StepOverSamples(
-        state, input, rate, output, outputi,
-        [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) { return x0; });
+std::size_t None(State& state, std::span<Sample> input, float rate, StereoFrame16& output,
+                 std::size_t& outputi) {
+    return StepOverSamples<3>(state, input, rate, output, outputi,
+                              [](u64 fraction, std::span<const Sample, 3> x) { return x[0]; });
 }
 
-void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-            std::size_t& outputi) {
+std::size_t Linear(State& state, std::span<Sample> input, float rate, StereoFrame16& output,
+                   std::size_t& outputi) {
     // Note on accuracy: Some values that this produces are +/- 1 from the actual firmware.
-    StepOverSamples(state, input, rate, output, outputi,
-                    [](u64 fraction, const auto& x0, const auto& x1, const auto& x2) {
-                        // This is a saturated subtraction. (Verified by black-box fuzzing.)
-                        s64 delta0 = std::clamp<s64>(x1[0] - x0[0], -32768, 32767);
-                        s64 delta1 = std::clamp<s64>(x1[1] - x0[1], -32768, 32767);
-
-                        return std::array<s16, 2>{
-                            static_cast<s16>(x0[0] + fraction * delta0 / scale_factor),
-                            static_cast<s16>(x0[1] + fraction * delta1 / scale_factor),
-                        };
-                    });
+    return StepOverSamples<3>(
+        state, input, rate, output, outputi, [](u64 fraction, std::span<const Sample, 3> x) {
+            // This is a saturated subtraction. (Verified by black-box fuzzing.)
+            s64 delta0 = std::clamp<s64>(x[1][0] - x[0][0], -32768, 32767);
+            s64 delta1 = std::clamp<s64>(x[1][1] - x[0][1], -32768, 32767);
+
+            return Sample{
+                static_cast<s16>(x[0][0] + fraction * delta0 / scale_factor),
+                static_cast<s16>(x[0][1] + fraction * delta1 / scale_factor),
+            };
+        });
+}
+
+std::size_t Polyphase(State& state, std::span<Sample> input, float rate, StereoFrame16& output,
+                      std::size_t& outputi) {
+    return StepOverSamples<polyphase_taps>(
+        state, input, rate, output, outputi,
+        [](u64 fraction, std::span<const Sample, polyphase_taps> x) {
+            const auto& coeffs =
+                polyphase_coefficients[fraction >> (24 - polyphase_phase_bits)];
+
+            // Fixed trip count over contiguous data, which the compiler turns into vector
+            // multiply-accumulates.
+            s32 left = 0;
+            s32 right = 0;
+            for (std::size_t tap = 0; tap < polyphase_taps; tap++) {
+                left += coeffs[tap] * x[tap][0];
+                right += coeffs[tap] * x[tap][1];
+            }
+
+            constexpr s32 rounding = 1 << (polyphase_coeff_bits - 1);
+            return Sample{
+                static_cast<s16>(
+                    std::clamp((left + rounding) >> polyphase_coeff_bits, -32768, 32767)),
+                static_cast<s16>(
+                    std::clamp((right + rounding) >> polyphase_coeff_bits, -32768, 32767)),
+            };
+        });
 }
 
 } // namespace AudioCore::AudioInterp
@@ -5,19 +5,86 @@
 #pragma once
 
 #include <array>
-#include <deque>
+#include <span>
+#include <vector>
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/array.hpp>
+#include <boost/serialization/vector.hpp>
 #include "audio_core/audio_types.h"
+#include "common/assert.h"
 #include "common/common_types.h"
 
 namespace AudioCore::AudioInterp {
 
-/// A variable length buffer of signed PCM16 stereo samples.
-using StereoBuffer16 = std::deque<std::array<s16, 2>>;
+/// Number of past samples the interpolators need in front of their input. This is what the
+/// 8-tap polyphase filter needs; None and Linear only use the last two.
+constexpr std::size_t history_length = 7;
+
+/**
+ * A variable length buffer of signed PCM16 stereo samples, consumed from the front by moving a
+ * read index. The storage is contiguous and only ever grows, so once it has reached the size of the
+ * largest buffer played, decoding into it no longer allocates. The history_length slots in front
+ * of the unconsumed samples are reserved for the interpolation history, which lets the
+ * interpolators read their whole input as one span.
+ */
+class StereoBuffer16 {
+public:
+    using Sample = std::array<s16, 2>;
+
+    /**
+     * Discards the buffered samples and makes room for count new ones.
+     * @returns The span to write the new samples to
+     */
+    std::span<Sample> Prepare(std::size_t count) {
+        if (samples.size() < history_length + count) {
+            samples.resize(history_length + count);
+        }
+        read_index = history_length;
+        end_index = history_length + count;
+        return std::span{samples}.subspan(read_index, count);
+    }
+
+    /// Discards the buffered samples.
+    void Clear() {
+        read_index = end_index = history_length;
+    }
+
+    /// Discards the first count unconsumed samples.
+    void Consume(std::size_t count) {
+        DEBUG_ASSERT(count <= Size());
+        read_index += count;
+    }
+
+    /// Returns the unconsumed samples, preceded by history_length slots for the history.
+    [[nodiscard]] std::span<Sample> GetInput() {
+        return std::span{samples}.subspan(read_index - history_length, history_length + Size());
+    }
+
+    [[nodiscard]] std::size_t Size() const {
+        return end_index - read_index;
+    }
+
+    [[nodiscard]] bool Empty() const {
+        return read_index == end_index;
+    }
+
+private:
+    std::vector<Sample> samples = std::vector<Sample>(history_length);
+    std::size_t read_index = history_length;
+    std::size_t end_index = history_length;
+
+    template <class Archive>
+    void serialize(Archive& ar, const unsigned int) {
+        ar& samples;
+        ar& read_index;
+        ar& end_index;
+    }
+    friend class boost::serialization::access;
+};
 
 struct State {
-    /// Two historical samples.
-    std::array<s16, 2> xn1 = {}; ///< x[n-1]
-    std::array<s16, 2> xn2 = {}; ///< x[n-2]
+    /// Historical samples, oldest first. history.back() is x[n-1].
+    std::array<std::array<s16, 2>, history_length> history = {};
     /// Current fractional position.
     u64 fposition = 0;
 };
@@ -25,25 +92,44 @@ struct State {
 /**
  * No interpolation. This is equivalent to a zero-order hold. There is a two-sample predelay.
  * @param state Interpolation state.
- * @param input Input buffer.
+ * @param input Input samples, preceded by history_length slots which are overwritten with the
+ *              history from state.
  * @param rate Stretch factor. Must be a positive non-zero value.
  *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
  * @param output The resampled audio buffer.
  * @param outputi The index of output to start writing to.
+ * @returns The number of input samples consumed, not counting the history.
  */
-void None(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-          std::size_t& outputi);
+std::size_t None(State& state, std::span<std::array<s16, 2>> input, float rate,
+                 StereoFrame16& output, std::size_t& outputi);
 
 /**
  * Linear interpolation. This is equivalent to a first-order hold. There is a two-sample predelay.
  * @param state Interpolation state.
- * @param input Input buffer.
+ * @param input Input samples, preceded by history_length slots which are overwritten with the
+ *              history from state.
+ * @param rate Stretch factor. Must be a positive non-zero value.
+ *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
+ * @param output The resampled audio buffer.
+ * @param outputi The index of output to start writing to.
+ * @returns The number of input samples consumed, not counting the history.
+ */
+std::size_t Linear(State& state, std::span<std::array<s16, 2>> input, float rate,
+                   StereoFrame16& output, std::size_t& outputi);
+
+/**
+ * Polyphase interpolation with an 8-tap windowed sinc filter. There is a four-sample predelay.
+ * The filter's cutoff doesn't follow the rate, so decimation is not band-limited.
+ * @param state Interpolation state.
+ * @param input Input samples, preceded by history_length slots which are overwritten with the
+ *              history from state.
  * @param rate Stretch factor. Must be a positive non-zero value.
  *             rate > 1.0 performs decimation and rate < 1.0 performs upsampling.
  * @param output The resampled audio buffer.
  * @param outputi The index of output to start writing to.
+ * @returns The number of input samples consumed, not counting the history.
  */
-void Linear(State& state, StereoBuffer16& input, float rate, StereoFrame16& output,
-            std::size_t& outputi);
+std::size_t Polyphase(State& state, std::span<std::array<s16, 2>> input, float rate,
+                      StereoFrame16& output, std::size_t& outputi);
 
 } // namespace AudioCore::AudioInterp
@@ -119,4 +119,8 @@ void TimeStretcher::Flush() {
     sound_touch->flush();
 }
 
+std::size_t TimeStretcher::GetBacklog() const {
+    return sound_touch->numSamples();
+}
+
 } // namespace AudioCore
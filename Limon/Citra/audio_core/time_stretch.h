@@ -33,6 +33,9 @@ public:
 
     void Flush();
 
+    /// @returns Number of frames buffered in the stretcher that have not been output yet
+    std::size_t GetBacklog() const;
+
 private:
     std::unique_ptr<soundtouch::SoundTouch> sound_touch;
     double stretch_ratio = 1.0;
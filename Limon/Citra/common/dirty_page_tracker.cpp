@@ -0,0 +1,215 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <array>
+#include <bit>
+#include <mutex>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "common/dirty_page_tracker.h"
+#include "common/logging/log.h"
+
+#ifndef _WIN32
+#include <csignal>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace Common {
+
+#ifndef _WIN32
+
+namespace {
+
+// The fault handler may run on any thread at any time, so trackers are kept in a fixed table of
+// atomics instead of a container that would need locking.
+constexpr std::size_t MaxTrackers = 8;
+std::array<std::atomic<DirtyPageTracker*>, MaxTrackers> trackers{};
+
+struct sigaction old_segv_action {};
+struct sigaction old_bus_action {};
+
+void ForwardSignal(int sig, siginfo_t* info, void* context) {
+    const struct sigaction& old_action = sig == SIGSEGV ? old_segv_action : old_bus_action;
+    if (old_action.sa_flags & SA_SIGINFO) {
+        old_action.sa_sigaction(sig, info, context);
+    } else if (old_action.sa_handler == SIG_DFL) {
+        // Restore the default action; the faulting instruction will fault again and terminate.
+        sigaction(sig, &old_action, nullptr);
+    } else if (old_action.sa_handler != SIG_IGN) {
+        old_action.sa_handler(sig);
+    }
+}
+
+void HandleFault(int sig, siginfo_t* info, void* context) {
+    const auto address = static_cast<const u8*>(info->si_addr);
+    for (auto& slot : trackers) {
+        DirtyPageTracker* const tracker = slot.load(std::memory_order_acquire);
+        if (tracker && tracker->HandleWriteFault(address)) {
+            return;
+        }
+    }
+    ForwardSignal(sig, info, context);
+}
+
+void InstallFaultHandler() {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        struct sigaction action {};
+        action.sa_sigaction = HandleFault;
+        action.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigemptyset(&action.sa_mask);
+        // Depending on the platform, writes to protected pages raise SIGSEGV or SIGBUS.
+        sigaction(SIGSEGV, &action, &old_segv_action);
+        sigaction(SIGBUS, &action, &old_bus_action);
+    });
+}
+
+} // Anonymous namespace
+
+DirtyPageTracker::DirtyPageTracker(std::span<u8> memory_) : memory{memory_} {
+    page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const auto begin = reinterpret_cast<std::uintptr_t>(memory.data());
+    const auto protected_start = AlignUp(begin, page_size);
+    const auto protected_end = AlignDown(begin + memory.size(), page_size);
+    if (protected_end <= protected_start) {
+        return;
+    }
+    protected_begin = reinterpret_cast<u8*>(protected_start);
+    num_pages = (protected_end - protected_start) / page_size;
+    dirty = std::make_unique<std::atomic<u64>[]>((num_pages + 63) / 64);
+
+    InstallFaultHandler();
+    for (auto& slot : trackers) {
+        DirtyPageTracker* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, this, std::memory_order_acq_rel)) {
+            return;
+        }
+    }
+    LOG_ERROR(Common_Memory, "Too many dirty page trackers, tracking disabled");
+    num_pages = 0;
+}
+
+DirtyPageTracker::~DirtyPageTracker() {
+    Disarm();
+    for (auto& slot : trackers) {
+        DirtyPageTracker* expected = this;
+        slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+}
+
+void DirtyPageTracker::Arm() {
+    if (num_pages == 0) {
+        return;
+    }
+    for (std::size_t i = 0; i < (num_pages + 63) / 64; ++i) {
+        dirty[i].store(0, std::memory_order_relaxed);
+    }
+    armed.store(true, std::memory_order_release);
+    if (mprotect(protected_begin, num_pages * page_size, PROT_READ) != 0) {
+        LOG_ERROR(Common_Memory, "Failed to write-protect tracked memory");
+        armed.store(false, std::memory_order_release);
+        for (std::size_t i = 0; i < (num_pages + 63) / 64; ++i) {
+            dirty[i].store(~u64{0}, std::memory_order_relaxed);
+        }
+    }
+}
+
+void DirtyPageTracker::Disarm() {
+    if (!armed.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    mprotect(protected_begin, num_pages * page_size, PROT_READ | PROT_WRITE);
+}
+
+bool DirtyPageTracker::HandleWriteFault(const u8* address) {
+    if (!armed.load(std::memory_order_acquire) || address < protected_begin ||
+        address >= protected_begin + num_pages * page_size) {
+        return false;
+    }
+    const std::size_t page = static_cast<std::size_t>(address - protected_begin) / page_size;
+    // Unprotect before marking the page, so that a CollectDirtyRanges that clears the mark in
+    // between re-protects the page afterwards instead of leaving it writable and clean.
+    mprotect(protected_begin + page * page_size, page_size, PROT_READ | PROT_WRITE);
+    dirty[page / 64].fetch_or(u64{1} << (page % 64), std::memory_order_acq_rel);
+    return true;
+}
+
+void DirtyPageTracker::CollectDirtyRanges(
+    const std::function<void(std::size_t, std::size_t)>& func) {
+    if (num_pages == 0 || !armed.load(std::memory_order_acquire)) {
+        Arm();
+        func(0, memory.size());
+        return;
+    }
+
+    // The partial pages at either end can't be protected and are always reported.
+    const std::size_t head = static_cast<std::size_t>(protected_begin - memory.data());
+    const std::size_t tail_begin = head + num_pages * page_size;
+    if (head != 0) {
+        func(0, head);
+    }
+
+    std::size_t run_begin = 0;
+    std::size_t run_end = 0;
+    const auto flush_run = [&] {
+        if (run_end == run_begin) {
+            return;
+        }
+        u8* const begin = protected_begin + run_begin * page_size;
+        const std::size_t size = (run_end - run_begin) * page_size;
+        if (mprotect(begin, size, PROT_READ) != 0) {
+            // Keep the pages dirty so they are reported again until they can be protected
+            LOG_ERROR(Common_Memory, "Failed to write-protect tracked memory");
+            for (std::size_t page = run_begin; page < run_end; ++page) {
+                dirty[page / 64].fetch_or(u64{1} << (page % 64), std::memory_order_acq_rel);
+            }
+        }
+        func(head + run_begin * page_size, size);
+    };
+    // Clearing the marks before protecting the pages means a write in between is either seen by
+    // func, which reads the page after it has been protected, or faults and marks it again.
+    for (std::size_t word = 0; word < (num_pages + 63) / 64; ++word) {
+        u64 bits = dirty[word].exchange(0, std::memory_order_acq_rel);
+        while (bits != 0) {
+            const std::size_t page = word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+            bits &= bits - 1;
+            if (page != run_end) {
+                flush_run();
+                run_begin = page;
+            }
+            run_end = page + 1;
+        }
+    }
+    flush_run();
+
+    if (tail_begin != memory.size()) {
+        func(tail_begin, memory.size() - tail_begin);
+    }
+}
+
+#else
+
+// Write protection isn't used on Windows, so every page is always reported as dirty.
+
+DirtyPageTracker::DirtyPageTracker(std::span<u8> memory_) : memory{memory_} {}
+
+DirtyPageTracker::~DirtyPageTracker() = default;
+
+void DirtyPageTracker::Arm() {}
+
+void DirtyPageTracker::Disarm() {}
+
+bool DirtyPageTracker::HandleWriteFault(const u8*) {
+    return false;
+}
+
+void DirtyPageTracker::CollectDirtyRanges(
+    const std::function<void(std::size_t, std::size_t)>& func) {
+    func(0, memory.size());
+}
+
+#endif
+
+} // namespace Common
@@ -0,0 +1,59 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <span>
+#include "common/common_types.h"
+
+namespace Common {
+
+/**
+ * Tracks which host pages of a memory block have been written to, without having to compare or
+ * hash the block. While armed, the block is write-protected; the first write to each page faults,
+ * gets recorded and unprotects the page, so every page costs at most one fault per arming.
+ *
+ * Where write protection is unavailable every page is always reported as dirty. Memory that is
+ * being tracked must not be written to by the host kernel (e.g. by reading a file straight into
+ * it), since such writes fail instead of faulting.
+ */
+class DirtyPageTracker {
+public:
+    explicit DirtyPageTracker(std::span<u8> memory);
+    ~DirtyPageTracker();
+
+    DirtyPageTracker(const DirtyPageTracker&) = delete;
+    DirtyPageTracker& operator=(const DirtyPageTracker&) = delete;
+
+    /// Clears the dirty state of all pages and write-protects the memory.
+    void Arm();
+
+    /// Removes the write protection. Writes made afterwards are not tracked.
+    void Disarm();
+
+    /**
+     * Calls func(offset, size) for every run of consecutive pages written to since they were last
+     * armed, with offsets relative to the start of the tracked memory, and arms those pages again.
+     * Each page is write-protected before func is called for it, so writes made while or after
+     * func reads a range are reported by the next call rather than lost.
+     */
+    void CollectDirtyRanges(const std::function<void(std::size_t, std::size_t)>& func);
+
+    /// Called by the fault handler. Returns true if the fault address belongs to this tracker.
+    bool HandleWriteFault(const u8* address);
+
+private:
+    std::span<u8> memory;
+    u8* protected_begin = nullptr; ///< First host page fully inside the memory
+    std::size_t page_size = 0;
+    std::size_t num_pages = 0; ///< Number of write-protectable pages
+    std::unique_ptr<std::atomic<u64>[]> dirty;
+    std::atomic_bool armed{};
+};
+
+} // namespace Common
@@ -69,7 +69,13 @@ void LogSettings() {
 
     LOG_INFO(Config, "Citra Configuration:");
     log_setting("Core_UseCpuJit", values.use_cpu_jit.GetValue());
+    log_setting("Core_MultithreadedCpu", values.multithreaded_cpu.GetValue());
+    log_setting("Core_DeterministicCpu", values.deterministic_cpu.GetValue());
     log_setting("Core_CPUClockPercentage", values.cpu_clock_percentage.GetValue());
+    log_setting("Core_EnableRewind", values.enable_rewind.GetValue());
+    log_setting("Core_RewindMemoryBudget", values.rewind_memory_budget.GetValue());
+    log_setting("Core_RewindKeyframeInterval", values.rewind_keyframe_interval.GetValue());
+    log_setting("Core_RewindFrameInterval", values.rewind_frame_interval.GetValue());
     log_setting("Renderer_GraphicsAPI", GetGraphicsAPIName(values.graphics_api.GetValue()));
     log_setting("Renderer_AsyncShaders", values.async_shader_compilation.GetValue());
     log_setting("Renderer_AsyncPresentation", values.async_presentation.GetValue());
@@ -84,6 +90,8 @@ void LogSettings() {
     log_setting("Renderer_PostProcessingShader", values.pp_shader_name.GetValue());
     log_setting("Renderer_FilterMode", values.filter_mode.GetValue());
     log_setting("Renderer_TextureFilter", GetTextureFilterName(values.texture_filter.GetValue()));
+    log_setting("Renderer_SurfaceCacheBudget", values.surface_cache_budget.GetValue());
+    log_setting("Renderer_AsyncGpu", values.async_gpu.GetValue());
     log_setting("Stereoscopy_Render3d", values.render_3d.GetValue());
     log_setting("Stereoscopy_Factor3d", values.factor_3d.GetValue());
     log_setting("Stereoscopy_MonoRenderOption", values.mono_render_option.GetValue());
@@ -105,6 +113,7 @@ void LogSettings() {
     log_setting("Audio_InputType", values.input_type.GetValue());
     log_setting("Audio_InputDevice", values.input_device.GetValue());
     log_setting("Audio_EnableAudioStretching", values.enable_audio_stretching.GetValue());
+    log_setting("Audio_ParallelAudioSources", values.parallel_audio_sources.GetValue());
     using namespace Service::CAM;
     log_setting("Camera_OuterRightName", values.camera_name[OuterRightCamera]);
     log_setting("Camera_OuterRightConfig", values.camera_config[OuterRightCamera]);
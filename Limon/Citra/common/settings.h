@@ -417,7 +417,13 @@ struct Values {
 
     // Core
     Setting<bool> use_cpu_jit{true, "use_cpu_jit"};
+    Setting<bool> multithreaded_cpu{false, "multithreaded_cpu"};
+    Setting<bool> deterministic_cpu{false, "deterministic_cpu"};
     SwitchableSetting<s32, true> cpu_clock_percentage{100, 5, 400, "cpu_clock_percentage"};
+    Setting<bool> enable_rewind{false, "enable_rewind"};
+    Setting<u32> rewind_memory_budget{256, "rewind_memory_budget"};
+    Setting<u32> rewind_keyframe_interval{5, "rewind_keyframe_interval"};
+    Setting<u32> rewind_frame_interval{6, "rewind_frame_interval"};
     SwitchableSetting<bool> is_new_3ds{true, "is_new_3ds"};
 
     // Data Storage
@@ -448,6 +454,8 @@ struct Values {
     SwitchableSetting<u32, true> resolution_factor{1, 0, 10, "resolution_factor"};
     SwitchableSetting<u16, true> frame_limit{100, 0, 1000, "frame_limit"};
     SwitchableSetting<TextureFilter> texture_filter{TextureFilter::None, "texture_filter"};
+    Setting<u32> surface_cache_budget{1024, "surface_cache_budget"};
+    Setting<bool> async_gpu{false, "async_gpu"};
 
     SwitchableSetting<LayoutOption> layout_option{LayoutOption::Default, "layout_option"};
     SwitchableSetting<bool> swap_screen{false, "swap_screen"};
@@ -491,6 +499,7 @@ struct Values {
     bool audio_muted;
     SwitchableSetting<AudioEmulation> audio_emulation{AudioEmulation::HLE, "audio_emulation"};
     SwitchableSetting<bool> enable_audio_stretching{true, "enable_audio_stretching"};
+    Setting<bool> parallel_audio_sources{true, "parallel_audio_sources"};
     SwitchableSetting<float, true> volume{1.f, 0.f, 1.f, "volume"};
     Setting<AudioCore::SinkType> output_type{AudioCore::SinkType::Auto, "output_type"};
     Setting<std::string> output_device{"auto", "output_device"};
@@ -3,9 +3,15 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <deque>
+#include <future>
+#include <memory>
+#include <thread>
 #include <zstd.h>
 
+#include "common/file_util.h"
 #include "common/logging/log.h"
+#include "common/thread_worker.h"
 #include "common/zstd_compression.h"
 
 namespace Common::Compression {
@@ -38,6 +44,133 @@ std::vector<u8> CompressDataZSTDDefault(std::span<const u8> source) {
     return CompressDataZSTD(source, ZSTD_CLEVEL_DEFAULT);
 }
 
+bool CompressDataZSTDStream(std::span<const std::span<const u8>> sources, s32 compression_level,
+                            const std::function<bool(std::span<const u8>)>& sink,
+                            const std::function<void(std::size_t)>& progress) {
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx{ZSTD_createCCtx(), ZSTD_freeCCtx};
+    if (!cctx) {
+        LOG_ERROR(Common, "Error creating ZSTD compression context");
+        return false;
+    }
+
+    std::size_t total_size = 0;
+    for (const auto& source : sources) {
+        total_size += source.size();
+    }
+
+    // Pledging the size stores it in the frame header, which DecompressDataZSTD relies on.
+    compression_level = std::clamp(compression_level, ZSTD_minCLevel(), ZSTD_maxCLevel());
+    ZSTD_CCtx_setParameter(cctx.get(), ZSTD_c_compressionLevel, compression_level);
+    ZSTD_CCtx_setPledgedSrcSize(cctx.get(), total_size);
+
+    std::vector<u8> out_buffer(ZSTD_CStreamOutSize());
+    const auto compress = [&](ZSTD_inBuffer& input, ZSTD_EndDirective mode) {
+        std::size_t remaining;
+        do {
+            ZSTD_outBuffer output{out_buffer.data(), out_buffer.size(), 0};
+            remaining = ZSTD_compressStream2(cctx.get(), &output, &input, mode);
+            if (ZSTD_isError(remaining)) {
+                LOG_ERROR(Common, "Error compressing ZSTD data: {} ({})",
+                          ZSTD_getErrorName(remaining), remaining);
+                return false;
+            }
+            if (output.pos != 0 && !sink(std::span<const u8>{out_buffer.data(), output.pos})) {
+                return false;
+            }
+        } while (mode == ZSTD_e_end ? remaining != 0 : input.pos != input.size);
+        return true;
+    };
+
+    std::size_t consumed = 0;
+    for (const auto& source : sources) {
+        ZSTD_inBuffer input{source.data(), source.size(), 0};
+        if (!compress(input, ZSTD_e_continue)) {
+            return false;
+        }
+        consumed += source.size();
+        if (progress) {
+            progress(consumed);
+        }
+    }
+    ZSTD_inBuffer input{nullptr, 0, 0};
+    return compress(input, ZSTD_e_end);
+}
+
+bool CompressDataZSTDStreamDefault(std::span<const std::span<const u8>> sources,
+                                   const std::function<bool(std::span<const u8>)>& sink,
+                                   const std::function<void(std::size_t)>& progress) {
+    return CompressDataZSTDStream(sources, ZSTD_CLEVEL_DEFAULT, sink, progress);
+}
+
+static std::size_t NumCompressionThreads() {
+    return std::max(1U, std::thread::hardware_concurrency());
+}
+
+bool CompressDataZSTDFrames(std::span<const std::span<const u8>> sources, s32 compression_level,
+                            std::size_t frame_size,
+                            const std::function<bool(std::span<const u8>)>& sink,
+                            const std::function<void(std::size_t)>& progress) {
+    std::size_t total_size = 0;
+    for (const auto& source : sources) {
+        total_size += source.size();
+    }
+    const std::size_t num_frames =
+        std::max<std::size_t>(1, (total_size + frame_size - 1) / frame_size);
+
+    // Declared before the workers so that they are still alive while the workers shut down
+    std::vector<std::vector<u8>> frames(num_frames);
+    std::vector<std::future<bool>> results;
+    results.reserve(num_frames);
+    Common::ThreadWorker workers(NumCompressionThreads(), "ZSTDCompress");
+
+    auto source = sources.begin();
+    std::size_t source_offset = 0;
+    for (std::size_t i = 0; i < num_frames; ++i) {
+        // Gather the pieces of the sources that make up this frame
+        std::vector<std::span<const u8>> parts;
+        std::size_t remaining = std::min(frame_size, total_size - i * frame_size);
+        while (remaining != 0) {
+            const std::size_t size = std::min(remaining, source->size() - source_offset);
+            parts.push_back(source->subspan(source_offset, size));
+            remaining -= size;
+            source_offset += size;
+            if (source_offset == source->size()) {
+                ++source;
+                source_offset = 0;
+            }
+        }
+
+        std::promise<bool> promise;
+        results.push_back(promise.get_future());
+        workers.QueueWork([&frame = frames[i], parts = std::move(parts), compression_level,
+                           promise = std::move(promise)]() mutable {
+            promise.set_value(CompressDataZSTDStream(
+                parts, compression_level, [&frame](std::span<const u8> compressed) {
+                    frame.insert(frame.end(), compressed.begin(), compressed.end());
+                    return true;
+                }));
+        });
+    }
+
+    for (std::size_t i = 0; i < num_frames; ++i) {
+        if (!results[i].get() || !sink(frames[i])) {
+            return false;
+        }
+        std::vector<u8>().swap(frames[i]);
+        if (progress) {
+            progress(std::min(total_size, (i + 1) * frame_size));
+        }
+    }
+    return true;
+}
+
+bool CompressDataZSTDFramesDefault(std::span<const std::span<const u8>> sources,
+                                   std::size_t frame_size,
+                                   const std::function<bool(std::span<const u8>)>& sink,
+                                   const std::function<void(std::size_t)>& progress) {
+    return CompressDataZSTDFrames(sources, ZSTD_CLEVEL_DEFAULT, frame_size, sink, progress);
+}
+
 std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed) {
     const std::size_t decompressed_size =
         ZSTD_getFrameContentSize(compressed.data(), compressed.size());
@@ -70,4 +203,244 @@ std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed) {
     return decompressed;
 }
 
+struct ZSTDDecompressStreamBuf::Impl {
+    struct PendingFrame {
+        std::size_t index;
+        std::vector<u8> compressed;
+        std::vector<u8> decompressed;
+        std::future<bool> result;
+    };
+
+    Impl(FileUtil::IOFile& file_, std::vector<ZSTDFrameInfo> frames_)
+        : file{file_}, data_begin{file_.Tell()}, frames{std::move(frames_)} {
+        if (frames.empty()) {
+            dctx.reset(ZSTD_createDCtx());
+            in_buffer.resize(ZSTD_DStreamInSize());
+            out_buffer.resize(ZSTD_DStreamOutSize());
+            if (!dctx) {
+                LOG_ERROR(Common, "Error creating ZSTD decompression context");
+                error = true;
+            }
+            return;
+        }
+
+        frame_offsets.reserve(frames.size() + 1);
+        position_offsets.reserve(frames.size() + 1);
+        u64 frame_offset = 0;
+        u64 position_offset = 0;
+        for (const auto& frame : frames) {
+            frame_offsets.push_back(frame_offset);
+            position_offsets.push_back(position_offset);
+            frame_offset += frame.compressed_size;
+            position_offset += frame.decompressed_size;
+        }
+        frame_offsets.push_back(frame_offset);
+        position_offsets.push_back(position_offset);
+        workers = std::make_unique<Common::ThreadWorker>(NumCompressionThreads(),
+                                                         "ZSTDDecompress");
+    }
+
+    /// Reads and queues frames for decompression until enough are in flight.
+    void QueueFrames() {
+        const std::size_t read_ahead = workers->NumWorkers() * 2;
+        while (pending.size() < read_ahead && next_frame < frames.size()) {
+            auto frame = std::make_unique<PendingFrame>();
+            frame->index = next_frame;
+            frame->compressed.resize(frames[next_frame].compressed_size);
+            frame->decompressed.resize(frames[next_frame].decompressed_size);
+            if (!file.Seek(data_begin + frame_offsets[next_frame], SEEK_SET) ||
+                file.ReadBytes(frame->compressed.data(), frame->compressed.size()) !=
+                    frame->compressed.size()) {
+                LOG_ERROR(Common, "Could not read ZSTD frame {}", next_frame);
+                error = true;
+                return;
+            }
+
+            std::promise<bool> promise;
+            frame->result = promise.get_future();
+            workers->QueueWork([frame = frame.get(), promise = std::move(promise)]() mutable {
+                const std::size_t result =
+                    ZSTD_decompress(frame->decompressed.data(), frame->decompressed.size(),
+                                    frame->compressed.data(), frame->compressed.size());
+                if (ZSTD_isError(result)) {
+                    LOG_ERROR(Common, "Error decompressing ZSTD frame {}: {}", frame->index,
+                              ZSTD_getErrorName(result));
+                }
+                std::vector<u8>().swap(frame->compressed);
+                promise.set_value(result == frame->decompressed.size());
+            });
+            pending.push_back(std::move(frame));
+            ++next_frame;
+        }
+    }
+
+    /// Drops all frames read ahead, waiting for the workers that are still decompressing them.
+    void DropPending() {
+        for (auto& frame : pending) {
+            frame->result.wait();
+        }
+        pending.clear();
+        current.reset();
+    }
+
+    FileUtil::IOFile& file;
+    const u64 data_begin;
+    bool error = false;
+
+    // Sequential decompression
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx{nullptr, ZSTD_freeDCtx};
+    std::vector<u8> in_buffer;
+    std::vector<u8> out_buffer;
+    ZSTD_inBuffer input{};
+    std::size_t last_result = 0;
+    u64 buffer_position = 0; ///< Decompressed position of the start of the get area
+
+    // Decompression of indexed frames
+    std::vector<ZSTDFrameInfo> frames;
+    std::vector<u64> frame_offsets;    ///< Compressed offset of each frame, plus the end
+    std::vector<u64> position_offsets; ///< Decompressed offset of each frame, plus the end
+    std::size_t next_frame = 0;
+    std::deque<std::unique_ptr<PendingFrame>> pending;
+    std::unique_ptr<PendingFrame> current;
+    // Destroyed first, the frames above must outlive any work in progress
+    std::unique_ptr<Common::ThreadWorker> workers;
+};
+
+ZSTDDecompressStreamBuf::ZSTDDecompressStreamBuf(FileUtil::IOFile& file,
+                                                 std::vector<ZSTDFrameInfo> frames)
+    : impl{std::make_unique<Impl>(file, std::move(frames))} {}
+
+ZSTDDecompressStreamBuf::~ZSTDDecompressStreamBuf() = default;
+
+bool ZSTDDecompressStreamBuf::HasError() const {
+    return impl->error;
+}
+
+ZSTDDecompressStreamBuf::int_type ZSTDDecompressStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    if (impl->error) {
+        return traits_type::eof();
+    }
+
+    if (impl->frames.empty()) {
+        impl->buffer_position += egptr() - eback();
+        setg(nullptr, nullptr, nullptr);
+        while (true) {
+            if (impl->input.pos == impl->input.size) {
+                const std::size_t read =
+                    impl->file.ReadBytes(impl->in_buffer.data(), impl->in_buffer.size());
+                if (read == 0) {
+                    if (impl->last_result != 0) {
+                        LOG_ERROR(Common, "ZSTD data ends in the middle of a frame");
+                        impl->error = true;
+                    }
+                    return traits_type::eof();
+                }
+                impl->input = {impl->in_buffer.data(), read, 0};
+            }
+
+            ZSTD_outBuffer output{impl->out_buffer.data(), impl->out_buffer.size(), 0};
+            impl->last_result = ZSTD_decompressStream(impl->dctx.get(), &output, &impl->input);
+            if (ZSTD_isError(impl->last_result)) {
+                LOG_ERROR(Common, "Error decompressing ZSTD data: {} ({})",
+                          ZSTD_getErrorName(impl->last_result), impl->last_result);
+                impl->error = true;
+                return traits_type::eof();
+            }
+            if (output.pos != 0) {
+                const auto data = reinterpret_cast<char*>(impl->out_buffer.data());
+                setg(data, data, data + output.pos);
+                return traits_type::to_int_type(*gptr());
+            }
+        }
+    }
+
+    impl->current.reset();
+    setg(nullptr, nullptr, nullptr);
+    impl->QueueFrames();
+    if (impl->pending.empty()) {
+        return traits_type::eof();
+    }
+    impl->current = std::move(impl->pending.front());
+    impl->pending.pop_front();
+    if (!impl->current->result.get()) {
+        impl->error = true;
+        return traits_type::eof();
+    }
+    // Keep the workers busy while this frame is being consumed
+    impl->QueueFrames();
+
+    const auto data = reinterpret_cast<char*>(impl->current->decompressed.data());
+    setg(data, data, data + impl->current->decompressed.size());
+    return gptr() < egptr() ? traits_type::to_int_type(*gptr()) : underflow();
+}
+
+ZSTDDecompressStreamBuf::pos_type ZSTDDecompressStreamBuf::seekoff(off_type off,
+                                                                 std::ios_base::seekdir dir,
+                                                                 std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in)) {
+        return pos_type(off_type(-1));
+    }
+
+    u64 position;
+    if (impl->frames.empty()) {
+        position = impl->buffer_position + (gptr() - eback());
+    } else if (impl->current) {
+        position = impl->position_offsets[impl->current->index] + (gptr() - eback());
+    } else {
+        position = impl->position_offsets[impl->next_frame - impl->pending.size()];
+    }
+
+    if (dir == std::ios_base::cur && off == 0) {
+        return pos_type(static_cast<off_type>(position));
+    }
+    switch (dir) {
+    case std::ios_base::beg:
+        return seekpos(pos_type(off), which);
+    case std::ios_base::cur:
+        return seekpos(pos_type(static_cast<off_type>(position) + off), which);
+    case std::ios_base::end:
+        if (impl->frames.empty()) {
+            return pos_type(off_type(-1));
+        }
+        return seekpos(pos_type(static_cast<off_type>(impl->position_offsets.back()) + off),
+                       which);
+    default:
+        return pos_type(off_type(-1));
+    }
+}
+
+ZSTDDecompressStreamBuf::pos_type ZSTDDecompressStreamBuf::seekpos(pos_type pos,
+                                                                 std::ios_base::openmode which) {
+    // Sequential streams can't seek, and seeking past the end is not supported either
+    const off_type target = pos;
+    if (!(which & std::ios_base::in) || impl->frames.empty() || impl->error || target < 0 ||
+        static_cast<u64>(target) > impl->position_offsets.back()) {
+        return pos_type(off_type(-1));
+    }
+
+    const auto it = std::upper_bound(impl->position_offsets.begin(),
+                                     impl->position_offsets.end() - 1, static_cast<u64>(target));
+    const std::size_t index = std::distance(impl->position_offsets.begin(), it) - 1;
+    const off_type frame_offset = target - static_cast<off_type>(impl->position_offsets[index]);
+
+    if (!impl->current || impl->current->index != index) {
+        if (impl->pending.empty() || impl->pending.front()->index != index) {
+            impl->DropPending();
+            impl->next_frame = index;
+        }
+        impl->current.reset();
+        setg(nullptr, nullptr, nullptr);
+        if (traits_type::eq_int_type(underflow(), traits_type::eof()) && frame_offset != 0) {
+            return pos_type(off_type(-1));
+        }
+    }
+    if (eback() != nullptr) {
+        setg(eback(), eback() + frame_offset, egptr());
+    }
+    return pos;
+}
+
 } // namespace Common::Compression
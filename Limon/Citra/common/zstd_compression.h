@@ -4,11 +4,18 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <span>
+#include <streambuf>
 #include <vector>
 
 #include "common/common_types.h"
 
+namespace FileUtil {
+class IOFile;
+}
+
 namespace Common::Compression {
 
 /**
@@ -31,6 +38,73 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> CompressDataZSTDDefault(std::span<const u8> source);
 
+/**
+ * Compresses a sequence of source memory regions with Zstandard into a single frame, as if they
+ * were one contiguous region, handing the compressed output to a sink as it is produced. The
+ * result can be decompressed with DecompressDataZSTD.
+ *
+ * @param sources the uncompressed source memory regions, in order.
+ * @param compression_level the used compression level. Should be between 1 and 22.
+ * @param sink receives each piece of compressed output. Returning false aborts the compression.
+ * @param progress if set, called with the number of source bytes consumed after each region.
+ *
+ * @return true if all sources were compressed and accepted by the sink.
+ */
+[[nodiscard]] bool CompressDataZSTDStream(std::span<const std::span<const u8>> sources,
+                                          s32 compression_level,
+                                          const std::function<bool(std::span<const u8>)>& sink,
+                                          const std::function<void(std::size_t)>& progress = {});
+
+/**
+ * Compresses a sequence of source memory regions with Zstandard with the default compression level
+ * into a single frame, handing the compressed output to a sink as it is produced.
+ *
+ * @param sources the uncompressed source memory regions, in order.
+ * @param sink receives each piece of compressed output. Returning false aborts the compression.
+ * @param progress if set, called with the number of source bytes consumed after each region.
+ *
+ * @return true if all sources were compressed and accepted by the sink.
+ */
+[[nodiscard]] bool CompressDataZSTDStreamDefault(
+    std::span<const std::span<const u8>> sources,
+    const std::function<bool(std::span<const u8>)>& sink,
+    const std::function<void(std::size_t)>& progress = {});
+
+/**
+ * Compresses a sequence of source memory regions with Zstandard into independent frames holding
+ * frame_size uncompressed bytes each (the last one may be shorter). Frames are compressed on
+ * several worker threads and handed to the sink in order, one call per frame, so each one can be
+ * located and decompressed on its own later on.
+ *
+ * @param sources the uncompressed source memory regions, in order.
+ * @param compression_level the used compression level. Should be between 1 and 22.
+ * @param frame_size the uncompressed size of each frame.
+ * @param sink receives each compressed frame. Returning false aborts the compression.
+ * @param progress if set, called with the number of source bytes consumed after each frame.
+ *
+ * @return true if all frames were compressed and accepted by the sink.
+ */
+[[nodiscard]] bool CompressDataZSTDFrames(std::span<const std::span<const u8>> sources,
+                                          s32 compression_level, std::size_t frame_size,
+                                          const std::function<bool(std::span<const u8>)>& sink,
+                                          const std::function<void(std::size_t)>& progress = {});
+
+/**
+ * Compresses a sequence of source memory regions with Zstandard with the default compression level
+ * into independent frames of frame_size uncompressed bytes, compressed on several worker threads.
+ *
+ * @param sources the uncompressed source memory regions, in order.
+ * @param frame_size the uncompressed size of each frame.
+ * @param sink receives each compressed frame. Returning false aborts the compression.
+ * @param progress if set, called with the number of source bytes consumed after each frame.
+ *
+ * @return true if all frames were compressed and accepted by the sink.
+ */
+[[nodiscard]] bool CompressDataZSTDFramesDefault(
+    std::span<const std::span<const u8>> sources, std::size_t frame_size,
+    const std::function<bool(std::span<const u8>)>& sink,
+    const std::function<void(std::size_t)>& progress = {});
+
 /**
  * Decompresses a source memory region with Zstandard and returns the uncompressed data in a vector.
  *
@@ -40,4 +114,45 @@ namespace Common::Compression {
  */
 [[nodiscard]] std::vector<u8> DecompressDataZSTD(std::span<const u8> compressed);
 
+/// Location of a frame written by CompressDataZSTDFrames.
+struct ZSTDFrameInfo {
+    u64 compressed_size;
+    u64 decompressed_size;
+};
+
+/**
+ * Input stream buffer decompressing Zstandard data from a file while it is being read, so that
+ * neither the compressed nor the decompressed data has to be held in memory as a whole.
+ *
+ * Without a frame table the file is decompressed sequentially and may contain any sequence of
+ * frames. With the table of frames written by CompressDataZSTDFrames, the frames following the one
+ * being read are decompressed ahead on worker threads and the stream supports seeking.
+ */
+class ZSTDDecompressStreamBuf final : public std::streambuf {
+public:
+    /**
+     * @param file the file to read from, positioned at the first frame. It must outlive the buffer.
+     * @param frames the frame table, or empty to decompress sequentially.
+     */
+    explicit ZSTDDecompressStreamBuf(FileUtil::IOFile& file,
+                                     std::vector<ZSTDFrameInfo> frames = {});
+    ~ZSTDDecompressStreamBuf() override;
+
+    ZSTDDecompressStreamBuf(const ZSTDDecompressStreamBuf&) = delete;
+    ZSTDDecompressStreamBuf& operator=(const ZSTDDecompressStreamBuf&) = delete;
+
+    /// Returns true if reading stopped because of a read or decompression error.
+    [[nodiscard]] bool HasError() const;
+
+protected:
+    int_type underflow() override;
+    pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                     std::ios_base::openmode which) override;
+    pos_type seekpos(pos_type pos, std::ios_base::openmode which) override;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl;
+};
+
 } // namespace Common::Compression
@@ -6,6 +6,7 @@
 #include <dynarmic/interface/A32/a32.h>
 #include <dynarmic/interface/optimization_flags.h>
 #include "common/assert.h"
+#include "common/atomic_ops.h"
 #include "common/microprofile.h"
 #include "core/arm/dynarmic/arm_dynarmic.h"
 #include "core/arm/dynarmic/arm_dynarmic_cp15.h"
@@ -80,42 +81,46 @@ public:
     ~DynarmicUserCallbacks() = default;
 
     std::uint8_t MemoryRead8(VAddr vaddr) override {
-        return memory.Read8(vaddr);
+        return Read<u8>(vaddr, [&] { return memory.Read8(vaddr); });
     }
     std::uint16_t MemoryRead16(VAddr vaddr) override {
-        return memory.Read16(vaddr);
+        return Read<u16>(vaddr, [&] { return memory.Read16(vaddr); });
     }
     std::uint32_t MemoryRead32(VAddr vaddr) override {
-        return memory.Read32(vaddr);
+        return Read<u32>(vaddr, [&] { return memory.Read32(vaddr); });
     }
     std::uint64_t MemoryRead64(VAddr vaddr) override {
-        return memory.Read64(vaddr);
+        return Read<u64>(vaddr, [&] { return memory.Read64(vaddr); });
     }
 
     void MemoryWrite8(VAddr vaddr, std::uint8_t value) override {
-        memory.Write8(vaddr, value);
+        Write<u8>(vaddr, value, [&] { memory.Write8(vaddr, value); });
     }
     void MemoryWrite16(VAddr vaddr, std::uint16_t value) override {
-        memory.Write16(vaddr, value);
+        Write<u16>(vaddr, value, [&] { memory.Write16(vaddr, value); });
     }
     void MemoryWrite32(VAddr vaddr, std::uint32_t value) override {
-        memory.Write32(vaddr, value);
+        Write<u32>(vaddr, value, [&] { memory.Write32(vaddr, value); });
     }
     void MemoryWrite64(VAddr vaddr, std::uint64_t value) override {
-        memory.Write64(vaddr, value);
+        Write<u64>(vaddr, value, [&] { memory.Write64(vaddr, value); });
     }
 
     bool MemoryWriteExclusive8(u32 vaddr, u8 value, u8 expected) override {
-        return memory.WriteExclusive8(vaddr, value, expected);
+        return WriteExclusive<u8>(vaddr, value, expected,
+                                  [&] { return memory.WriteExclusive8(vaddr, value, expected); });
     }
     bool MemoryWriteExclusive16(u32 vaddr, u16 value, u16 expected) override {
-        return memory.WriteExclusive16(vaddr, value, expected);
+        return WriteExclusive<u16>(vaddr, value, expected,
+                                   [&] { return memory.WriteExclusive16(vaddr, value, expected); });
     }
     bool MemoryWriteExclusive32(u32 vaddr, u32 value, u32 expected) override {
-        return memory.WriteExclusive32(vaddr, value, expected);
+        return WriteExclusive<u32>(vaddr, value, expected,
+                                   [&] { return memory.WriteExclusive32(vaddr, value, expected); });
     }
     bool MemoryWriteExclusive64(u32 vaddr, u64 value, u64 expected) override {
-        return memory.WriteExclusive64(vaddr, value, expected);
+        return WriteExclusive<u64>(vaddr, value, expected,
+                                   [&] { return memory.WriteExclusive64(vaddr, value, expected); });
     }
 
     void InterpreterFallback(VAddr pc, std::size_t num_instructions) override {
@@ -125,6 +130,8 @@ public:
     }
 
     void CallSVC(std::uint32_t swi) override {
+        const auto lock = parent.system.LockHLE(parent);
+        CheckPageTable();
         svc_context.CallSVC(swi);
     }
 
@@ -168,6 +175,68 @@ public:
         return Core::TicksForInstruction(is_thumb, instruction);
     }
 
+    /**
+     * Returns the host pointer of an access through the page table of this core, or nullptr if the
+     * access has to take the slow path. The memory system only tracks the page table of a single
+     * core, which with the cores on separate host threads isn't necessarily this one.
+     */
+    template <typename T>
+    [[nodiscard]] u8* GetFastPointer(VAddr vaddr) const {
+        if ((vaddr & CITRA_PAGE_MASK) + sizeof(T) > CITRA_PAGE_SIZE) {
+            return nullptr;
+        }
+        u8* const page_pointer = parent.current_page_table->pointers[vaddr >> CITRA_PAGE_BITS];
+        return page_pointer ? page_pointer + (vaddr & CITRA_PAGE_MASK) : nullptr;
+    }
+
+    /**
+     * Accesses to pages without a host pointer end up in MMIO handlers or flush the rasterizer
+     * cache, both shared between the cores, so they are serialised like HLE code. Holding the HLE
+     * lock makes this core the running one, so the memory system then uses its page table.
+     */
+    [[nodiscard]] Core::System::HLELock LockSlowPath() {
+        return parent.system.LockHLE(parent);
+    }
+
+    /// Checks that the memory system accesses memory through the page table of this core.
+    void CheckPageTable() const {
+        ASSERT(memory.GetCurrentPageTable() == parent.current_page_table);
+    }
+
+    template <typename T, typename SlowPath>
+    T Read(VAddr vaddr, SlowPath&& slow_path) {
+        if (const u8* pointer = GetFastPointer<T>(vaddr)) {
+            T value;
+            std::memcpy(&value, pointer, sizeof(T));
+            return value;
+        }
+        const auto lock = LockSlowPath();
+        CheckPageTable();
+        return slow_path();
+    }
+
+    template <typename T, typename SlowPath>
+    void Write(VAddr vaddr, T value, SlowPath&& slow_path) {
+        if (u8* pointer = GetFastPointer<T>(vaddr)) {
+            std::memcpy(pointer, &value, sizeof(T));
+            return;
+        }
+        const auto lock = LockSlowPath();
+        CheckPageTable();
+        slow_path();
+    }
+
+    template <typename T, typename SlowPath>
+    bool WriteExclusive(VAddr vaddr, T value, T expected, SlowPath&& slow_path) {
+        if (u8* pointer = GetFastPointer<T>(vaddr)) {
+            return Common::AtomicCompareAndSwap(reinterpret_cast<volatile T*>(pointer), value,
+                                                expected);
+        }
+        const auto lock = LockSlowPath();
+        CheckPageTable();
+        return slow_path();
+    }
+
     ARM_Dynarmic& parent;
     Kernel::SVCContext svc_context;
     Memory::MemorySystem& memory;
@@ -187,7 +256,9 @@ ARM_Dynarmic::~ARM_Dynarmic() = default;
 MICROPROFILE_DEFINE(ARM_Jit, "ARM JIT", "ARM JIT", MP_RGB(255, 64, 64));
 
 void ARM_Dynarmic::Run() {
-    ASSERT(memory.GetCurrentPageTable() == current_page_table);
+    // With the cores on separate host threads the memory system only tracks the page table of the
+    // core holding the HLE lock, the callbacks check it there instead.
+    ASSERT(system.IsCoreThreaded() || memory.GetCurrentPageTable() == current_page_table);
     MICROPROFILE_SCOPE(ARM_Jit);
 
     jit->Run();
@@ -87,12 +87,11 @@ void ARM_DynCom::Step() {
 }
 
 void ARM_DynCom::ClearInstructionCache() {
-    state->instruction_cache.clear();
-    trans_cache_buf_top = 0;
+    state->translation_cache.Clear();
 }
 
-void ARM_DynCom::InvalidateCacheRange(u32, std::size_t) {
-    ClearInstructionCache();
+void ARM_DynCom::InvalidateCacheRange(u32 start_address, std::size_t length) {
+    state->translation_cache.InvalidateRange(start_address, length);
 }
 
 void ARM_DynCom::SetPageTable(const std::shared_ptr<Memory::PageTable>& page_table) {
@@ -0,0 +1,161 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/alignment.h"
+#include "common/assert.h"
+#include "core/arm/dyncom/arm_dyncom_cache.h"
+
+namespace {
+
+constexpr u32 PAGE_BITS = 12;
+constexpr u32 PAGE_SIZE = 1U << PAGE_BITS;
+
+/// Upper bound of the size of a translated instruction, the largest being about 48 bytes
+constexpr std::size_t MAX_INSTRUCTION_SIZE = 128;
+
+/**
+ * Upper bound of the size of a translated block. Blocks end at the end of a page, or of the next
+ * one when a Thumb instruction straddles the page boundary.
+ */
+constexpr std::size_t MAX_BLOCK_SIZE =
+    sizeof(TranslatedBlock) + (PAGE_SIZE + 1) * MAX_INSTRUCTION_SIZE;
+
+/// Cache of the block being translated on this thread
+thread_local TranslationCache* translating_cache = nullptr;
+
+} // Anonymous namespace
+
+TranslationCache::TranslationCache() = default;
+TranslationCache::~TranslationCache() = default;
+
+TranslatedBlock* TranslationCache::BeginBlock(u32 address) {
+    static_assert(MAX_BLOCK_SIZE <= REGION_SIZE);
+    region_top = Common::AlignUp(region_top, alignof(TranslatedBlock));
+    if (num_regions == 0 || region_top + MAX_BLOCK_SIZE > REGION_SIZE) {
+        NextRegion();
+    }
+
+    auto* block = reinterpret_cast<TranslatedBlock*>(regions[current_region].get() + region_top);
+    *block = {
+        .start = address,
+        .end = address,
+        .link = nullptr,
+        .link_address = 0,
+        .link_generation = 0,
+    };
+    region_top += sizeof(TranslatedBlock);
+    translating_cache = this;
+    return block;
+}
+
+void TranslationCache::EndBlock(TranslatedBlock* block, u32 end) {
+    ASSERT(translating_cache == this && end > block->start);
+    translating_cache = nullptr;
+    block->end = end;
+
+    if (TranslatedBlock* const previous = Find(block->start)) {
+        Erase(previous);
+    }
+    blocks.emplace(block->start, block);
+    region_blocks[current_region].push_back(block);
+    for (u32 page = block->start >> PAGE_BITS; page <= (end - 1) >> PAGE_BITS; ++page) {
+        page_blocks[page].push_back(block);
+    }
+}
+
+void* TranslationCache::AllocateInstruction(std::size_t size) {
+    TranslationCache* const cache = translating_cache;
+    ASSERT_MSG(cache != nullptr, "Instruction translated outside of a block");
+    ASSERT_MSG(cache->region_top + size <= REGION_SIZE, "Translated block is too large!");
+    void* const instruction = cache->regions[cache->current_region].get() + cache->region_top;
+    cache->region_top += size;
+    return instruction;
+}
+
+void TranslationCache::InvalidateRange(u32 start_address, std::size_t length) {
+    if (length == 0) {
+        return;
+    }
+    const u64 end_address = u64{start_address} + length;
+    const u32 page_start = start_address >> PAGE_BITS;
+    const u32 page_end = static_cast<u32>((end_address - 1) >> PAGE_BITS);
+
+    // Blocks spanning two pages may be collected twice, erasing them again is harmless
+    std::vector<TranslatedBlock*> invalid_blocks;
+    const auto collect = [&](const std::vector<TranslatedBlock*>& page_list) {
+        for (TranslatedBlock* const block : page_list) {
+            if (block->start < end_address && start_address < block->end) {
+                invalid_blocks.push_back(block);
+            }
+        }
+    };
+    if (page_end - page_start >= page_blocks.size()) {
+        for (const auto& [page, page_list] : page_blocks) {
+            if (page >= page_start && page <= page_end) {
+                collect(page_list);
+            }
+        }
+    } else {
+        for (u32 page = page_start; page <= page_end; ++page) {
+            if (const auto iter = page_blocks.find(page); iter != page_blocks.end()) {
+                collect(iter->second);
+            }
+        }
+    }
+
+    if (invalid_blocks.empty()) {
+        return;
+    }
+    for (TranslatedBlock* const block : invalid_blocks) {
+        Erase(block);
+    }
+    ++generation;
+}
+
+void TranslationCache::Clear() {
+    // Regions are kept allocated, the code being executed may still be in one of them
+    blocks.clear();
+    page_blocks.clear();
+    for (auto& list : region_blocks) {
+        list.clear();
+    }
+    current_region = 0;
+    region_top = 0;
+    ++generation;
+}
+
+void TranslationCache::NextRegion() {
+    const std::size_t next = num_regions == 0 ? 0 : (current_region + 1) % MAX_REGIONS;
+    if (next >= num_regions) {
+        regions[next] = std::unique_ptr<char[]>(new char[REGION_SIZE]);
+        num_regions = next + 1;
+    } else if (!region_blocks[next].empty()) {
+        for (TranslatedBlock* const block : region_blocks[next]) {
+            Erase(block);
+        }
+        region_blocks[next].clear();
+        ++generation;
+    }
+    current_region = next;
+    region_top = 0;
+}
+
+void TranslationCache::Erase(TranslatedBlock* block) {
+    // A newer translation of the same address may have replaced it
+    const auto iter = blocks.find(block->start);
+    if (iter != blocks.end() && iter->second == block) {
+        blocks.erase(iter);
+    }
+    for (u32 page = block->start >> PAGE_BITS; page <= (block->end - 1) >> PAGE_BITS; ++page) {
+        const auto page_iter = page_blocks.find(page);
+        if (page_iter == page_blocks.end()) {
+            continue;
+        }
+        std::erase(page_iter->second, block);
+        if (page_iter->second.empty()) {
+            page_blocks.erase(page_iter);
+        }
+    }
+}
@@ -0,0 +1,109 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "common/common_types.h"
+
+/// Header of a translated basic block, followed in the translation cache by its instructions
+struct TranslatedBlock {
+    u32 start; ///< Guest address of the first instruction
+    u32 end;   ///< Guest address following the last instruction
+
+    /// Block most recently executed after this one, valid while the cache is at link_generation
+    TranslatedBlock* link;
+    u32 link_address;
+    u32 link_generation;
+
+    char* Instructions() {
+        return reinterpret_cast<char*>(this + 1);
+    }
+};
+
+/**
+ * Translation cache of a dyncom core. Translated blocks are allocated one after the other in
+ * regions of host memory, which are added as the cache fills up. Once all regions are in use, the
+ * oldest region is recycled and the blocks translated into it are evicted.
+ *
+ * Blocks can be dropped individually when the guest code they were translated from changes. Since
+ * blocks are linked to their successors, any eviction or invalidation moves the cache to a new
+ * generation, which unlinks all blocks.
+ */
+class TranslationCache {
+public:
+    TranslationCache();
+    ~TranslationCache();
+
+    TranslationCache(const TranslationCache&) = delete;
+    TranslationCache& operator=(const TranslationCache&) = delete;
+
+    /// Returns the block starting at the given address, or nullptr if it isn't translated.
+    TranslatedBlock* Find(u32 address) const {
+        const auto iter = blocks.find(address);
+        return iter != blocks.end() ? iter->second : nullptr;
+    }
+
+    /// Returns the block linked from the given block to address, or nullptr if there's none.
+    TranslatedBlock* FindLink(const TranslatedBlock* block, u32 address) const {
+        if (block->link_generation != generation || block->link_address != address) {
+            return nullptr;
+        }
+        return block->link;
+    }
+
+    /// Links the given block to its successor, so that the next branch to it skips the lookup.
+    void Link(TranslatedBlock* block, TranslatedBlock* next) {
+        block->link = next;
+        block->link_address = next->start;
+        block->link_generation = generation;
+    }
+
+    /**
+     * Starts translating a block at the given address. Until EndBlock is called,
+     * AllocateInstruction allocates the instructions of the block.
+     */
+    TranslatedBlock* BeginBlock(u32 address);
+
+    /// Finishes translating the block, whose last instruction ends at the given address.
+    void EndBlock(TranslatedBlock* block, u32 end);
+
+    /// Allocates memory for an instruction of the block being translated on the calling thread.
+    static void* AllocateInstruction(std::size_t size);
+
+    /// Drops the blocks translated from guest code overlapping the given range.
+    void InvalidateRange(u32 start_address, std::size_t length);
+
+    /// Drops all blocks.
+    void Clear();
+
+    /// Returns the current generation, which changes whenever a block is dropped.
+    [[nodiscard]] u32 Generation() const {
+        return generation;
+    }
+
+private:
+    static constexpr std::size_t REGION_SIZE = 4 * 1024 * 1024;
+    static constexpr std::size_t MAX_REGIONS = 8;
+
+    /// Moves to the next region, allocating it or recycling the oldest one.
+    void NextRegion();
+
+    /// Drops the block from the lookup and the page index.
+    void Erase(TranslatedBlock* block);
+
+    std::array<std::unique_ptr<char[]>, MAX_REGIONS> regions;
+    std::array<std::vector<TranslatedBlock*>, MAX_REGIONS> region_blocks;
+    std::size_t num_regions = 0;
+    std::size_t current_region = 0;
+    std::size_t region_top = 0;
+
+    std::unordered_map<u32, TranslatedBlock*> blocks;
+    std::unordered_map<u32, std::vector<TranslatedBlock*>> page_blocks; ///< Blocks in each page
+    u32 generation = 0;
+};
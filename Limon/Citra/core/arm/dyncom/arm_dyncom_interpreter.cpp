@@ -839,7 +839,7 @@ static unsigned int InterpreterTranslateInstruction(const ARMul_State* cpu, cons
     return inst_size;
 }
 
-static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+static int InterpreterTranslateBlock(ARMul_State* cpu, TranslatedBlock*& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     // Decode instruction, get index
@@ -848,10 +848,9 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
     // Save start addr of basicblock in CreamCache
     ARM_INST_PTR inst_base = nullptr;
     TransExtData ret = TransExtData::NON_BRANCH;
-    bb_start = trans_cache_buf_top;
+    block = cpu->translation_cache.BeginBlock(cpu->Reg[15]);
 
     u32 phys_addr = addr;
-    u32 pc_start = cpu->Reg[15];
 
     while (ret == TransExtData::NON_BRANCH) {
         u32 inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
@@ -863,27 +862,26 @@ static int InterpreterTranslateBlock(ARMul_State* cpu, std::size_t& bb_start, u3
         ret = inst_base->br;
     };
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->translation_cache.EndBlock(block, phys_addr);
 
     return KEEP_GOING;
 }
 
-static int InterpreterTranslateSingle(ARMul_State* cpu, std::size_t& bb_start, u32 addr) {
+static int InterpreterTranslateSingle(ARMul_State* cpu, TranslatedBlock*& block, u32 addr) {
     MICROPROFILE_SCOPE(DynCom_Decode);
 
     ARM_INST_PTR inst_base = nullptr;
-    bb_start = trans_cache_buf_top;
+    block = cpu->translation_cache.BeginBlock(cpu->Reg[15]);
 
     u32 phys_addr = addr;
-    u32 pc_start = cpu->Reg[15];
 
-    InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
+    const u32 inst_size = InterpreterTranslateInstruction(cpu, phys_addr, inst_base);
 
     if (inst_base->br == TransExtData::NON_BRANCH) {
         inst_base->br = TransExtData::SINGLE_STEP;
     }
 
-    cpu->instruction_cache[pc_start] = bb_start;
+    cpu->translation_cache.EndBlock(block, phys_addr + inst_size);
 
     return KEEP_GOING;
 }
@@ -943,7 +941,7 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
 #define FETCH_INST                                                                                 \
     if (inst_base->br != TransExtData::NON_BRANCH)                                                 \
         goto DISPATCH;                                                                             \
-    inst_base = (arm_inst*)&trans_cache_buf[ptr]
+    inst_base = (arm_inst*)ptr
 
 #define INC_PC(l) ptr += sizeof(arm_inst) + l
 #define INC_PC_STUB ptr += sizeof(arm_inst)
@@ -1624,7 +1622,9 @@ unsigned InterpreterMainLoop(ARMul_State* cpu) {
     unsigned int addr;
     unsigned int num_instrs = 0;
 
-    std::size_t ptr;
+    char* ptr;
+    TranslatedBlock* last_block = nullptr;
+    u32 last_generation = 0;
 
     LOAD_NZCVT;
 DISPATCH : {
@@ -1639,17 +1639,33 @@ DISPATCH : {
     else
         cpu->Reg[15] &= 0xfffffffc;
 
-    // Find the cached instruction cream, otherwise translate it...
-    auto itr = cpu->instruction_cache.find(cpu->Reg[15]);
-    if (itr != cpu->instruction_cache.end()) {
-        ptr = itr->second;
-    } else if (cpu->NumInstrsToExecute != 1) {
-        if (InterpreterTranslateBlock(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
-    } else {
-        if (InterpreterTranslateSingle(cpu, ptr, cpu->Reg[15]) == FETCH_EXCEPTION)
-            goto END;
+    // Follow the link from the previous block, otherwise find the cached instruction cream,
+    // otherwise translate it...
+    TranslationCache& cache = cpu->translation_cache;
+    TranslatedBlock* block = nullptr;
+    const bool can_link = last_block != nullptr && last_generation == cache.Generation();
+    if (can_link) {
+        block = cache.FindLink(last_block, cpu->Reg[15]);
+    }
+    if (block == nullptr) {
+        block = cache.Find(cpu->Reg[15]);
+    }
+    if (block == nullptr) {
+        if (cpu->NumInstrsToExecute != 1) {
+            if (InterpreterTranslateBlock(cpu, block, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        } else {
+            if (InterpreterTranslateSingle(cpu, block, cpu->Reg[15]) == FETCH_EXCEPTION)
+                goto END;
+        }
+    }
+    // Translating may have recycled the region of the previous block
+    if (can_link && last_generation == cache.Generation()) {
+        cache.Link(last_block, block);
     }
+    last_block = block;
+    last_generation = cache.Generation();
+    ptr = block->Instructions();
 
 #ifndef ANDROID
     // Find breakpoint if one exists within the block
@@ -1659,7 +1675,7 @@ DISPATCH : {
     }
 #endif
 
-    inst_base = (arm_inst*)&trans_cache_buf[ptr];
+    inst_base = (arm_inst*)ptr;
     GOTO_NEXT_INST;
 }
 ADC_INST : {
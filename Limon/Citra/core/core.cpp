@@ -11,6 +11,7 @@
 #include "common/arch.h"
 #include "common/logging/log.h"
 #include "common/settings.h"
+#include "common/thread_worker.h"
 #include "core/arm/arm_interface.h"
 #include "core/arm/exclusive_monitor.h"
 #include "core/hle/service/cam/cam.h"
@@ -23,10 +24,12 @@
 #include "core/cheats/cheats.h"
 #include "core/core.h"
 #include "core/core_timing.h"
+#include "core/cpu_manager.h"
 #include "core/dumping/backend.h"
 #include "core/frontend/image_interface.h"
 #include "core/gdbstub/gdbstub.h"
 #include "core/global.h"
+#include "core/hle/kernel/hle_worker_pool.h"
 #include "core/hle/kernel/kernel.h"
 #include "core/hle/kernel/process.h"
 #include "core/hle/kernel/thread.h"
@@ -45,6 +48,7 @@
 #include "core/hw/lcd.h"
 #include "core/loader/loader.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #ifdef ENABLE_SCRIPTING
 #include "core/rpc/server.h"
 #endif
@@ -136,7 +140,7 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         LOG_INFO(Core, "Begin save to slot {}", slot);
         try {
             System::SaveState(slot);
-            LOG_INFO(Core, "Save completed");
+            LOG_INFO(Core, "Save snapshot taken, writing in the background");
         } catch (const std::exception& e) {
             LOG_ERROR(Core, "Error saving: {}", e.what());
             status_details = e.what();
@@ -145,10 +149,37 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
         frame_limiter.WaitOnce();
         return ResultStatus::Success;
     }
+    case Signal::Rewind: {
+        const u32 frames = param;
+        if (!rewind_buffer) {
+            LOG_WARNING(Core, "Rewind is not enabled");
+            return ResultStatus::Success;
+        }
+        try {
+            if (!rewind_buffer->StepBack(frames)) {
+                LOG_WARNING(Core, "No rewind states recorded yet");
+            }
+        } catch (const std::exception& e) {
+            LOG_ERROR(Core, "Error rewinding: {}", e.what());
+            status_details = e.what();
+            return ResultStatus::ErrorSavestate;
+        }
+        frame_limiter.WaitOnce();
+        return ResultStatus::Success;
+    }
     default:
         break;
     }
 
+    if (Settings::values.enable_rewind.GetValue()) {
+        if (!rewind_buffer) {
+            rewind_buffer = std::make_unique<RewindBuffer>(*this);
+        }
+        rewind_buffer->CaptureFrame();
+    } else if (rewind_buffer) {
+        rewind_buffer.reset();
+    }
+
     // All cores should have executed the same amount of ticks. If this is not the case an event was
     // scheduled with a cycles_into_future smaller then the current downcount.
     // So we have to get those cores to the same global time first
@@ -205,27 +236,33 @@ System::ResultStatus System::RunLoop(bool tight_loop) {
             kernel->GetThreadManager(cpu_core->GetID()).Reschedule();
             max_slice = std::min(max_slice, cpu_core->GetTimer().GetMaxSliceLength());
         }
-        for (auto& cpu_core : cpu_cores) {
-            cpu_core->GetTimer().SetNextSlice(max_slice);
-            auto start_ticks = cpu_core->GetTimer().GetTicks();
-            LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
-                      cpu_core->GetTimer().GetDowncount());
-            running_core = cpu_core.get();
-            kernel->SetRunningCPU(running_core);
-            // If we don't have a currently active thread then don't execute instructions,
-            // instead advance to the next event and try to yield to the next thread
-            if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
-                LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
-                cpu_core->GetTimer().Idle();
-                PrepareReschedule();
-            } else {
-                if (tight_loop) {
-                    cpu_core->Run();
+        const bool run_parallel =
+            cpu_manager && tight_loop && !GDBStub::IsServerEnabled() && !IsDeterministic();
+        if (run_parallel) {
+            RunCoresParallel(max_slice);
+        } else {
+            for (auto& cpu_core : cpu_cores) {
+                cpu_core->GetTimer().SetNextSlice(max_slice);
+                auto start_ticks = cpu_core->GetTimer().GetTicks();
+                LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                          cpu_core->GetTimer().GetDowncount());
+                running_core = cpu_core.get();
+                kernel->SetRunningCPU(running_core);
+                // If we don't have a currently active thread then don't execute instructions,
+                // instead advance to the next event and try to yield to the next thread
+                if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+                    LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+                    cpu_core->GetTimer().Idle();
+                    PrepareReschedule();
                 } else {
-                    cpu_core->Step();
+                    if (tight_loop) {
+                        cpu_core->Run();
+                    } else {
+                        cpu_core->Step();
+                    }
                 }
+                max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
             }
-            max_slice = cpu_core->GetTimer().GetTicks() - start_ticks;
         }
     }
 
@@ -342,6 +379,73 @@ System::ResultStatus System::Load(Frontend::EmuWindow& emu_window, const std::st
     return status;
 }
 
+bool System::IsDeterministic() const {
+    const auto play_mode = movie.GetPlayMode();
+    return Settings::values.deterministic_cpu.GetValue() ||
+           play_mode == Movie::PlayMode::Recording || play_mode == Movie::PlayMode::Playing;
+}
+
+void System::RunCoresParallel(s64 max_slice) {
+    u32 core_mask = 0;
+    for (auto& cpu_core : cpu_cores) {
+        cpu_core->GetTimer().SetNextSlice(max_slice);
+        LOG_TRACE(Core_ARM11, "Core {} running for {} ticks", cpu_core->GetID(),
+                  cpu_core->GetTimer().GetDowncount());
+        running_core = cpu_core.get();
+        kernel->SetRunningCPU(running_core);
+        if (kernel->GetCurrentThreadManager().GetCurrentThread() == nullptr) {
+            LOG_TRACE(Core_ARM11, "Core {} idling", cpu_core->GetID());
+            cpu_core->GetTimer().Idle();
+            PrepareReschedule();
+        } else {
+            core_mask |= 1U << cpu_core->GetID();
+        }
+    }
+    if (core_mask != 0) {
+        cpu_manager->RunSlice(core_mask);
+    }
+
+    // The cores ran concurrently, so each of them was given the whole slice. Account for it the
+    // way the serial path does, where every core only runs for the ticks the core before it ran.
+    // A core that ran past that owes the excess, which its next slices account without executing.
+    for (auto& cpu_core : cpu_cores) {
+        max_slice = cpu_core->GetTimer().LimitSlice(max_slice);
+    }
+}
+
+bool System::IsCoreThreaded() const {
+    return cpu_manager && cpu_manager->IsRunningSlice();
+}
+
+System::HLELock System::LockHLE(ARM_Interface& core) {
+    if (!IsCoreThreaded()) {
+        return {};
+    }
+    return HLELock{*this, core};
+}
+
+System::HLELock::HLELock(System& system_, ARM_Interface& core) : system{&system_} {
+    system->hle_lock.lock();
+    previous_core = system->running_core;
+    if (previous_core != &core) {
+        system->running_core = &core;
+        system->kernel->SetRunningCPU(&core);
+    }
+}
+
+System::HLELock::~HLELock() {
+    if (!system) {
+        return;
+    }
+    // Leave the core set up by RunCoresParallel as the running one, so that nothing outside of
+    // HLE code observes whichever core happened to enter it last.
+    if (system->running_core != previous_core) {
+        system->running_core = previous_core;
+        system->kernel->SetRunningCPU(previous_core);
+    }
+    system->hle_lock.unlock();
+}
+
 void System::PrepareReschedule() {
     running_core->PrepareReschedule();
     reschedule_pending = true;
@@ -386,6 +490,9 @@ System::ResultStatus System::Init(Frontend::EmuWindow& emu_window,
             cpu_cores.push_back(std::make_shared<ARM_Dynarmic>(
                 this, *memory, i, timing->GetTimer(i), *exclusive_monitor));
         }
+        if (Settings::values.multithreaded_cpu && num_cores > 1) {
+            cpu_manager = std::make_unique<CpuManager>(cpu_cores);
+        }
 #else
         for (u32 i = 0; i < num_cores; ++i) {
             cpu_cores.push_back(
@@ -545,6 +652,19 @@ void System::Shutdown(bool is_deserializing) {
     telemetry_session->AddField(performance, "Shutdown_Frametime", perf_results.frametime * 1000.0);
     telemetry_session->AddField(performance, "Mean_Frametime_MS",
                                 perf_stats ? perf_stats->GetMeanFrametime() : 0);
+    if (kernel) {
+        const auto hle_stats = kernel->GetHLEWorkerPool().GetStats();
+        telemetry_session->AddField(performance, "HLEAsync_Requests", hle_stats.completed);
+        telemetry_session->AddField(performance, "HLEAsync_Workers",
+                                    static_cast<u64>(hle_stats.workers));
+        telemetry_session->AddField(performance, "HLEAsync_MaxQueueDepth",
+                                    static_cast<u64>(hle_stats.max_queue_depth));
+        telemetry_session->AddField(performance, "HLEAsync_AverageWaitUs",
+                                    hle_stats.average_wait_us);
+        telemetry_session->AddField(performance, "HLEAsync_MaxWaitUs", hle_stats.max_wait_us);
+        telemetry_session->AddField(performance, "HLEAsync_AverageRunUs",
+                                    hle_stats.average_run_us);
+    }
 
     // Shutdown emulation session
     is_powered_on = false;
@@ -552,6 +672,11 @@ void System::Shutdown(bool is_deserializing) {
     VideoCore::Shutdown();
     HW::Shutdown();
     if (!is_deserializing) {
+        // Let any savestate that is still being written reach the disk
+        if (savestate_worker) {
+            savestate_worker->WaitForRequests();
+        }
+        rewind_buffer.reset();
         GDBStub::Shutdown();
         perf_stats.reset();
         cheat_engine.reset();
@@ -562,10 +687,15 @@ void System::Shutdown(bool is_deserializing) {
 #ifdef ENABLE_SCRIPTING
     rpc_server.reset();
 #endif
+    // Stop the asynchronous HLE requests before the services they run on go away
+    if (kernel) {
+        kernel->GetHLEWorkerPool().CancelAll();
+    }
     archive_manager.reset();
     service_manager.reset();
     dsp_core.reset();
     kernel.reset();
+    cpu_manager.reset();
     cpu_cores.clear();
     exclusive_monitor.reset();
     timing.reset();
@@ -579,6 +709,10 @@ void System::Shutdown(bool is_deserializing) {
         room_member->SendGameInfo(game_info);
     }
 
+    // Stop write-protecting guest RAM before it is freed
+    if (rewind_buffer) {
+        rewind_buffer->ReleaseRam();
+    }
     memory.reset();
 
     if (self_delete_pending)
@@ -674,6 +808,8 @@ void System::ApplySettings() {
 
 template <class Archive>
 void System::serialize(Archive& ar, const unsigned int file_version) {
+    // The GPU thread may still be writing to guest memory and the PICA state
+    GPU::Synchronize();
 
     u32 num_cores;
     if (Archive::is_saving::value) {
@@ -695,7 +831,12 @@ void System::serialize(Archive& ar, const unsigned int file_version) {
 
     // flush on save, don't flush on load
     bool should_flush = !Archive::is_loading::value;
-    Memory::RasterizerClearAll(should_flush);
+    if (should_flush && !serializing_ram) {
+        // Rewind captures flush every few frames, keep the surfaces cached for the next ones
+        Memory::RasterizerFlushAll();
+    } else {
+        Memory::RasterizerClearAll(should_flush);
+    }
     ar&* timing.get();
     for (u32 i = 0; i < num_cores; i++) {
         ar&* cpu_cores[i].get();
@@ -13,6 +13,7 @@
 #include "core/arm/arm_interface.h"
 #include "core/movie.h"
 #include "core/perf_stats.h"
+#include "core/savestate.h"
 
 class ARM_Interface;
 
@@ -54,6 +55,11 @@ namespace Cheats {
 class CheatEngine;
 }
 
+namespace Common {
+template <class StateType>
+class StatefulThreadWorker;
+}
+
 namespace VideoDumper {
 class Backend;
 }
@@ -70,7 +76,9 @@ class AppLoader;
 namespace Core {
 
 class TelemetrySession;
+class CpuManager;
 class ExclusiveMonitor;
+class RewindBuffer;
 class Timing;
 
 class System {
@@ -128,7 +136,7 @@ public:
     /// Shutdown and then load again
     void Reset();
 
-    enum class Signal : u32 { None, Shutdown, Reset, Save, Load };
+    enum class Signal : u32 { None, Shutdown, Reset, Save, Load, Rewind };
 
     bool SendSignal(Signal signal, u32 param = 0);
 
@@ -202,6 +210,32 @@ public:
         return static_cast<u32>(cpu_cores.size());
     }
 
+    /// Lock on HLE code returned by LockHLE, restores the previous running core when released.
+    class HLELock {
+    public:
+        HLELock() = default;
+        HLELock(System& system, ARM_Interface& core);
+        ~HLELock();
+
+        HLELock(const HLELock&) = delete;
+        HLELock& operator=(const HLELock&) = delete;
+
+    private:
+        System* system = nullptr;
+        ARM_Interface* previous_core = nullptr;
+    };
+
+    /**
+     * Serialises entry into HLE code (SVCs, slow-path memory accesses) from a core that runs on its
+     * own host thread, and makes that core the running core for the lifetime of the returned lock.
+     * Returns an empty lock when the cores are being run serially.
+     * @param core The core entering HLE code.
+     */
+    [[nodiscard]] HLELock LockHLE(ARM_Interface& core);
+
+    /// Returns true while the cores are executing concurrently on their own host threads.
+    [[nodiscard]] bool IsCoreThreaded() const;
+
     void InvalidateCacheRange(u32 start_address, std::size_t length) {
         for (const auto& cpu : cpu_cores) {
             cpu->InvalidateCacheRange(start_address, length);
@@ -334,10 +368,29 @@ public:
                (mic_permission_granted = mic_permission_func());
     }
 
-    void SaveState(u32 slot) const;
+    /**
+     * Takes a snapshot of the emulated system and queues it to be compressed and written to the
+     * given slot on the savestate worker thread. Progress is reported to the registered savestate
+     * callback.
+     */
+    void SaveState(u32 slot);
 
+    /// Loads the state from the given slot, waiting for any background save to finish first.
     void LoadState(u32 slot);
 
+    /// Registers a callback that reports the progress of background savestate writes.
+    void RegisterSaveStateCallback(SaveStateCallback callback) {
+        savestate_callback = std::move(callback);
+    }
+
+    /**
+     * Returns whether serializing the system includes the contents of guest RAM. This is false
+     * while the rewind buffer captures a state, as it records guest RAM on its own.
+     */
+    [[nodiscard]] bool IsSerializingRam() const {
+        return serializing_ram;
+    }
+
     /// Self delete ncch
     bool SetSelfDelete(const std::string& file) {
         if (m_filepath == file) {
@@ -367,6 +420,15 @@ private:
     /// Reschedule the core emulation
     void Reschedule();
 
+    /// Returns true if the cores must be run one after the other for reproducibility
+    [[nodiscard]] bool IsDeterministic() const;
+
+    /**
+     * Runs one slice of max_slice ticks on all cores concurrently through the CPU manager.
+     * Cores without a thread to run idle for the slice instead.
+     */
+    void RunCoresParallel(s64 max_slice);
+
     /// AppLoader used to load the current executing application
     std::unique_ptr<Loader::AppLoader> app_loader;
 
@@ -374,6 +436,12 @@ private:
     std::vector<std::shared_ptr<ARM_Interface>> cpu_cores;
     ARM_Interface* running_core = nullptr;
 
+    /// Host threads for the ARM11 cores, only present in multi-threaded CPU mode
+    std::unique_ptr<Core::CpuManager> cpu_manager;
+
+    /// Held by a core while it executes HLE code in multi-threaded CPU mode
+    std::mutex hle_lock;
+
     /// DSP core
     std::unique_ptr<AudioCore::DspInterface> dsp_core;
 
@@ -440,6 +508,16 @@ private:
     std::function<bool()> mic_permission_func;
     bool mic_permission_granted = false;
 
+    /// Compresses and writes savestates off the emulation thread
+    std::unique_ptr<Common::StatefulThreadWorker<void>> savestate_worker;
+    SaveStateCallback savestate_callback;
+
+    /// Recent states for rewinding, present while rewind is enabled
+    std::unique_ptr<Core::RewindBuffer> rewind_buffer;
+    bool serializing_ram = true;
+
+    friend class RewindBuffer;
+
     friend class boost::serialization::access;
     template <typename Archive>
     void serialize(Archive& ar, const unsigned int file_version);
@@ -176,6 +176,18 @@ void Timing::Timer::ForceExceptionCheck(s64 cycles) {
     }
 }
 
+s64 Timing::Timer::LimitSlice(s64 max_ticks) {
+    const s64 excess = slice_length - downcount - max_ticks;
+    if (excess > 0) {
+        // Idling ran no instructions, so only the rest is owed
+        const u64 idle_excess = std::min(idled_cycles, static_cast<u64>(excess));
+        idled_cycles -= idle_excess;
+        downcount += excess;
+        slice_debt += excess - static_cast<s64>(idle_excess);
+    }
+    return slice_length - downcount;
+}
+
 void Timing::Timer::MoveEvents() {
     for (Event ev; ts_queue.Pop(ev);) {
         ev.fifo_order = event_fifo_id++;
@@ -228,6 +240,11 @@ void Timing::Timer::SetNextSlice(s64 max_slice_length) {
     }
 
     downcount = slice_length;
+
+    // Ticks executed ahead in earlier slices are accounted to this one without being executed again
+    const s64 repaid = std::clamp<s64>(slice_debt, 0, slice_length);
+    downcount -= repaid;
+    slice_debt -= repaid;
 }
 
 void Timing::Timer::Idle() {
@@ -201,6 +201,13 @@ public:
 
         void ForceExceptionCheck(s64 cycles);
 
+        /**
+         * Limits the ticks accounted to the current slice to max_ticks and returns them. Ticks
+         * executed past that are owed and accounted to the following slices, which execute that
+         * much less.
+         */
+        s64 LimitSlice(s64 max_ticks);
+
         void MoveEvents();
 
     private:
@@ -227,13 +234,15 @@ public:
         s64 downcount = MAX_SLICE_LENGTH;
         s64 executed_ticks = 0;
         u64 idled_cycles = 0;
+        // Ticks executed ahead of the accounted time, see LimitSlice
+        s64 slice_debt = 0;
 
         // Stores a scaling for the internal clockspeed. Changing this number results in
         // under/overclocking the guest cpu
         double cpu_clock_scale = 1.0;
 
         template <class Archive>
-        void serialize(Archive& ar, const unsigned int) {
+        void serialize(Archive& ar, const unsigned int file_version) {
             MoveEvents();
             ar& event_queue;
             ar& event_fifo_id;
@@ -241,6 +250,11 @@ public:
             ar& downcount;
             ar& executed_ticks;
             ar& idled_cycles;
+            if (file_version > 0) {
+                ar& slice_debt;
+            } else {
+                slice_debt = 0;
+            }
         }
         friend class boost::serialization::access;
     };
@@ -313,3 +327,4 @@ private:
 } // namespace Core
 
 BOOST_CLASS_VERSION(Core::Timing, 1)
+BOOST_CLASS_VERSION(Core::Timing::Timer, 1)
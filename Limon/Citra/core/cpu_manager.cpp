@@ -0,0 +1,72 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <fmt/format.h>
+#include "common/assert.h"
+#include "common/microprofile.h"
+#include "core/arm/arm_interface.h"
+#include "core/cpu_manager.h"
+
+namespace Core {
+
+CpuManager::CpuManager(std::span<const std::shared_ptr<ARM_Interface>> cores_)
+    : start_barrier{cores_.size()}, end_barrier{cores_.size()} {
+    ASSERT(!cores_.empty());
+    cores.reserve(cores_.size());
+    for (const auto& core : cores_) {
+        cores.push_back(core.get());
+    }
+
+    // Core 0 is driven by the emulation thread itself.
+    threads.reserve(cores.size() - 1);
+    for (std::size_t i = 1; i < cores.size(); ++i) {
+        threads.emplace_back([this, i](std::stop_token stop_token) { CoreThread(stop_token, i); });
+    }
+}
+
+CpuManager::~CpuManager() {
+    for (auto& thread : threads) {
+        thread.request_stop();
+    }
+    threads.clear();
+}
+
+MICROPROFILE_DEFINE(ARM_CoreSync, "ARM JIT", "Core Sync", MP_RGB(255, 128, 64));
+
+void CpuManager::RunSlice(u32 core_mask) {
+    active_mask.store(core_mask, std::memory_order_relaxed);
+    running_slice.store(true, std::memory_order_release);
+
+    start_barrier.Sync();
+    if (core_mask & 1) {
+        cores[0]->Run();
+    }
+    {
+        MICROPROFILE_SCOPE(ARM_CoreSync);
+        end_barrier.Sync();
+    }
+
+    running_slice.store(false, std::memory_order_release);
+}
+
+void CpuManager::CoreThread(std::stop_token stop_token, std::size_t core_id) {
+    const std::string name = fmt::format("CPU core {}", core_id);
+    Common::SetCurrentThreadName(name.c_str());
+    Common::SetCurrentThreadPriority(Common::ThreadPriority::High);
+
+    ARM_Interface* const core = cores[core_id];
+    while (!stop_token.stop_requested()) {
+        if (!start_barrier.Sync(stop_token)) {
+            break;
+        }
+        if (active_mask.load(std::memory_order_relaxed) & (1U << core_id)) {
+            core->Run();
+        }
+        if (!end_barrier.Sync(stop_token)) {
+            break;
+        }
+    }
+}
+
+} // namespace Core
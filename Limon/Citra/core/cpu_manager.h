@@ -0,0 +1,56 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <span>
+#include <vector>
+#include "common/common_types.h"
+#include "common/polyfill_thread.h"
+#include "common/thread.h"
+
+class ARM_Interface;
+
+namespace Core {
+
+/**
+ * Runs the emulated ARM11 cores on their own host threads. Core 0 always executes on the thread
+ * calling RunSlice (the emulation thread); every other core owns a dedicated host thread. All
+ * cores start and finish a slice together, so everything outside of RunSlice (timing events,
+ * rescheduling, savestates) still happens with the cores parked.
+ */
+class CpuManager {
+public:
+    explicit CpuManager(std::span<const std::shared_ptr<ARM_Interface>> cores);
+    ~CpuManager();
+
+    CpuManager(const CpuManager&) = delete;
+    CpuManager& operator=(const CpuManager&) = delete;
+
+    /**
+     * Runs a single slice on each core selected in core_mask and blocks until all of them have
+     * exhausted their downcount or halted. The slice length must already be set on each timer.
+     * @param core_mask Bit N set means core N has a thread to run in this slice.
+     */
+    void RunSlice(u32 core_mask);
+
+    /// Returns true while cores are executing concurrently inside RunSlice.
+    [[nodiscard]] bool IsRunningSlice() const {
+        return running_slice.load(std::memory_order_acquire);
+    }
+
+private:
+    void CoreThread(std::stop_token stop_token, std::size_t core_id);
+
+    std::vector<ARM_Interface*> cores;
+    std::vector<std::jthread> threads;
+    Common::Barrier start_barrier;
+    Common::Barrier end_barrier;
+    std::atomic<u32> active_mask{};
+    std::atomic_bool running_slice{};
+};
+
+} // namespace Core
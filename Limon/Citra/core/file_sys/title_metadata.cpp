@@ -181,6 +181,10 @@ std::array<u8, 16> TitleMetadata::GetContentCTRByIndex(std::size_t index) const
     return ctr;
 }
 
+std::array<u8, 0x20> TitleMetadata::GetContentHashByIndex(std::size_t index) const {
+    return tmd_chunks[index].hash;
+}
+
 bool TitleMetadata::HasEncryptedContent() const {
     return std::any_of(tmd_chunks.begin(), tmd_chunks.end(), [](auto& chunk) {
         return (static_cast<u16>(chunk.type) & FileSys::TMDContentTypeFlag::Encrypted) != 0;
@@ -2,7 +2,6 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
-#include <algorithm>
 #include "common/archives.h"
 #include "common/common_types.h"
 #include "common/logging/log.h"
@@ -15,52 +14,54 @@
 
 namespace Kernel {
 
+void AddressArbiter::SortLoadedThreads() {
+    for (auto& thread : unsorted_waiting_threads) {
+        const VAddr address = thread->wait_address;
+        waiting_threads[address].Push(std::move(thread));
+    }
+    unsorted_waiting_threads.clear();
+}
+
 void AddressArbiter::WaitThread(std::shared_ptr<Thread> thread, VAddr wait_address) {
+    SortLoadedThreads();
     thread->wait_address = wait_address;
     thread->status = ThreadStatus::WaitArb;
-    waiting_threads.emplace_back(std::move(thread));
+    waiting_threads[wait_address].Push(std::move(thread));
 }
 
 void AddressArbiter::ResumeAllThreads(VAddr address) {
+    SortLoadedThreads();
     // Determine which threads are waiting on this address, those should be woken up.
-    auto itr = std::stable_partition(waiting_threads.begin(), waiting_threads.end(),
-                                     [address](const auto& thread) {
-                                         ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                                                    "Inconsistent AddressArbiter state");
-                                         return thread->wait_address != address;
-                                     });
-
-    // Wake up all the found threads
-    std::for_each(itr, waiting_threads.end(), [](auto& thread) { thread->ResumeFromWait(); });
-
-    // Remove the woken up threads from the wait list.
-    waiting_threads.erase(itr, waiting_threads.end());
+    const auto itr = waiting_threads.find(address);
+    if (itr == waiting_threads.end())
+        return;
+
+    // Remove the threads from the wait list, and wake them up in the order they started waiting.
+    const auto threads = itr->second.TakeAll();
+    waiting_threads.erase(itr);
+    for (const auto& thread : threads) {
+        ASSERT_MSG(thread->status == ThreadStatus::WaitArb, "Inconsistent AddressArbiter state");
+        thread->ResumeFromWait();
+    }
 }
 
 std::shared_ptr<Thread> AddressArbiter::ResumeHighestPriorityThread(VAddr address) {
+    SortLoadedThreads();
     // Determine which threads are waiting on this address, those should be considered for wakeup.
-    auto matches_start = std::stable_partition(
-        waiting_threads.begin(), waiting_threads.end(), [address](const auto& thread) {
-            ASSERT_MSG(thread->status == ThreadStatus::WaitArb,
-                       "Inconsistent AddressArbiter state");
-            return thread->wait_address != address;
-        });
-
-    // Iterate through threads, find highest priority thread that is waiting to be arbitrated.
-    // Note: The real kernel will pick the first thread in the list if more than one have the
-    // same highest priority value. Lower priority values mean higher priority.
-    auto itr = std::min_element(matches_start, waiting_threads.end(),
-                                [](const auto& lhs, const auto& rhs) {
-                                    return lhs->current_priority < rhs->current_priority;
-                                });
-
+    const auto itr = waiting_threads.find(address);
     if (itr == waiting_threads.end())
         return nullptr;
 
-    auto thread = *itr;
-    thread->ResumeFromWait();
+    // Take the highest priority thread that is waiting to be arbitrated.
+    // Note: The real kernel will pick the first thread in the list if more than one have the
+    // same highest priority value. Lower priority values mean higher priority.
+    auto thread = itr->second.Front();
+    ASSERT_MSG(thread->status == ThreadStatus::WaitArb, "Inconsistent AddressArbiter state");
+    itr->second.Remove(thread.get());
+    if (itr->second.Empty())
+        waiting_threads.erase(itr);
 
-    waiting_threads.erase(itr);
+    thread->ResumeFromWait();
     return thread;
 }
 
@@ -97,9 +98,14 @@ private:
 void AddressArbiter::WakeUp(ThreadWakeupReason reason, std::shared_ptr<Thread> thread,
                             std::shared_ptr<WaitObject> object) {
     ASSERT(reason == ThreadWakeupReason::Timeout);
+    SortLoadedThreads();
     // Remove the newly-awakened thread from the Arbiter's waiting list.
-    waiting_threads.erase(std::remove(waiting_threads.begin(), waiting_threads.end(), thread),
-                          waiting_threads.end());
+    const auto itr = waiting_threads.find(thread->wait_address);
+    if (itr == waiting_threads.end())
+        return;
+    itr->second.Remove(thread.get());
+    if (itr->second.Empty())
+        waiting_threads.erase(itr);
 };
 
 ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, ArbitrationType type,
@@ -112,9 +118,11 @@ ResultCode AddressArbiter::ArbitrateAddress(std::shared_ptr<Thread> thread, Arbi
         if (value < 0) {
             ResumeAllThreads(address);
         } else {
-            // Resume first N threads
-            for (int i = 0; i < value; i++)
-                ResumeHighestPriorityThread(address);
+            // Resume first N threads, stopping early once no thread is left waiting
+            for (int i = 0; i < value; i++) {
+                if (!ResumeHighestPriorityThread(address))
+                    break;
+            }
         }
         break;
 
@@ -4,10 +4,12 @@
 
 #pragma once
 
+#include <map>
 #include <memory>
 #include <vector>
 #include <boost/serialization/base_object.hpp>
 #include <boost/serialization/export.hpp>
+#include <boost/serialization/map.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/string.hpp>
 #include <boost/serialization/vector.hpp>
@@ -15,6 +17,7 @@
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/wait_queue.h"
 #include "core/hle/result.h"
 
 // Address arbiters are an underlying kernel synchronization object that can be created/used via
@@ -71,8 +74,16 @@ private:
     /// the resumed thread.
     std::shared_ptr<Thread> ResumeHighestPriorityThread(VAddr address);
 
-    /// Threads waiting for the address arbiter to be signaled.
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    /// Threads waiting for the address arbiter to be signaled, for each arbitration address.
+    std::map<VAddr, ThreadWaitQueue> waiting_threads;
+
+    /// Waiting threads loaded from a version 2 save state, in the order in which they started
+    /// waiting. Their wait addresses may not be loaded yet when the arbiter is, so they are only
+    /// sorted into waiting_threads when the arbiter is next used.
+    std::vector<std::shared_ptr<Thread>> unsorted_waiting_threads;
+
+    /// Moves the threads loaded from a version 2 save state to their address's wait queue.
+    void SortLoadedThreads();
 
     std::shared_ptr<Callback> timeout_callback;
 
@@ -84,7 +95,14 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         ar& boost::serialization::base_object<Object>(*this);
         ar& name;
-        ar& waiting_threads;
+        if (file_version < 3) {
+            ar& unsorted_waiting_threads;
+        } else {
+            if (!Archive::is_loading::value) {
+                SortLoadedThreads();
+            }
+            ar& waiting_threads;
+        }
         ar& timeout_callback;
     }
 };
@@ -93,5 +111,5 @@ private:
 
 BOOST_CLASS_EXPORT_KEY(Kernel::AddressArbiter)
 BOOST_CLASS_EXPORT_KEY(Kernel::AddressArbiter::Callback)
-BOOST_CLASS_VERSION(Kernel::AddressArbiter, 2)
+BOOST_CLASS_VERSION(Kernel::AddressArbiter, 3)
 CONSTRUCT_KERNEL_OBJECT(Kernel::AddressArbiter)
@@ -7,7 +7,6 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
-#include <future>
 #include <memory>
 #include <string>
 #include <vector>
@@ -20,6 +19,7 @@
 #include "common/serialization/boost_small_vector.hpp"
 #include "common/swap.h"
 #include "core/hle/ipc.h"
+#include "core/hle/kernel/hle_worker_pool.h"
 #include "core/hle/kernel/object.h"
 #include "core/hle/kernel/server_session.h"
 
@@ -252,9 +252,15 @@ private:
     template <typename ResultFunctor>
     class AsyncWakeUpCallback : public WakeupCallback {
     public:
-        explicit AsyncWakeUpCallback(ResultFunctor res_functor, std::future<void> fut)
-            : functor(res_functor) {
-            future = std::move(fut);
+        explicit AsyncWakeUpCallback(ResultFunctor res_functor,
+                                     std::shared_ptr<HLEAsyncRequest> async_request)
+            : functor(res_functor), request(std::move(async_request)) {}
+
+        ~AsyncWakeUpCallback() override {
+            // The request refers to the context and the thread, don't let it outlive them
+            if (request) {
+                request->CancelOrWait();
+            }
         }
 
         void WakeUp(std::shared_ptr<Kernel::Thread> thread, Kernel::HLERequestContext& ctx,
@@ -264,12 +270,12 @@ private:
 
     private:
         ResultFunctor functor;
-        std::future<void> future;
+        std::shared_ptr<HLEAsyncRequest> request;
 
         template <class Archive>
         void serialize(Archive& ar, const unsigned int) {
-            if (!Archive::is_loading::value && future.valid()) {
-                future.wait();
+            if (!Archive::is_loading::value && request) {
+                request->Wait();
             }
             ar& functor;
         }
@@ -300,16 +306,16 @@ public:
                 "RunAsync", std::chrono::nanoseconds(-1),
                 std::make_shared<AsyncWakeUpCallback<ResultFunctor>>(
                     result_function,
-                    std::move(std::async(std::launch::async, [this, async_section] {
+                    kernel.GetHLEWorkerPool().Push([this, async_section] {
                         s64 sleep_for = async_section(*this);
                         this->thread->WakeAfterDelay(sleep_for, true);
-                    }))));
+                    })));
 
         } else {
             s64 sleep_for = async_section(*this);
             if (sleep_for > 0) {
                 auto parallel_wakeup = std::make_shared<AsyncWakeUpCallback<ResultFunctor>>(
-                    result_function, std::move(std::future<void>()));
+                    result_function, nullptr);
                 this->SleepClientThread("RunAsync", std::chrono::nanoseconds(sleep_for),
                                         parallel_wakeup);
             } else {
@@ -0,0 +1,175 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "core/hle/kernel/hle_worker_pool.h"
+
+MICROPROFILE_DEFINE(Kernel_HLEAsync, "Kernel", "HLE Async Request", MP_RGB(70, 150, 200));
+
+namespace Kernel {
+
+namespace {
+
+u64 ElapsedMicroseconds(std::chrono::steady_clock::time_point start,
+                        std::chrono::steady_clock::time_point end) {
+    return static_cast<u64>(
+        std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+} // Anonymous namespace
+
+HLEAsyncRequest::HLEAsyncRequest(Common::UniqueFunction<void> function)
+    : function(std::move(function)), queue_time(std::chrono::steady_clock::now()) {}
+
+HLEAsyncRequest::~HLEAsyncRequest() = default;
+
+void HLEAsyncRequest::Wait() {
+    std::unique_lock lock{mutex};
+    condition.wait(lock,
+                   [this] { return state == State::Finished || state == State::Cancelled; });
+}
+
+bool HLEAsyncRequest::CancelOrWait() {
+    std::unique_lock lock{mutex};
+    if (state == State::Queued) {
+        state = State::Cancelled;
+        function = {};
+        lock.unlock();
+        condition.notify_all();
+        return true;
+    }
+    condition.wait(lock,
+                   [this] { return state == State::Finished || state == State::Cancelled; });
+    return false;
+}
+
+bool HLEAsyncRequest::Start() {
+    std::scoped_lock lock{mutex};
+    if (state != State::Queued) {
+        return false;
+    }
+    state = State::Running;
+    return true;
+}
+
+void HLEAsyncRequest::Finish() {
+    Common::UniqueFunction<void> finished_function;
+    {
+        std::scoped_lock lock{mutex};
+        finished_function = std::move(function);
+        state = State::Finished;
+    }
+    condition.notify_all();
+}
+
+HLEWorkerPool::HLEWorkerPool(std::size_t expected_max_workers)
+    : expected_max_workers(expected_max_workers) {}
+
+HLEWorkerPool::~HLEWorkerPool() {
+    CancelAll();
+    {
+        std::scoped_lock lock{queue_mutex};
+        for (auto& worker : workers) {
+            worker.request_stop();
+        }
+    }
+    queue_condition.notify_all();
+    workers.clear();
+}
+
+std::shared_ptr<HLEAsyncRequest> HLEWorkerPool::Push(Common::UniqueFunction<void> function) {
+    auto request = std::make_shared<HLEAsyncRequest>(std::move(function));
+    {
+        std::scoped_lock lock{queue_mutex};
+        requests.push(request);
+        stats.max_queue_depth = std::max(stats.max_queue_depth, requests.size());
+        // Start a worker if the idle ones can't take all the queued requests. The busy workers may
+        // be blocked on requests that only this one can complete, so this is never capped.
+        if (idle_workers < requests.size()) {
+            if (workers.size() >= expected_max_workers) {
+                LOG_WARNING(Kernel, "All {} HLE workers are busy, starting another one",
+                            workers.size());
+            }
+            workers.emplace_back(
+                [this](std::stop_token stop_token) { WorkerLoop(stop_token); });
+        }
+    }
+    queue_condition.notify_one();
+    return request;
+}
+
+void HLEWorkerPool::CancelAll() {
+    std::unique_lock lock{queue_mutex};
+    // Queued requests only start running once popped, so this never waits
+    while (!requests.empty()) {
+        if (requests.front()->CancelOrWait()) {
+            ++stats.cancelled;
+        }
+        requests.pop();
+    }
+    idle_condition.wait(lock, [this] { return running_requests == 0; });
+}
+
+HLEWorkerPoolStats HLEWorkerPool::GetStats() const {
+    std::scoped_lock lock{queue_mutex};
+    HLEWorkerPoolStats result = stats;
+    result.workers = workers.size();
+    result.queue_depth = requests.size();
+    if (stats.completed != 0) {
+        result.average_wait_us = total_wait_us / stats.completed;
+        result.average_run_us = total_run_us / stats.completed;
+    }
+    return result;
+}
+
+void HLEWorkerPool::WorkerLoop(std::stop_token stop_token) {
+    Common::SetCurrentThreadName("HLEWorker");
+    while (!stop_token.stop_requested()) {
+        std::shared_ptr<HLEAsyncRequest> request;
+        {
+            std::unique_lock lock{queue_mutex};
+            ++idle_workers;
+            Common::CondvarWait(queue_condition, lock, stop_token,
+                                [this] { return !requests.empty(); });
+            --idle_workers;
+            if (stop_token.stop_requested()) {
+                break;
+            }
+            request = std::move(requests.front());
+            requests.pop();
+            if (!request->Start()) {
+                // Cancelled by the HLE request it belongs to
+                ++stats.cancelled;
+                continue;
+            }
+            ++running_requests;
+        }
+
+        const auto start_time = std::chrono::steady_clock::now();
+        {
+            MICROPROFILE_SCOPE(Kernel_HLEAsync);
+            request->function();
+        }
+        const auto end_time = std::chrono::steady_clock::now();
+        request->Finish();
+
+        {
+            std::scoped_lock lock{queue_mutex};
+            const u64 wait_us = ElapsedMicroseconds(request->queue_time, start_time);
+            const u64 run_us = ElapsedMicroseconds(start_time, end_time);
+            ++stats.completed;
+            total_wait_us += wait_us;
+            total_run_us += run_us;
+            stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+            stats.max_run_us = std::max(stats.max_run_us, run_us);
+            --running_requests;
+        }
+        idle_condition.notify_all();
+    }
+}
+
+} // namespace Kernel
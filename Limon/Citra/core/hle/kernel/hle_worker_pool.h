@@ -0,0 +1,126 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include "common/common_types.h"
+#include "common/polyfill_thread.h"
+#include "common/unique_function.h"
+
+namespace Kernel {
+
+/// Counters of the HLE worker pool, for tuning its size
+struct HLEWorkerPoolStats {
+    u64 completed;           ///< Requests that ran to completion
+    u64 cancelled;           ///< Requests dropped before they started running
+    std::size_t workers;     ///< Worker threads started
+    std::size_t queue_depth; ///< Requests waiting for a worker
+    std::size_t max_queue_depth;
+    u64 average_wait_us; ///< Average time between queueing a request and starting to run it
+    u64 max_wait_us;
+    u64 average_run_us; ///< Average time spent running a request
+    u64 max_run_us;
+};
+
+/// Asynchronous section of an HLE request queued on the HLE worker pool.
+class HLEAsyncRequest {
+public:
+    explicit HLEAsyncRequest(Common::UniqueFunction<void> function);
+    ~HLEAsyncRequest();
+
+    HLEAsyncRequest(const HLEAsyncRequest&) = delete;
+    HLEAsyncRequest& operator=(const HLEAsyncRequest&) = delete;
+
+    /// Waits until the request has finished running or has been cancelled.
+    void Wait();
+
+    /**
+     * Cancels the request if it hasn't started running yet, otherwise waits for it to finish.
+     * @returns True if the request was cancelled
+     */
+    bool CancelOrWait();
+
+private:
+    friend class HLEWorkerPool;
+
+    enum class State {
+        Queued,
+        Running,
+        Finished,
+        Cancelled,
+    };
+
+    /// Moves the request from queued to running, returns false if it was cancelled.
+    bool Start();
+
+    /// Marks the request as finished and releases the function along with what it captured.
+    void Finish();
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    State state = State::Queued;
+    Common::UniqueFunction<void> function;
+    std::chrono::steady_clock::time_point queue_time;
+};
+
+/**
+ * Worker threads running the asynchronous sections of HLE service requests (see
+ * HLERequestContext::RunAsync), which are mostly blocking host I/O such as sockets and HTTP.
+ *
+ * Workers are started as requests come in, when no idle worker is available, and are reused
+ * afterwards. Requests of different guest threads are independent and run in any order.
+ *
+ * A request may block until another guest thread's request runs, e.g. a socket recv waiting for
+ * a send, so a queued request must never wait for busy workers to free up. The pool therefore
+ * always starts a worker when all of them are busy, and logs a warning once it grows past the
+ * number of workers applications are expected to need.
+ */
+class HLEWorkerPool {
+public:
+    static constexpr std::size_t EXPECTED_MAX_WORKERS = 32;
+
+    explicit HLEWorkerPool(std::size_t expected_max_workers = EXPECTED_MAX_WORKERS);
+    ~HLEWorkerPool();
+
+    HLEWorkerPool(const HLEWorkerPool&) = delete;
+    HLEWorkerPool& operator=(const HLEWorkerPool&) = delete;
+
+    /// Queues a function to run on a worker thread, returning its request.
+    std::shared_ptr<HLEAsyncRequest> Push(Common::UniqueFunction<void> function);
+
+    /**
+     * Cancels all queued requests and waits for the running ones to finish. Called before the
+     * services and the guest threads the requests refer to are destroyed.
+     */
+    void CancelAll();
+
+    HLEWorkerPoolStats GetStats() const;
+
+private:
+    void WorkerLoop(std::stop_token stop_token);
+
+    const std::size_t expected_max_workers;
+
+    mutable std::mutex queue_mutex;
+    std::condition_variable_any queue_condition;
+    std::condition_variable idle_condition;
+    std::queue<std::shared_ptr<HLEAsyncRequest>> requests;
+    std::vector<std::jthread> workers;
+    std::size_t idle_workers = 0;
+    std::size_t running_requests = 0;
+
+    // Statistics, protected by queue_mutex
+    HLEWorkerPoolStats stats{};
+    u64 total_wait_us = 0;
+    u64 total_run_us = 0;
+};
+
+} // namespace Kernel
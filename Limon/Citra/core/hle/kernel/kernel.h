@@ -41,6 +41,7 @@ namespace Kernel {
 
 class AddressArbiter;
 class Event;
+class HLEWorkerPool;
 class Mutex;
 class CodeSet;
 class Process;
@@ -296,6 +297,9 @@ public:
     IPCDebugger::Recorder& GetIPCRecorder();
     const IPCDebugger::Recorder& GetIPCRecorder() const;
 
+    /// Gets the worker threads running the asynchronous sections of HLE requests.
+    HLEWorkerPool& GetHLEWorkerPool();
+
     std::shared_ptr<MemoryRegionInfo> GetMemoryRegion(MemoryRegion region);
 
     void HandleSpecialMapping(VMManager& address_space, const AddressMapping& mapping);
@@ -364,6 +368,9 @@ private:
 
     std::unique_ptr<IPCDebugger::Recorder> ipc_recorder;
 
+    // Destructed first, running requests refer to the threads and processes above.
+    std::unique_ptr<HLEWorkerPool> hle_worker_pool;
+
     u32 next_thread_id;
 
     MemoryMode memory_mode;
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <vector>
 #include "common/archives.h"
 #include "common/assert.h"
@@ -112,9 +113,8 @@ void Mutex::UpdatePriority() {
         return;
 
     u32 best_priority = ThreadPrioLowest;
-    for (auto& waiter : GetWaitingThreads()) {
-        if (waiter->current_priority < best_priority)
-            best_priority = waiter->current_priority;
+    if (const auto waiter = GetHighestPriorityWaitingThread()) {
+        best_priority = std::min(best_priority, waiter->current_priority);
     }
 
     if (best_priority != priority) {
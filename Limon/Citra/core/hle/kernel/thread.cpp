@@ -387,6 +387,10 @@ void Thread::SetPriority(u32 priority) {
     else
         thread_manager.ready_queue.prepare(priority);
 
+    // The thread may be waiting on objects, which order their waiting threads by priority
+    if (priority != current_priority)
+        ThreadWaitQueue::InvalidatePriorityOrder();
+
     nominal_priority = current_priority = priority;
 }
 
@@ -405,6 +409,11 @@ void Thread::BoostPriority(u32 priority) {
         thread_manager.ready_queue.move(this, current_priority, priority);
     else
         thread_manager.ready_queue.prepare(priority);
+
+    // The thread may be waiting on objects, which order their waiting threads by priority
+    if (priority != current_priority)
+        ThreadWaitQueue::InvalidatePriorityOrder();
+
     current_priority = priority;
 }
 
@@ -8,10 +8,9 @@
 #include <memory>
 #include <vector>
 #include <boost/serialization/base_object.hpp>
-#include <boost/serialization/shared_ptr.hpp>
-#include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
 #include "core/hle/kernel/object.h"
+#include "core/hle/kernel/wait_queue.h"
 
 namespace Kernel {
 
@@ -53,15 +52,18 @@ public:
     /// Obtains the highest priority thread that is ready to run from this object's waiting list.
     std::shared_ptr<Thread> GetHighestPriorityReadyThread() const;
 
-    /// Get a const reference to the waiting threads list for debug use
-    const std::vector<std::shared_ptr<Thread>>& GetWaitingThreads() const;
+    /// Obtains the highest priority thread waiting on this object, whether it's ready or not.
+    std::shared_ptr<Thread> GetHighestPriorityWaitingThread() const;
+
+    /// Get the waiting threads, in the order in which they started waiting, for debug use
+    std::vector<std::shared_ptr<Thread>> GetWaitingThreads() const;
 
     /// Sets a callback which is called when the object becomes available
     void SetHLENotifier(std::function<void()> callback);
 
 private:
     /// Threads waiting for this object to become available
-    std::vector<std::shared_ptr<Thread>> waiting_threads;
+    ThreadWaitQueue waiting_threads;
 
     /// Function to call when this object becomes available
     std::function<void()> hle_notifier;
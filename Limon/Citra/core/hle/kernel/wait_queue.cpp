@@ -0,0 +1,105 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "core/hle/kernel/thread.h"
+#include "core/hle/kernel/wait_queue.h"
+
+namespace Kernel {
+
+ThreadWaitQueue::ThreadWaitQueue() = default;
+ThreadWaitQueue::~ThreadWaitQueue() = default;
+
+ThreadWaitQueue::ThreadWaitQueue(ThreadWaitQueue&&) noexcept = default;
+ThreadWaitQueue& ThreadWaitQueue::operator=(ThreadWaitQueue&&) noexcept = default;
+
+void ThreadWaitQueue::Push(std::shared_ptr<Thread> thread) {
+    if (lookup.contains(thread.get())) {
+        return;
+    }
+    const u32 priority = thread->current_priority;
+    Append(std::move(thread), priority);
+}
+
+bool ThreadWaitQueue::Remove(const Thread* thread) {
+    const auto iter = lookup.find(thread);
+    if (iter == lookup.end()) {
+        return false;
+    }
+    // The priority order is keyed on the stored priorities, so this works even when it's stale
+    by_priority.erase(iter->second);
+    waiters.erase(iter->second);
+    lookup.erase(iter);
+    return true;
+}
+
+std::shared_ptr<Thread> ThreadWaitQueue::Front() const {
+    SortByPriority();
+    return by_priority.empty() ? nullptr : (*by_priority.begin())->thread;
+}
+
+std::vector<std::shared_ptr<Thread>> ThreadWaitQueue::TakeAll() {
+    std::vector<std::shared_ptr<Thread>> threads;
+    threads.reserve(waiters.size());
+    for (auto& waiter : waiters) {
+        threads.push_back(std::move(waiter.thread));
+    }
+    by_priority.clear();
+    lookup.clear();
+    waiters.clear();
+    return threads;
+}
+
+std::vector<std::shared_ptr<Thread>> ThreadWaitQueue::GetThreads() const {
+    std::vector<std::shared_ptr<Thread>> threads;
+    threads.reserve(waiters.size());
+    for (const auto& waiter : waiters) {
+        threads.push_back(waiter.thread);
+    }
+    return threads;
+}
+
+void ThreadWaitQueue::Restore(std::vector<std::shared_ptr<Thread>> threads) {
+    TakeAll();
+    for (auto& thread : threads) {
+        Append(std::move(thread), 0);
+    }
+    sorted = false;
+}
+
+void ThreadWaitQueue::Append(std::shared_ptr<Thread> thread, u32 priority) {
+    const Thread* key = thread.get();
+    const auto iter = waiters.insert(waiters.end(), Waiter{
+                                                        .thread = std::move(thread),
+                                                        .sequence = next_sequence++,
+                                                        .priority = priority,
+                                                    });
+    lookup.emplace(key, iter);
+    by_priority.insert(iter);
+}
+
+void ThreadWaitQueue::SortByPriority() const {
+    if (sorted && sorted_epoch == priority_epoch) {
+        return;
+    }
+    sorted = true;
+    sorted_epoch = priority_epoch;
+
+    // Only re-insert the waiters whose priority actually changed
+    std::vector<WaiterList::iterator> changed;
+    for (auto iter = by_priority.begin(); iter != by_priority.end();) {
+        const WaiterList::iterator waiter = *iter;
+        if (waiter->priority == waiter->thread->current_priority) {
+            ++iter;
+            continue;
+        }
+        iter = by_priority.erase(iter);
+        changed.push_back(waiter);
+    }
+    for (const WaiterList::iterator waiter : changed) {
+        waiter->priority = waiter->thread->current_priority;
+        by_priority.insert(waiter);
+    }
+}
+
+} // namespace Kernel
@@ -0,0 +1,136 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <vector>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/vector.hpp>
+#include "common/common_types.h"
+
+namespace Kernel {
+
+class Thread;
+
+/**
+ * Threads waiting on a kernel object, kept in the order in which the kernel wakes them up: highest
+ * current priority first, and among threads of the same priority, the one that started waiting
+ * first. Since the priority of a waiting thread can change (e.g. through mutex priority
+ * inheritance), the priority order is rebuilt lazily the next time it is needed after any waiting
+ * thread changes priority.
+ */
+class ThreadWaitQueue {
+public:
+    ThreadWaitQueue();
+    ~ThreadWaitQueue();
+
+    ThreadWaitQueue(const ThreadWaitQueue&) = delete;
+    ThreadWaitQueue& operator=(const ThreadWaitQueue&) = delete;
+
+    // Moving the waiter list keeps the iterators into it valid
+    ThreadWaitQueue(ThreadWaitQueue&&) noexcept;
+    ThreadWaitQueue& operator=(ThreadWaitQueue&&) noexcept;
+
+    /// Adds a thread after the waiting threads of the same priority, unless it's already waiting.
+    void Push(std::shared_ptr<Thread> thread);
+
+    /// Removes a thread from the queue, returning whether it was waiting.
+    bool Remove(const Thread* thread);
+
+    [[nodiscard]] bool Empty() const {
+        return waiters.empty();
+    }
+
+    /// Returns the first thread in wake order, or nullptr if there are no waiting threads.
+    [[nodiscard]] std::shared_ptr<Thread> Front() const;
+
+    /**
+     * Returns the first thread in wake order for which the predicate holds, or nullptr if there's
+     * none. The predicate must not modify the queue.
+     */
+    template <typename Predicate>
+    [[nodiscard]] std::shared_ptr<Thread> FindFirst(Predicate&& predicate) const {
+        SortByPriority();
+        for (const auto& waiter : by_priority) {
+            if (predicate(waiter->thread)) {
+                return waiter->thread;
+            }
+        }
+        return nullptr;
+    }
+
+    /// Removes all threads from the queue, returning them in the order in which they started
+    /// waiting.
+    std::vector<std::shared_ptr<Thread>> TakeAll();
+
+    /// Returns the waiting threads in the order in which they started waiting.
+    [[nodiscard]] std::vector<std::shared_ptr<Thread>> GetThreads() const;
+
+    /**
+     * Replaces the waiting threads with ones loaded from a save state, in the order in which they
+     * started waiting. The threads may not be fully loaded yet, their priorities are read when
+     * the queue is next sorted.
+     */
+    void Restore(std::vector<std::shared_ptr<Thread>> threads);
+
+    /// Invalidates the priority order of all queues, called when a waiting thread changes priority.
+    static void InvalidatePriorityOrder() {
+        ++priority_epoch;
+    }
+
+private:
+    struct Waiter {
+        std::shared_ptr<Thread> thread;
+        u64 sequence; ///< Position in the order in which the threads started waiting
+        u32 priority; ///< Priority of the thread when the priority order was last built
+    };
+    using WaiterList = std::list<Waiter>;
+
+    struct PriorityOrder {
+        bool operator()(WaiterList::iterator lhs, WaiterList::iterator rhs) const {
+            if (lhs->priority != rhs->priority) {
+                return lhs->priority < rhs->priority;
+            }
+            return lhs->sequence < rhs->sequence;
+        }
+    };
+
+    /// Adds a thread at the end of the queue, ordered with the given priority.
+    void Append(std::shared_ptr<Thread> thread, u32 priority);
+
+    /// Reorders the threads whose priority changed since the priority order was last updated.
+    void SortByPriority() const;
+
+    /// Waiting threads, in the order in which they started waiting
+    WaiterList waiters;
+    std::unordered_map<const Thread*, WaiterList::iterator> lookup;
+    mutable std::set<WaiterList::iterator, PriorityOrder> by_priority;
+    mutable u64 sorted_epoch = 0;
+    mutable bool sorted = true;
+    u64 next_sequence = 0;
+
+    /// Incremented whenever a waiting thread changes priority
+    static inline u64 priority_epoch = 0;
+
+    friend class boost::serialization::access;
+    template <class Archive>
+    void save(Archive& ar, const unsigned int file_version) const {
+        const std::vector<std::shared_ptr<Thread>> threads = GetThreads();
+        ar << threads;
+    }
+    template <class Archive>
+    void load(Archive& ar, const unsigned int file_version) {
+        std::vector<std::shared_ptr<Thread>> threads;
+        ar >> threads;
+        Restore(std::move(threads));
+    }
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+};
+
+} // namespace Kernel
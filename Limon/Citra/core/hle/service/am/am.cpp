@@ -3,16 +3,22 @@
 // Refer to the license.txt file included.
 
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstddef>
 #include <cstring>
+#include <mutex>
 #include <cryptopp/aes.h>
 #include <cryptopp/modes.h>
+#include <cryptopp/sha.h>
 #include <fmt/format.h>
 #include "common/alignment.h"
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/literals.h"
 #include "common/logging/log.h"
 #include "common/string_util.h"
+#include "common/thread_worker.h"
 #include "core/core.h"
 #include "core/file_sys/errors.h"
 #include "core/file_sys/ncch_container.h"
@@ -76,13 +82,123 @@ struct TicketInfo {
 
 static_assert(sizeof(TicketInfo) == 0x18, "Ticket info structure size is wrong");
 
-class CIAFile::DecryptionState {
+using namespace Common::Literals;
+
+/**
+ * Decrypts, verifies and writes the contents of a CIA while the caller keeps feeding it data.
+ * Every content is assigned to one of a few crypto workers, so the chunks of a content are
+ * decrypted and hashed in order on one thread while different contents are processed concurrently.
+ * Decrypted chunks are then handed to a single writer thread, which appends them to the content
+ * files in the order they were queued.
+ */
+class CIAFile::ContentPipeline {
 public:
-    std::vector<CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption> content;
+    explicit ContentPipeline(std::size_t content_count)
+        : contents(content_count), crypto_workers(std::min(content_count, MaxCryptoWorkers)) {
+        for (auto& worker : crypto_workers) {
+            worker = std::make_unique<Common::ThreadWorker>(1, "CIACrypto");
+        }
+    }
+
+    ~ContentPipeline() {
+        Finish();
+    }
+
+    /// Opens the file the content at index is installed to.
+    bool Open(std::size_t index, const std::string& path, bool encrypted,
+              const std::array<u8, 0x20>& expected_hash) {
+        Content& content = contents[index];
+        content.file = FileUtil::IOFile{path, "wb"};
+        content.encrypted = encrypted;
+        content.expected_hash = expected_hash;
+        return content.file.IsOpen();
+    }
+
+    void SetKey(std::size_t index, const std::array<u8, 16>& key, const std::array<u8, 16>& ctr) {
+        contents[index].decryption.SetKeyWithIV(key.data(), key.size(), ctr.data());
+    }
+
+    /**
+     * Queues the next chunk of the content at index. Blocks while too much data is waiting to be
+     * processed.
+     * @param last whether the chunk completes the content, after which its hash is checked
+     */
+    void Submit(std::size_t index, std::vector<u8> chunk, bool last) {
+        {
+            std::unique_lock lock{mutex};
+            space_available.wait(lock, [this] { return pending_bytes < MaxPendingBytes; });
+            pending_bytes += chunk.size();
+        }
+        auto& worker = *crypto_workers[index % crypto_workers.size()];
+        worker.QueueWork([this, index, last, chunk = std::move(chunk)]() mutable {
+            Content& content = contents[index];
+            if (content.encrypted) {
+                content.decryption.ProcessData(chunk.data(), chunk.data(), chunk.size());
+            }
+            content.hash.Update(chunk.data(), chunk.size());
+            if (last) {
+                std::array<u8, 0x20> hash;
+                content.hash.Final(hash.data());
+                if (hash != content.expected_hash) {
+                    LOG_ERROR(Service_AM, "Content {} does not match the hash in the TMD", index);
+                    content.failed = true;
+                }
+            }
+            writer.QueueWork([this, index, chunk = std::move(chunk)] {
+                Content& content = contents[index];
+                if (content.file.WriteBytes(chunk.data(), chunk.size()) != chunk.size()) {
+                    LOG_ERROR(Service_AM, "Failed to write to content {}", index);
+                    content.failed = true;
+                }
+                std::scoped_lock lock{mutex};
+                pending_bytes -= chunk.size();
+                space_available.notify_one();
+            });
+        });
+    }
+
+    /**
+     * Waits for all queued chunks to be written and closes the content files.
+     * @returns whether every content was written successfully and matched its hash
+     */
+    bool Finish() {
+        // The crypto workers queue writes, so they have to be drained first
+        for (auto& worker : crypto_workers) {
+            worker->WaitForRequests();
+        }
+        writer.WaitForRequests();
+        for (auto& content : contents) {
+            content.file.Close();
+        }
+        return std::none_of(contents.begin(), contents.end(),
+                            [](const Content& content) { return content.failed.load(); });
+    }
+
+private:
+    static constexpr std::size_t MaxCryptoWorkers = 4;
+    static constexpr std::size_t MaxPendingBytes = 64_MiB;
+
+    struct Content {
+        FileUtil::IOFile file;
+        bool encrypted = false;
+        CryptoPP::CBC_Mode<CryptoPP::AES>::Decryption decryption;
+        CryptoPP::SHA256 hash;
+        std::array<u8, 0x20> expected_hash{};
+        std::atomic_bool failed = false;
+    };
+
+    std::vector<Content> contents;
+
+    std::mutex mutex;
+    std::condition_variable space_available;
+    std::size_t pending_bytes = 0;
+
+    // The crypto workers are destroyed first, as they queue work on the writer
+    Common::ThreadWorker writer{1, "CIAWriter"};
+    std::vector<std::unique_ptr<Common::ThreadWorker>> crypto_workers;
 };
 
-CIAFile::CIAFile(Service::FS::MediaType media_type)
-    : media_type(media_type), decryption_state(std::make_unique<DecryptionState>()) {}
+CIAFile::CIAFile(Service::FS::MediaType media_type) : media_type(media_type) {}
 
 CIAFile::~CIAFile() {
     Close();
@@ -151,11 +267,12 @@ ResultCode CIAFile::WriteTitleMetadata() {
     auto content_count = container.GetTitleMetadata().GetContentCount();
     content_written.resize(content_count);
 
-    content_files.clear();
+    content_pipeline = std::make_unique<ContentPipeline>(content_count);
     for (std::size_t i = 0; i < content_count; i++) {
         auto path = GetTitleContentPath(media_type, tmd.GetTitleID(), i, is_update);
-        auto& file = content_files.emplace_back(path, "wb");
-        if (!file.IsOpen()) {
+        const bool encrypted =
+            (tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) != 0;
+        if (!content_pipeline->Open(i, path, encrypted, tmd.GetContentHashByIndex(i))) {
             LOG_ERROR(Service_AM, "Could not open output file '{}' for content {}.", path, i);
             // TODO: Correct error code.
             return FileSys::ERROR_FILE_NOT_FOUND;
@@ -164,11 +281,8 @@ ResultCode CIAFile::WriteTitleMetadata() {
 
     if (container.GetTitleMetadata().HasEncryptedContent()) {
         if (auto title_key = container.GetTicket().GetTitleKey()) {
-            decryption_state->content.resize(content_count);
             for (std::size_t i = 0; i < content_count; ++i) {
-                auto ctr = tmd.GetContentCTRByIndex(i);
-                decryption_state->content[i].SetKeyWithIV(title_key->data(), title_key->size(),
-                                                          ctr.data());
+                content_pipeline->SetKey(i, *title_key, tmd.GetContentCTRByIndex(i));
             }
         } else {
             LOG_ERROR(Service_AM, "Could not read title key from ticket for encrypted CIA.");
@@ -206,24 +320,14 @@ ResultVal<std::size_t> CIAFile::WriteContentData(u64 offset, std::size_t length,
             // Figure out how much of this content ID we have just recieved/can write out
             const u64 available_to_write = std::min(offset_max, range_max) - range_min;
 
-            // Since the incoming TMD has already been written, we can use GetTitleContentPath
-            // to get the content paths to write to.
-            FileSys::TitleMetadata tmd = container.GetTitleMetadata();
-            auto& file = content_files[i];
-
             std::vector<u8> temp(buffer + (range_min - offset),
                                  buffer + (range_min - offset) + available_to_write);
 
-            if ((tmd.GetContentTypeByIndex(i) & FileSys::TMDContentTypeFlag::Encrypted) != 0) {
-                decryption_state->content[i].ProcessData(temp.data(), temp.data(), temp.size());
-            }
-
-            file.WriteBytes(temp.data(), temp.size());
-
             // Keep tabs on how much of this content ID has been written so new range_min
-            // values can be calculated.
+            // values can be calculated. The data is decrypted and written in the background.
             content_written[i] += available_to_write;
-            LOG_DEBUG(Service_AM, "Wrote {:x} to content {}, total {:x}", available_to_write, i,
+            content_pipeline->Submit(i, std::move(temp), content_written[i] == size);
+            LOG_DEBUG(Service_AM, "Queued {:x} for content {}, total {:x}", available_to_write, i,
                       content_written[i]);
         }
     }
@@ -314,8 +418,10 @@ bool CIAFile::SetSize(u64 size) const {
 }
 
 bool CIAFile::Close() const {
+    // Wait for the queued content data to be written out before looking at the result
+    const bool contents_valid = content_pipeline && content_pipeline->Finish();
     bool complete =
-        install_state >= CIAInstallState::TMDLoaded &&
+        contents_valid && install_state >= CIAInstallState::TMDLoaded &&
         content_written.size() == container.GetTitleMetadata().GetContentCount() &&
         std::all_of(content_written.begin(), content_written.end(),
                     [this, i = 0](auto& bytes_written) mutable {
@@ -401,7 +507,8 @@ InstallStatus InstallCIA(const std::string& path,
             return InstallStatus::ErrorFailedToOpenFile;
         }
 
-        std::array<u8, 0x10000> buffer;
+        // Reading the next chunk overlaps with the decryption and writing of the previous ones
+        std::vector<u8> buffer(1_MiB);
         auto file_size = file.GetSize();
         std::size_t total_bytes_read = 0;
         while (total_bytes_read != file_size) {
@@ -100,11 +100,10 @@ private:
     FileSys::CIAContainer container;
     std::vector<u8> data;
     std::vector<u64> content_written;
-    std::vector<FileUtil::IOFile> content_files;
     Service::FS::MediaType media_type;
 
-    class DecryptionState;
-    std::unique_ptr<DecryptionState> decryption_state;
+    class ContentPipeline;
+    std::unique_ptr<ContentPipeline> content_pipeline;
 };
 
 /**
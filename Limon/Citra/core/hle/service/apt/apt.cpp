@@ -265,7 +265,10 @@ bool Module::LoadLegacySharedFont() {
     FileUtil::CreateFullPath(filepath); // Create path if not already created
     FileUtil::IOFile file(filepath, "rb");
     if (file.IsOpen()) {
-        file.ReadBytes(shared_font_mem->GetPointer(), file.GetSize());
+        // Read through a host buffer, guest memory may be write-protected for dirty tracking
+        std::vector<u8> font(file.GetSize());
+        file.ReadBytes(font.data(), font.size());
+        std::memcpy(shared_font_mem->GetPointer(), font.data(), font.size());
         return true;
     }
 
@@ -2,17 +2,43 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <limits>
 #include <vector>
 #include "core/core.h"
+#include "core/core_timing.h"
 #include "core/hle/kernel/event.h"
 #include "core/hle/kernel/shared_memory.h"
 #include "core/hle/service/gsp/gsp.h"
+#include "core/hw/gpu.h"
+#include "video_core/gpu_thread.h"
+#include "video_core/video_core.h"
 
 namespace Service::GSP {
 
 static std::weak_ptr<GSP_GPU> gsp_gpu;
 
+/// Event id for CoreTiming, delivering the interrupts raised by the GPU thread
+static Core::TimingEventType* interrupt_event;
+
+static void InterruptCallback(std::uintptr_t user_data, s64 cycles_late) {
+    // Deliver the interrupt once the work raising it has completed and the registers report it
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->WaitForFence(static_cast<u64>(user_data >> 8));
+        GPU::RetireCompletedWork();
+    }
+    SignalInterrupt(static_cast<InterruptId>(user_data & 0xFF));
+}
+
 void SignalInterrupt(InterruptId interrupt_id) {
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        // The GSP shared memory and events belong to the emulation thread, so deliver it there
+        const u64 fence = VideoCore::g_gpu_thread->GetCurrentFence();
+        Core::System::GetInstance().CoreTiming().ScheduleEvent(
+            0, interrupt_event,
+            static_cast<std::uintptr_t>(fence << 8 | static_cast<u64>(interrupt_id)),
+            std::numeric_limits<std::size_t>::max(), true);
+        return;
+    }
     auto gpu = gsp_gpu.lock();
     ASSERT(gpu != nullptr);
     return gpu->SignalInterrupt(interrupt_id);
@@ -23,12 +49,16 @@ void InstallInterfaces(Core::System& system) {
     auto gpu = std::make_shared<GSP_GPU>(system);
     gpu->InstallAsService(service_manager);
     gsp_gpu = gpu;
+    interrupt_event =
+        system.CoreTiming().RegisterEvent("GSP::InterruptCallback", InterruptCallback);
 
     std::make_shared<GSP_LCD>()->InstallAsService(service_manager);
 }
 
 void SetGlobalModule(Core::System& system) {
     gsp_gpu = system.ServiceManager().GetService<GSP_GPU>("gsp::Gpu");
+    interrupt_event =
+        system.CoreTiming().RegisterEvent("GSP::InterruptCallback", InterruptCallback);
 }
 
 } // namespace Service::GSP
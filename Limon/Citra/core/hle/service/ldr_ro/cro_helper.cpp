@@ -2,6 +2,9 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
 #include "common/alignment.h"
 #include "common/logging/log.h"
 #include "common/scope_exit.h"
@@ -118,29 +121,69 @@ ResultCode CROHelper::ApplyRelocationBatch(VAddr batch, u32 symbol_address, bool
     if (symbol_address == 0 && !reset)
         return CROFormatError(0x10);
 
+    // Relocations of consecutive words are gathered into a single block write and cache
+    // invalidation, instead of one of each per relocation
+    std::array<u32_le, 64> run;
+    VAddr run_address = 0;
+    std::size_t run_size = 0;
+    const auto flush_run = [&] {
+        if (run_size == 0)
+            return;
+        const u32 size = static_cast<u32>(run_size * sizeof(u32));
+        system.Memory().WriteBlock(process, run_address, run.data(), size);
+        system.InvalidateCacheRange(run_address, size);
+        run_size = 0;
+    };
+
+    // The end of the batch is only known once it is reached, so the entries are read up to the end
+    // of the page holding the next one, which is always mapped
+    std::array<RelocationEntry, Memory::CITRA_PAGE_SIZE / sizeof(RelocationEntry)> relocations;
     VAddr relocation_address = batch;
-    while (true) {
-        RelocationEntry relocation;
-        system.Memory().ReadBlock(process, relocation_address, &relocation,
-                                  sizeof(RelocationEntry));
+    bool batch_end = false;
+    while (!batch_end) {
+        const u32 page_left =
+            Memory::CITRA_PAGE_SIZE - (relocation_address & Memory::CITRA_PAGE_MASK);
+        const std::size_t count =
+            std::max<std::size_t>(page_left / sizeof(RelocationEntry), 1);
+        system.Memory().ReadBlock(process, relocation_address, relocations.data(),
+                                  count * sizeof(RelocationEntry));
+
+        for (std::size_t i = 0; i < count && !batch_end; ++i) {
+            const RelocationEntry& relocation = relocations[i];
+            VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
+            if (relocation_target == 0) {
+                flush_run();
+                return CROFormatError(0x12);
+            }
 
-        VAddr relocation_target = SegmentTagToAddress(relocation.target_position);
-        if (relocation_target == 0) {
-            return CROFormatError(0x12);
-        }
+            const bool is_absolute = relocation.type == RelocationType::AbsoluteAddress ||
+                                     relocation.type == RelocationType::AbsoluteAddress2;
+            if (is_absolute || relocation.type == RelocationType::RelativeAddress) {
+                u32 value = symbol_address + relocation.addend;
+                if (!is_absolute)
+                    value -= relocation_target;
+                if (run_size == run.size() ||
+                    relocation_target != run_address + run_size * sizeof(u32)) {
+                    flush_run();
+                    run_address = relocation_target;
+                }
+                run[run_size++] = value;
+            } else {
+                flush_run();
+                ResultCode result =
+                    ApplyRelocation(relocation_target, relocation.type, relocation.addend,
+                                    symbol_address, relocation_target);
+                if (result.IsError()) {
+                    LOG_ERROR(Service_LDR, "Error applying relocation {:08X}", result.raw);
+                    return result;
+                }
+            }
 
-        ResultCode result = ApplyRelocation(relocation_target, relocation.type, relocation.addend,
-                                            symbol_address, relocation_target);
-        if (result.IsError()) {
-            LOG_ERROR(Service_LDR, "Error applying relocation {:08X}", result.raw);
-            return result;
+            batch_end = relocation.is_batch_end != 0;
+            relocation_address += sizeof(RelocationEntry);
         }
-
-        if (relocation.is_batch_end)
-            break;
-
-        relocation_address += sizeof(RelocationEntry);
     }
+    flush_run();
 
     RelocationEntry relocation;
     system.Memory().ReadBlock(process, batch, &relocation, sizeof(RelocationEntry));
@@ -195,6 +238,59 @@ VAddr CROHelper::FindExportNamedSymbol(const std::string& name) const {
     return SegmentTagToAddress(symbol_entry.symbol_position);
 }
 
+VAddr CROHelper::FindExportNamedSymbol(const std::string& name,
+                                       CROSymbolIndex& symbol_index) const {
+    const CROSymbolIndex::SymbolMap* symbols = symbol_index.Find(module_address);
+    if (!symbols) {
+        symbols = &symbol_index.Insert(module_address, ReadExportNamedSymbols());
+    }
+    const auto iter = symbols->find(name);
+    return iter != symbols->end() ? iter->second : 0;
+}
+
+CROSymbolIndex::SymbolMap CROHelper::ReadExportNamedSymbols() const {
+    CROSymbolIndex::SymbolMap symbols;
+
+    // Like FindExportNamedSymbol, nothing can be found without an export tree
+    u32 export_named_symbol_num = GetField(ExportNamedSymbolNum);
+    if (!GetField(ExportTreeNum) || export_named_symbol_num == 0)
+        return symbols;
+
+    std::vector<ExportNamedSymbolEntry> entries(export_named_symbol_num);
+    system.Memory().ReadBlock(process, GetField(ExportNamedSymbolTableOffset), entries.data(),
+                              entries.size() * sizeof(ExportNamedSymbolEntry));
+
+    VAddr export_strings_offset = GetField(ExportStringsOffset);
+    u32 export_strings_size = GetField(ExportStringsSize);
+    std::vector<char> export_strings(export_strings_size);
+    if (export_strings_size != 0) {
+        system.Memory().ReadBlock(process, export_strings_offset, export_strings.data(),
+                                  export_strings.size());
+    }
+
+    symbols.reserve(entries.size());
+    for (const ExportNamedSymbolEntry& entry : entries) {
+        if (entry.name_offset == 0)
+            continue;
+
+        std::string name;
+        const u32 string_offset = entry.name_offset - export_strings_offset;
+        const bool in_strings =
+            entry.name_offset >= export_strings_offset && string_offset < export_strings_size;
+        if (in_strings && std::memchr(export_strings.data() + string_offset, '\0',
+                                      export_strings_size - string_offset)) {
+            name.assign(export_strings.data() + string_offset);
+        } else {
+            // Unterminated names run past the strings, read them the same way the tree lookup does
+            name = system.Memory().ReadCString(entry.name_offset, export_strings_size);
+        }
+
+        // The export tree resolves duplicated names to the first entry
+        symbols.try_emplace(std::move(name), SegmentTagToAddress(entry.symbol_position));
+    }
+    return symbols;
+}
+
 ResultCode CROHelper::RebaseHeader(u32 cro_size) {
     ResultCode error = CROFormatError(0x11);
 
@@ -747,7 +843,7 @@ void CROHelper::UnrebaseHeader() {
     }
 }
 
-ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address) {
+ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address, CROSymbolIndex& symbol_index) {
     u32 import_strings_size = GetField(ImportStringsSize);
     u32 symbol_import_num = GetField(ImportNamedSymbolNum);
     for (u32 i = 0; i < symbol_import_num; ++i) {
@@ -759,11 +855,11 @@ ResultCode CROHelper::ApplyImportNamedSymbol(VAddr crs_address) {
                                   sizeof(ExternalRelocationEntry));
 
         if (!relocation_entry.is_batch_resolved) {
+            const std::string symbol_name =
+                system.Memory().ReadCString(entry.name_offset, import_strings_size);
             ResultCode result = ForEachAutoLinkCRO(
                 process, system, crs_address, [&](CROHelper source) -> ResultVal<bool> {
-                    std::string symbol_name =
-                        system.Memory().ReadCString(entry.name_offset, import_strings_size);
-                    u32 symbol_address = source.FindExportNamedSymbol(symbol_name);
+                    u32 symbol_address = source.FindExportNamedSymbol(symbol_name, symbol_index);
 
                     if (symbol_address != 0) {
                         LOG_TRACE(Service_LDR, "CRO \"{}\" imports \"{}\" from \"{}\"",
@@ -908,7 +1004,7 @@ ResultCode CROHelper::ApplyModuleImport(VAddr crs_address) {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
+ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target, CROSymbolIndex& symbol_index) {
     LOG_DEBUG(Service_LDR, "CRO \"{}\" exports named symbols to \"{}\"", ModuleName(),
               target.ModuleName());
     u32 target_import_strings_size = target.GetField(ImportStringsSize);
@@ -924,7 +1020,7 @@ ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
         if (!relocation_entry.is_batch_resolved) {
             std::string symbol_name =
                 system.Memory().ReadCString(entry.name_offset, target_import_strings_size);
-            u32 symbol_address = FindExportNamedSymbol(symbol_name);
+            u32 symbol_address = FindExportNamedSymbol(symbol_name, symbol_index);
             if (symbol_address != 0) {
                 LOG_TRACE(Service_LDR, "    exports symbol \"{}\"", symbol_name);
                 ResultCode result = target.ApplyRelocationBatch(relocation_addr, symbol_address);
@@ -938,7 +1034,7 @@ ResultCode CROHelper::ApplyExportNamedSymbol(CROHelper target) {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
+ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target, CROSymbolIndex& symbol_index) {
     LOG_DEBUG(Service_LDR, "CRO \"{}\" unexports named symbols to \"{}\"", ModuleName(),
               target.ModuleName());
     u32 unresolved_symbol = target.GetOnUnresolvedAddress();
@@ -955,7 +1051,7 @@ ResultCode CROHelper::ResetExportNamedSymbol(CROHelper target) {
         if (relocation_entry.is_batch_resolved) {
             std::string symbol_name =
                 system.Memory().ReadCString(entry.name_offset, target_import_strings_size);
-            u32 symbol_address = FindExportNamedSymbol(symbol_name);
+            u32 symbol_address = FindExportNamedSymbol(symbol_name, symbol_index);
             if (symbol_address != 0) {
                 LOG_TRACE(Service_LDR, "    unexports symbol \"{}\"", symbol_name);
                 ResultCode result =
@@ -1253,7 +1349,8 @@ ResultCode CROHelper::VerifyHash(u32 cro_size, VAddr crr) const {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
+ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix,
+                           CROSymbolIndex& symbol_index) {
     ResultCode result = RESULT_SUCCESS;
 
     {
@@ -1292,7 +1389,7 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
         });
 
         // Imports named symbols from other modules
-        result = ApplyImportNamedSymbol(crs_address);
+        result = ApplyImportNamedSymbol(crs_address, symbol_index);
         if (result.IsError()) {
             LOG_ERROR(Service_LDR, "Error applying symbol import {:08X}", result.raw);
             return result;
@@ -1308,8 +1405,9 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
 
     // Exports symbols to other modules
     result = ForEachAutoLinkCRO(process, system, crs_address,
-                                [this](CROHelper target) -> ResultVal<bool> {
-                                    ResultCode result = ApplyExportNamedSymbol(target);
+                                [&](CROHelper target) -> ResultVal<bool> {
+                                    ResultCode result =
+                                        ApplyExportNamedSymbol(target, symbol_index);
                                     if (result.IsError())
                                         return result;
 
@@ -1327,7 +1425,7 @@ ResultCode CROHelper::Link(VAddr crs_address, bool link_on_load_bug_fix) {
     return RESULT_SUCCESS;
 }
 
-ResultCode CROHelper::Unlink(VAddr crs_address) {
+ResultCode CROHelper::Unlink(VAddr crs_address, CROSymbolIndex& symbol_index) {
 
     // Resets all imported named symbols
     ResultCode result = ResetImportNamedSymbol();
@@ -1353,8 +1451,9 @@ ResultCode CROHelper::Unlink(VAddr crs_address) {
     // Resets all symbols in other modules imported from this module
     // Note: the RO service seems only searching in auto-link modules
     result = ForEachAutoLinkCRO(process, system, crs_address,
-                                [this](CROHelper target) -> ResultVal<bool> {
-                                    ResultCode result = ResetExportNamedSymbol(target);
+                                [&](CROHelper target) -> ResultVal<bool> {
+                                    ResultCode result =
+                                        ResetExportNamedSymbol(target, symbol_index);
                                     if (result.IsError())
                                         return result;
 
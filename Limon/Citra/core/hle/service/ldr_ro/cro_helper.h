@@ -5,7 +5,9 @@
 #pragma once
 
 #include <array>
+#include <string>
 #include <tuple>
+#include <unordered_map>
 #include "common/common_types.h"
 #include "common/swap.h"
 #include "core/hle/result.h"
@@ -29,6 +31,38 @@ namespace Service::LDR {
 static constexpr u32 CRO_HEADER_SIZE = 0x138;
 static constexpr u32 CRO_HASH_SIZE = 0x80;
 
+/**
+ * Host-side index of the named symbols exported by each loaded module, so that linking looks up
+ * imports in a hash map instead of walking the export tree in guest memory for every import and
+ * every module. The symbols of a module are indexed on first lookup, and must be invalidated when
+ * the module is unloaded or its export tables change.
+ */
+class CROSymbolIndex final {
+public:
+    using SymbolMap = std::unordered_map<std::string, VAddr>;
+
+    /// Returns the indexed symbols of the module at the given address, or nullptr if not indexed.
+    const SymbolMap* Find(VAddr module_address) const {
+        const auto iter = modules.find(module_address);
+        return iter != modules.end() ? &iter->second : nullptr;
+    }
+
+    const SymbolMap& Insert(VAddr module_address, SymbolMap symbols) {
+        return modules.insert_or_assign(module_address, std::move(symbols)).first->second;
+    }
+
+    void Invalidate(VAddr module_address) {
+        modules.erase(module_address);
+    }
+
+    void Clear() {
+        modules.clear();
+    }
+
+private:
+    std::unordered_map<VAddr, SymbolMap> modules;
+};
+
 /// Represents a loaded module (CRO) with interfaces manipulating it.
 class CROHelper final {
 public:
@@ -77,16 +111,18 @@ public:
      * Links this module with all registered auto-link module.
      * @param crs_address the virtual address of the static module
      * @param link_on_load_bug_fix true if links when loading and fixes the bug
+     * @param symbol_index the index of the symbols exported by the registered modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode Link(VAddr crs_address, bool link_on_load_bug_fix);
+    ResultCode Link(VAddr crs_address, bool link_on_load_bug_fix, CROSymbolIndex& symbol_index);
 
     /**
      * Unlinks this module with other modules.
      * @param crs_address the virtual address of the static module
+     * @param symbol_index the index of the symbols exported by the registered modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode Unlink(VAddr crs_address);
+    ResultCode Unlink(VAddr crs_address, CROSymbolIndex& symbol_index);
 
     /**
      * Clears all relocations to zero.
@@ -523,6 +559,18 @@ private:
      */
     VAddr FindExportNamedSymbol(const std::string& name) const;
 
+    /**
+     * Finds an exported named symbol in this module through the symbol index, indexing the
+     * symbols of this module if they aren't yet.
+     * @param name the name of the symbol to find
+     * @param symbol_index the index of the symbols exported by the registered modules
+     * @return VAddr the virtual address of the symbol; 0 if not found.
+     */
+    VAddr FindExportNamedSymbol(const std::string& name, CROSymbolIndex& symbol_index) const;
+
+    /// Reads all exported named symbols of this module, with the table and strings read in bulk.
+    CROSymbolIndex::SymbolMap ReadExportNamedSymbols() const;
+
     /**
      * Rebases offsets in module header according to module address.
      * @param cro_size the size of the CRO file
@@ -650,9 +698,10 @@ private:
      * Looks up all imported named symbols of this module in all registered auto-link modules, and
      * resolves them if found.
      * @param crs_address the virtual address of the static module
+     * @param symbol_index the index of the symbols exported by the registered modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ApplyImportNamedSymbol(VAddr crs_address);
+    ResultCode ApplyImportNamedSymbol(VAddr crs_address, CROSymbolIndex& symbol_index);
 
     /**
      * Resets all imported named symbols of this module to unresolved state.
@@ -683,16 +732,18 @@ private:
     /**
      * Resolves target module's imported named symbols that exported by this module.
      * @param target the module to resolve.
+     * @param symbol_index the index of the symbols exported by the registered modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ApplyExportNamedSymbol(CROHelper target);
+    ResultCode ApplyExportNamedSymbol(CROHelper target, CROSymbolIndex& symbol_index);
 
     /**
      * Resets target's named symbols imported from this module to unresolved state.
      * @param target the module to reset.
+     * @param symbol_index the index of the symbols exported by the registered modules
      * @returns ResultCode RESULT_SUCCESS on success, otherwise error code.
      */
-    ResultCode ResetExportNamedSymbol(CROHelper target);
+    ResultCode ResetExportNamedSymbol(CROHelper target, CROSymbolIndex& symbol_index);
 
     /**
      * Resolves imported indexed and anonymous symbols in the target module which imports this
@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <chrono>
 #include "common/alignment.h"
 #include "common/archives.h"
 #include "common/common_types.h"
@@ -19,6 +20,12 @@ SERIALIZE_EXPORT_IMPL(Service::LDR::ClientSlot)
 
 namespace Service::LDR {
 
+/// Returns the time elapsed since start in microseconds, used to report link times.
+static s64 MicrosecondsSince(std::chrono::steady_clock::time_point start) {
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
 static const ResultCode ERROR_ALREADY_INITIALIZED = // 0xD9612FF9
     ResultCode(ErrorDescription::AlreadyInitialized, ErrorModule::RO, ErrorSummary::Internal,
                ErrorLevel::Permanent);
@@ -138,6 +145,7 @@ void RO::Initialize(Kernel::HLERequestContext& ctx) {
     }
 
     slot->loaded_crs = crs_address;
+    slot->symbol_index.Clear();
 
     rb.Push(RESULT_SUCCESS);
 }
@@ -284,7 +292,12 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
         return;
     }
 
-    result = cro.Link(slot->loaded_crs, link_on_load_bug_fix);
+    // A module previously unloaded from this address may still be indexed if its loading failed
+    slot->symbol_index.Invalidate(cro_address);
+
+    const auto link_start = std::chrono::steady_clock::now();
+    result = cro.Link(slot->loaded_crs, link_on_load_bug_fix, slot->symbol_index);
+    const s64 link_time = MicrosecondsSince(link_start);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error linking CRO {:08X}", result.raw);
         process->Unmap(cro_address, cro_buffer_ptr, cro_size, Kernel::VMAPermission::ReadWrite,
@@ -297,6 +310,8 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
     cro.Register(slot->loaded_crs, auto_link);
 
     u32 fix_size = cro.Fix(fix_level);
+    // Fixing may drop the export tables of the module
+    slot->symbol_index.Invalidate(cro_address);
 
     if (fix_size != cro_size) {
         result = process->Unmap(cro_address + fix_size, cro_buffer_ptr + fix_size,
@@ -327,8 +342,8 @@ void RO::LoadCRO(Kernel::HLERequestContext& ctx, bool link_on_load_bug_fix) {
 
     system.InvalidateCacheRange(cro_address, cro_size);
 
-    LOG_INFO(Service_LDR, "CRO \"{}\" loaded at 0x{:08X}, fixed_end=0x{:08X}", cro.ModuleName(),
-             cro_address, cro_address + fix_size);
+    LOG_INFO(Service_LDR, "CRO \"{}\" loaded at 0x{:08X}, fixed_end=0x{:08X}, linked in {} us",
+             cro.ModuleName(), cro_address, cro_address + fix_size, link_time);
 
     rb.Push(RESULT_SUCCESS, fix_size);
 }
@@ -372,12 +387,16 @@ void RO::UnloadCRO(Kernel::HLERequestContext& ctx) {
 
     cro.Unregister(slot->loaded_crs);
 
-    ResultCode result = cro.Unlink(slot->loaded_crs);
+    const auto unlink_start = std::chrono::steady_clock::now();
+    ResultCode result = cro.Unlink(slot->loaded_crs, slot->symbol_index);
+    slot->symbol_index.Invalidate(cro_address);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error unlinking CRO {:08X}", result.raw);
         rb.Push(result);
         return;
     }
+    LOG_INFO(Service_LDR, "CRO \"{}\" unlinked in {} us", cro.ModuleName(),
+             MicrosecondsSince(unlink_start));
 
     // If the module is not fixed, clears all external/internal relocations
     // to restore the state before loading, so that it can be loaded again(?)
@@ -435,9 +454,13 @@ void RO::LinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_INFO(Service_LDR, "Linking CRO \"{}\"", cro.ModuleName());
 
-    ResultCode result = cro.Link(slot->loaded_crs, false);
+    const auto link_start = std::chrono::steady_clock::now();
+    ResultCode result = cro.Link(slot->loaded_crs, false, slot->symbol_index);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error linking CRO {:08X}", result.raw);
+    } else {
+        LOG_INFO(Service_LDR, "CRO \"{}\" linked in {} us", cro.ModuleName(),
+                 MicrosecondsSince(link_start));
     }
 
     rb.Push(result);
@@ -475,9 +498,13 @@ void RO::UnlinkCRO(Kernel::HLERequestContext& ctx) {
 
     LOG_INFO(Service_LDR, "Unlinking CRO \"{}\"", cro.ModuleName());
 
-    ResultCode result = cro.Unlink(slot->loaded_crs);
+    const auto unlink_start = std::chrono::steady_clock::now();
+    ResultCode result = cro.Unlink(slot->loaded_crs, slot->symbol_index);
     if (result.IsError()) {
         LOG_ERROR(Service_LDR, "Error unlinking CRO {:08X}", result.raw);
+    } else {
+        LOG_INFO(Service_LDR, "CRO \"{}\" unlinked in {} us", cro.ModuleName(),
+                 MicrosecondsSince(unlink_start));
     }
 
     rb.Push(result);
@@ -511,6 +538,7 @@ void RO::Shutdown(Kernel::HLERequestContext& ctx) {
     }
 
     slot->loaded_crs = 0;
+    slot->symbol_index.Clear();
     rb.Push(result);
 }
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "core/hle/service/ldr_ro/cro_helper.h"
 #include "core/hle/service/service.h"
 
 namespace Core {
@@ -15,6 +16,9 @@ namespace Service::LDR {
 struct ClientSlot : public Kernel::SessionRequestHandler::SessionDataBase {
     VAddr loaded_crs = 0; ///< the virtual address of the static module
 
+    /// Symbols exported by the loaded modules, rebuilt on demand so it isn't serialized
+    CROSymbolIndex symbol_index;
+
 private:
     template <class Archive>
     void serialize(Archive& ar, const unsigned int) {
@@ -2,7 +2,10 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <limits>
 #include <numeric>
 #include <type_traits>
 #include "common/alignment.h"
@@ -20,6 +23,7 @@
 #include "core/tracer/recorder.h"
 #include "video_core/command_processor.h"
 #include "video_core/debug_utils/debug_utils.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_base.h"
 #include "video_core/utils.h"
@@ -33,6 +37,91 @@ Memory::MemorySystem* g_memory;
 /// Event id for CoreTiming
 static Core::TimingEventType* vblank_event;
 
+/// Fence of the last frame presented by the GPU thread
+static u64 swap_fence;
+
+/// Fences of the GPU thread work whose completion isn't reported by the registers yet, or 0
+static std::array<u64, 2> memory_fill_fences;
+static u64 display_transfer_fence;
+static u64 command_list_fence;
+
+/**
+ * Executes the work of the emulated GPU on the GPU thread when there is one, so that it overlaps
+ * with CPU emulation, or right away otherwise. The work must not reference the registers, as they
+ * may be rewritten by the guest before it runs.
+ * @param range Physical memory the work reads or writes
+ * @returns The fence of the queued work, or 0 if it has already run
+ */
+template <typename Func>
+static u64 Submit(VideoCore::MemoryRange range, Func&& func) {
+    if (VideoCore::g_gpu_thread) {
+        return VideoCore::g_gpu_thread->Push(std::forward<Func>(func), range);
+    }
+    func();
+    return 0;
+}
+
+/// Returns the physical memory covering both the input and the output of a transfer.
+static VideoCore::MemoryRange GetTransferRange(const Regs::DisplayTransferConfig& config) {
+    const PAddr input_addr = config.GetPhysicalInputAddress();
+    const PAddr output_addr = config.GetPhysicalOutputAddress();
+    u64 input_size;
+    u64 output_size;
+    if (config.is_texture_copy) {
+        const u32 size = config.texture_copy.size;
+        // Every line is followed by a gap, a zero gap or width means a contiguous copy
+        const auto contiguous_size = [size](u32 width, u32 gap) -> u64 {
+            width *= 16;
+            gap *= 16;
+            return gap == 0 || width == 0 ? size : (size / width + 1) * u64{width + gap};
+        };
+        input_size = contiguous_size(config.texture_copy.input_width,
+                                     config.texture_copy.input_gap);
+        output_size = contiguous_size(config.texture_copy.output_width,
+                                      config.texture_copy.output_gap);
+    } else {
+        input_size = u64{config.input_width} * config.input_height *
+                     Regs::BytesPerPixel(config.input_format);
+        // The input width also covers the skewed output of flip_vertically with crop_input_lines
+        output_size = u64{std::max<u32>(config.input_width, config.output_width)} *
+                      config.output_height * Regs::BytesPerPixel(config.output_format);
+    }
+    const PAddr start = std::min(input_addr, output_addr);
+    const u64 end = std::max(input_addr + input_size, output_addr + output_size);
+    return {start, static_cast<u32>(std::min<u64>(end - start, std::numeric_limits<u32>::max()))};
+}
+
+void RetireCompletedWork() {
+    if (!VideoCore::g_gpu_thread) {
+        return;
+    }
+    const auto& gpu_thread = *VideoCore::g_gpu_thread;
+    for (std::size_t i = 0; i < memory_fill_fences.size(); ++i) {
+        if (memory_fill_fences[i] != 0 && gpu_thread.IsFenceSignaled(memory_fill_fences[i])) {
+            // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
+            g_regs.memory_fill_config[i].trigger.Assign(0);
+            g_regs.memory_fill_config[i].finished.Assign(1);
+            memory_fill_fences[i] = 0;
+        }
+    }
+    if (display_transfer_fence != 0 && gpu_thread.IsFenceSignaled(display_transfer_fence)) {
+        g_regs.display_transfer_config.trigger = 0;
+        display_transfer_fence = 0;
+    }
+    if (command_list_fence != 0 && gpu_thread.IsFenceSignaled(command_list_fence)) {
+        g_regs.command_processor_config.trigger = 0;
+        command_list_fence = 0;
+    }
+    g_memory->ApplyDeferredRasterizerMarks();
+}
+
+void Synchronize() {
+    if (VideoCore::g_gpu_thread) {
+        VideoCore::g_gpu_thread->Synchronize();
+        RetireCompletedWork();
+    }
+}
+
 template <typename T>
 inline void Read(T& var, const u32 raw_addr) {
     u32 addr = raw_addr - HW::VADDR_GPU;
@@ -44,6 +133,8 @@ inline void Read(T& var, const u32 raw_addr) {
         return;
     }
 
+    // The guest polls the trigger and finished bits to find out whether the GPU is done
+    RetireCompletedWork();
     var = g_regs[addr / 4];
 }
 
@@ -414,31 +505,39 @@ inline void Write(u32 addr, const T data) {
         auto& config = g_regs.memory_fill_config[is_second_filler];
 
         if (config.trigger) {
-            MemoryFill(config);
-            LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}", config.GetStartAddress(),
-                      config.GetEndAddress());
-
-            // It seems that it won't signal interrupt if "address_start" is zero.
-            // TODO: hwtest this
-            if (config.GetStartAddress() != 0) {
-                if (!is_second_filler) {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
-                } else {
-                    Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+            const VideoCore::MemoryRange fill_range{
+                config.GetStartAddress(), config.GetEndAddress() > config.GetStartAddress()
+                                              ? config.GetEndAddress() - config.GetStartAddress()
+                                              : 0};
+            const u64 fence = Submit(fill_range, [config = config, is_second_filler] {
+                MemoryFill(config);
+                LOG_TRACE(HW_GPU, "MemoryFill from {:#010X} to {:#010X}",
+                          config.GetStartAddress(), config.GetEndAddress());
+
+                // It seems that it won't signal interrupt if "address_start" is zero.
+                // TODO: hwtest this
+                if (config.GetStartAddress() != 0) {
+                    if (!is_second_filler) {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC0);
+                    } else {
+                        Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PSC1);
+                    }
                 }
-            }
+            });
 
-            // Reset "trigger" flag and set the "finish" flag
+            // Reset "trigger" flag and set the "finish" flag once the fill has completed
             // NOTE: This was confirmed to happen on hardware even if "address_start" is zero.
-            config.trigger.Assign(0);
-            config.finished.Assign(1);
+            if (fence == 0) {
+                config.trigger.Assign(0);
+                config.finished.Assign(1);
+            } else {
+                memory_fill_fences[is_second_filler] = fence;
+            }
         }
         break;
     }
 
     case GPU_REG_INDEX(display_transfer_config.trigger): {
-        MICROPROFILE_SCOPE(GPU_DisplayTransfer);
-
         const auto& config = g_regs.display_transfer_config;
         if (config.trigger & 1) {
 
@@ -446,28 +545,40 @@ inline void Write(u32 addr, const T data) {
                 Pica::g_debug_context->OnEvent(Pica::DebugContext::Event::IncomingDisplayTransfer,
                                                nullptr);
 
-            if (config.is_texture_copy) {
-                TextureCopy(config);
-                LOG_TRACE(HW_GPU,
-                          "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
-                          "{:#010X}({}+{}), flags {:#010X}",
-                          config.texture_copy.size, config.GetPhysicalInputAddress(),
-                          config.texture_copy.input_width * 16, config.texture_copy.input_gap * 16,
-                          config.GetPhysicalOutputAddress(), config.texture_copy.output_width * 16,
-                          config.texture_copy.output_gap * 16, config.flags);
+            const u64 fence = Submit(GetTransferRange(config), [config = config] {
+                MICROPROFILE_SCOPE(GPU_DisplayTransfer);
+
+                if (config.is_texture_copy) {
+                    TextureCopy(config);
+                    LOG_TRACE(HW_GPU,
+                              "TextureCopy: {:#X} bytes from {:#010X}({}+{})-> "
+                              "{:#010X}({}+{}), flags {:#010X}",
+                              config.texture_copy.size, config.GetPhysicalInputAddress(),
+                              config.texture_copy.input_width * 16,
+                              config.texture_copy.input_gap * 16,
+                              config.GetPhysicalOutputAddress(),
+                              config.texture_copy.output_width * 16,
+                              config.texture_copy.output_gap * 16, config.flags);
+                } else {
+                    DisplayTransfer(config);
+                    LOG_TRACE(HW_GPU,
+                              "DisplayTransfer: {:#010X}({}x{})-> "
+                              "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
+                              config.GetPhysicalInputAddress(), config.input_width.Value(),
+                              config.input_height.Value(), config.GetPhysicalOutputAddress(),
+                              config.output_width.Value(), config.output_height.Value(),
+                              static_cast<u32>(config.output_format.Value()), config.flags);
+                }
+
+                Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
+            });
+
+            // The trigger bit reads as set until the transfer has completed
+            if (fence == 0) {
+                g_regs.display_transfer_config.trigger = 0;
             } else {
-                DisplayTransfer(config);
-                LOG_TRACE(HW_GPU,
-                          "DisplayTransfer: {:#010X}({}x{})-> "
-                          "{:#010X}({}x{}), dst format {:x}, flags {:#010X}",
-                          config.GetPhysicalInputAddress(), config.input_width.Value(),
-                          config.input_height.Value(), config.GetPhysicalOutputAddress(),
-                          config.output_width.Value(), config.output_height.Value(),
-                          static_cast<u32>(config.output_format.Value()), config.flags);
+                display_transfer_fence = fence;
             }
-
-            g_regs.display_transfer_config.trigger = 0;
-            Service::GSP::SignalInterrupt(Service::GSP::InterruptId::PPF);
         }
         break;
     }
@@ -476,11 +587,19 @@ inline void Write(u32 addr, const T data) {
     case GPU_REG_INDEX(command_processor_config.trigger): {
         const auto& config = g_regs.command_processor_config;
         if (config.trigger & 1) {
-            MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
+            // Command lists may draw to and read from any memory
+            const u64 fence =
+                Submit({}, [address = config.GetPhysicalAddress(), size = config.size] {
+                    MICROPROFILE_SCOPE(GPU_CmdlistProcessing);
 
-            Pica::CommandProcessor::ProcessCommandList(config.GetPhysicalAddress(), config.size);
+                    Pica::CommandProcessor::ProcessCommandList(address, size);
+                });
 
-            g_regs.command_processor_config.trigger = 0;
+            if (fence == 0) {
+                g_regs.command_processor_config.trigger = 0;
+            } else {
+                command_list_fence = fence;
+            }
         }
         break;
     }
@@ -512,7 +631,24 @@ template void Write<u8>(u32 addr, const u8 data);
 
 /// Update hardware
 static void VBlankCallback(std::uintptr_t user_data, s64 cycles_late) {
-    VideoCore::g_renderer->SwapBuffers();
+    if (VideoCore::g_gpu_thread) {
+        // Let presentation overlap with the next frame, but not run further behind than that
+        VideoCore::g_gpu_thread->WaitForFence(swap_fence);
+        // Presentation only reads the framebuffers, and reading them after the guest has written
+        // new contents just presents those, so it doesn't hold back rasterizer flushes. The
+        // display registers are copied here, as the guest may reconfigure them meanwhile
+        swap_fence = VideoCore::g_gpu_thread->Push(
+            [frame = VideoCore::FrameConfig::Capture()] {
+                VideoCore::g_renderer->SwapBuffers(frame);
+            },
+            VideoCore::MemoryRange{0, 0});
+        RetireCompletedWork();
+    } else {
+        VideoCore::g_renderer->SwapBuffers(VideoCore::FrameConfig::Capture());
+    }
+    // Frame limiting, input polling and performance statistics follow the emulated frame, so they
+    // stay on this thread even when the GPU thread presents it
+    VideoCore::g_renderer->EndFrame();
 
     // Signal to GSP that GPU interrupt has occurred
     // TODO(yuriks): hwtest to determine if PDC0 is for the Top screen and PDC1 for the Sub
@@ -530,6 +666,10 @@ static void VBlankCallback(std::uintptr_t user_data, s64 cycles_late) {
 void Init(Memory::MemorySystem& memory) {
     g_memory = &memory;
     std::memset(&g_regs, 0, sizeof(g_regs));
+    swap_fence = 0;
+    memory_fill_fences = {};
+    display_transfer_fence = 0;
+    command_list_fence = 0;
 
     auto& framebuffer_top = g_regs.framebuffer_config[0];
     auto& framebuffer_sub = g_regs.framebuffer_config[1];
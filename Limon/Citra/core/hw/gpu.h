@@ -335,6 +335,15 @@ void Read(T& var, const u32 addr);
 template <typename T>
 void Write(u32 addr, const T data);
 
+/**
+ * Updates the registers reporting the completion of the work run on the GPU thread and applies
+ * the rasterizer cache changes it made to the page tables. Called on the emulation thread.
+ */
+void RetireCompletedWork();
+
+/// Waits for all work queued on the GPU thread and retires it.
+void Synchronize();
+
 /// Initialize hardware
 void Init(Memory::MemorySystem& memory);
 
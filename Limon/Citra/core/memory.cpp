@@ -3,7 +3,10 @@
 // Refer to the license.txt file included.
 
 #include <array>
+#include <atomic>
 #include <cstring>
+#include <limits>
+#include <mutex>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/binary_object.hpp>
 #include "audio_core/dsp_interface.h"
@@ -21,6 +24,7 @@
 #include "core/hle/service/plgldr/plgldr.h"
 #include "core/hw/hw.h"
 #include "core/memory.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/renderer_base.h"
 #include "video_core/video_core.h"
 
@@ -98,6 +102,16 @@ public:
     RasterizerCacheMarker cache_marker;
     std::vector<std::shared_ptr<PageTable>> page_table_list;
 
+    struct RasterizerMark {
+        PAddr start;
+        u32 size;
+        bool cached;
+    };
+    /// Cached region changes made on the GPU thread, in order, waiting for the emulation thread
+    std::mutex deferred_marks_mutex;
+    std::vector<RasterizerMark> deferred_marks;
+    std::atomic_bool has_deferred_marks{};
+
     AudioCore::DspInterface* dsp = nullptr;
 
     std::shared_ptr<BackingMem> fcram_mem;
@@ -305,11 +319,14 @@ private:
     void serialize(Archive& ar, const unsigned int file_version) {
         bool save_n3ds_ram = Settings::values.is_new_3ds.GetValue();
         ar& save_n3ds_ram;
-        ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
-        ar& boost::serialization::make_binary_object(
-            n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        // The rewind buffer keeps track of RAM contents on its own
+        if (system.IsSerializingRam()) {
+            ar& boost::serialization::make_binary_object(vram.get(), Memory::VRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                fcram.get(), save_n3ds_ram ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE);
+            ar& boost::serialization::make_binary_object(
+                n3ds_extra_ram.get(), save_n3ds_ram ? Memory::N3DS_EXTRA_RAM_SIZE : 0);
+        }
         ar& cache_marker;
         ar& page_table_list;
         // dsp is set from Core::System at startup
@@ -724,6 +741,34 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
         return;
     }
 
+    if (VideoCore::g_gpu_thread && VideoCore::g_gpu_thread->IsGPUThread()) {
+        // The emulation thread reads the page tables without locking, so it applies the change
+        // the next time it synchronizes with the GPU
+        std::scoped_lock lock{impl->deferred_marks_mutex};
+        impl->deferred_marks.push_back({start, size, cached});
+        impl->has_deferred_marks.store(true, std::memory_order_release);
+        return;
+    }
+    MarkRegionCached(start, size, cached);
+}
+
+void MemorySystem::ApplyDeferredRasterizerMarks() {
+    if (!impl->has_deferred_marks.load(std::memory_order_acquire)) {
+        return;
+    }
+    std::vector<Impl::RasterizerMark> marks;
+    {
+        std::scoped_lock lock{impl->deferred_marks_mutex};
+        marks.swap(impl->deferred_marks);
+        impl->has_deferred_marks.store(false, std::memory_order_relaxed);
+    }
+    for (const auto& mark : marks) {
+        MarkRegionCached(mark.start, mark.size, mark.cached);
+    }
+}
+
+void MemorySystem::MarkRegionCached(PAddr start, u32 size, bool cached) {
+
     u32 num_pages = ((start + size - 1) >> CITRA_PAGE_BITS) - (start >> CITRA_PAGE_BITS) + 1;
     PAddr paddr = start;
 
@@ -769,12 +814,28 @@ void MemorySystem::RasterizerMarkRegionCached(PAddr start, u32 size, bool cached
     }
 }
 
+/**
+ * Runs the rasterizer operation on the GPU thread when there is one, once the queued work that
+ * accesses the physical region has completed, and waits for it so that guest memory is coherent
+ * on return. Work queued for other regions doesn't have to complete first.
+ */
+template <typename Func>
+static void RunOnRasterizer(PAddr start, u32 size, Func&& func) {
+    if (!VideoCore::g_gpu_thread || VideoCore::g_gpu_thread->IsGPUThread()) {
+        func();
+        return;
+    }
+    auto& gpu_thread = *VideoCore::g_gpu_thread;
+    gpu_thread.RunSyncAfter(gpu_thread.GetRegionFence(start, size), [&func] { func(); });
+}
+
 void RasterizerFlushRegion(PAddr start, u32 size) {
     if (VideoCore::g_renderer == nullptr) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size);
+    RunOnRasterizer(start, size,
+                    [&] { VideoCore::g_renderer->Rasterizer()->FlushRegion(start, size); });
 }
 
 void RasterizerInvalidateRegion(PAddr start, u32 size) {
@@ -782,7 +843,8 @@ void RasterizerInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size);
+    RunOnRasterizer(start, size,
+                    [&] { VideoCore::g_renderer->Rasterizer()->InvalidateRegion(start, size); });
 }
 
 void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
@@ -792,7 +854,9 @@ void RasterizerFlushAndInvalidateRegion(PAddr start, u32 size) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    RunOnRasterizer(start, size, [&] {
+        VideoCore::g_renderer->Rasterizer()->FlushAndInvalidateRegion(start, size);
+    });
 }
 
 void RasterizerClearAll(bool flush) {
@@ -802,7 +866,17 @@ void RasterizerClearAll(bool flush) {
         return;
     }
 
-    VideoCore::g_renderer->Rasterizer()->ClearAll(flush);
+    RunOnRasterizer(0, std::numeric_limits<u32>::max(),
+                    [&] { VideoCore::g_renderer->Rasterizer()->ClearAll(flush); });
+}
+
+void RasterizerFlushAll() {
+    if (VideoCore::g_renderer == nullptr) {
+        return;
+    }
+
+    RunOnRasterizer(0, std::numeric_limits<u32>::max(),
+                    [&] { VideoCore::g_renderer->Rasterizer()->FlushAll(); });
 }
 
 void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
@@ -814,6 +888,8 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
 
     VAddr end = start + size;
 
+    std::array<std::pair<PAddr, u32>, 4> regions;
+    std::size_t num_regions = 0;
     auto CheckRegion = [&](VAddr region_start, VAddr region_end, PAddr paddr_region_start) {
         if (start >= region_end || end <= region_start) {
             // No overlap with region
@@ -824,19 +900,7 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
         VAddr overlap_end = std::min(end, region_end);
         PAddr physical_start = paddr_region_start + (overlap_start - region_start);
         u32 overlap_size = overlap_end - overlap_start;
-
-        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
-        switch (mode) {
-        case FlushMode::Flush:
-            rasterizer->FlushRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::Invalidate:
-            rasterizer->InvalidateRegion(physical_start, overlap_size);
-            break;
-        case FlushMode::FlushAndInvalidate:
-            rasterizer->FlushAndInvalidateRegion(physical_start, overlap_size);
-            break;
-        }
+        regions[num_regions++] = {physical_start, overlap_size};
     };
 
     CheckRegion(LINEAR_HEAP_VADDR, LINEAR_HEAP_VADDR_END, FCRAM_PADDR);
@@ -845,6 +909,34 @@ void RasterizerFlushVirtualRegion(VAddr start, u32 size, FlushMode mode) {
     if (Service::PLGLDR::PLG_LDR::GetPluginFBAddr())
         CheckRegion(PLUGIN_3GX_FB_VADDR, PLUGIN_3GX_FB_VADDR_END,
                     Service::PLGLDR::PLG_LDR::GetPluginFBAddr());
+    if (num_regions == 0) {
+        return;
+    }
+
+    // Wait for the queued GPU work touching any of the physical regions
+    PAddr physical_start = regions[0].first;
+    u64 physical_end = u64{regions[0].first} + regions[0].second;
+    for (std::size_t i = 1; i < num_regions; ++i) {
+        physical_start = std::min(physical_start, regions[i].first);
+        physical_end = std::max(physical_end, u64{regions[i].first} + regions[i].second);
+    }
+    RunOnRasterizer(physical_start, static_cast<u32>(physical_end - physical_start), [&] {
+        auto* rasterizer = VideoCore::g_renderer->Rasterizer();
+        for (std::size_t i = 0; i < num_regions; ++i) {
+            const auto [physical_address, overlap_size] = regions[i];
+            switch (mode) {
+            case FlushMode::Flush:
+                rasterizer->FlushRegion(physical_address, overlap_size);
+                break;
+            case FlushMode::Invalidate:
+                rasterizer->InvalidateRegion(physical_address, overlap_size);
+                break;
+            case FlushMode::FlushAndInvalidate:
+                rasterizer->FlushAndInvalidateRegion(physical_address, overlap_size);
+                break;
+            }
+        }
+    });
 }
 
 u8 MemorySystem::Read8(const VAddr addr) {
@@ -1087,6 +1179,18 @@ MemoryRef MemorySystem::GetFCRAMRef(std::size_t offset) const {
     return MemoryRef(impl->fcram_mem, offset);
 }
 
+std::vector<std::span<u8>> MemorySystem::GetRamRegions() {
+    const bool is_new_3ds = Settings::values.is_new_3ds.GetValue();
+    std::vector<std::span<u8>> regions{
+        {impl->vram.get(), Memory::VRAM_SIZE},
+        {impl->fcram.get(), is_new_3ds ? Memory::FCRAM_N3DS_SIZE : Memory::FCRAM_SIZE},
+    };
+    if (is_new_3ds) {
+        regions.emplace_back(impl->n3ds_extra_ram.get(), Memory::N3DS_EXTRA_RAM_SIZE);
+    }
+    return regions;
+}
+
 void MemorySystem::SetDSP(AudioCore::DspInterface& dsp) {
     impl->dsp = &dsp;
 }
@@ -5,7 +5,9 @@
 #pragma once
 #include <array>
 #include <cstddef>
+#include <span>
 #include <string>
+#include <vector>
 #include <boost/serialization/array.hpp>
 #include <boost/serialization/vector.hpp>
 #include "common/common_types.h"
@@ -283,6 +285,9 @@ enum class FlushMode {
  */
 void RasterizerClearAll(bool flush);
 
+/// Writes back all modified rasterizer cache resources to RAM without removing them from the cache
+void RasterizerFlushAll();
+
 /**
  * Flushes and invalidates any externally cached rasterizer resources touching the given virtual
  * address region.
@@ -576,9 +581,15 @@ public:
      * @param size   The size of the address range in bytes.
      * @param cached Whether or not any pages within the address range should be
      *               marked as cached or uncached.
+     *
+     * When called on the GPU thread the change is recorded instead, and applied to the page
+     * tables by the emulation thread through ApplyDeferredRasterizerMarks.
      */
     void RasterizerMarkRegionCached(PAddr start, u32 size, bool cached);
 
+    /// Applies the cached region changes recorded on the GPU thread, on the emulation thread.
+    void ApplyDeferredRasterizerMarks();
+
     /// For a rasterizer-accessible PAddr, gets a list of all possible VAddr
     std::vector<VAddr> PhysicalToVirtualAddressForRasterizer(PAddr addr);
 
@@ -606,6 +617,9 @@ public:
     /// Gets a serializable ref to FCRAM with the given offset
     MemoryRef GetFCRAMRef(std::size_t offset) const;
 
+    /// Gets the VRAM, FCRAM and (on New 3DS) extra RAM blocks, in the order they are serialized
+    std::vector<std::span<u8>> GetRamRegions();
+
     /// Registers page table for rasterizer cache marking
     void RegisterPageTable(std::shared_ptr<PageTable> page_table);
 
@@ -632,6 +646,9 @@ private:
      */
     MemoryRef GetPointerForRasterizerCache(VAddr addr) const;
 
+    /// Switches the page types of the region between cached and uncached in all page tables.
+    void MarkRegionCached(PAddr start, u32 size, bool cached);
+
     void MapPages(PageTable& page_table, u32 base, u32 size, MemoryRef memory, PageType type);
 
 private:
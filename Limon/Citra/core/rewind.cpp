@@ -0,0 +1,324 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <sstream>
+#include <boost/iostreams/device/back_inserter.hpp>
+#include <boost/iostreams/stream.hpp>
+#include "common/archives.h"
+#include "common/dirty_page_tracker.h"
+#include "common/logging/log.h"
+#include "common/microprofile.h"
+#include "common/scope_exit.h"
+#include "common/settings.h"
+#include "common/zstd_compression.h"
+#include "core/core.h"
+#include "core/hw/gpu.h"
+#include "core/memory.h"
+#include "core/rewind.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
+
+namespace Core {
+
+namespace {
+// An entry is compressed every frame, so favour speed over ratio
+constexpr s32 CompressionLevel = 1;
+} // Anonymous namespace
+
+MICROPROFILE_DEFINE(Core_RewindCapture, "Core", "Rewind Capture", MP_RGB(160, 96, 224));
+
+RewindBuffer::RewindBuffer(System& system_)
+    : system{system_},
+      frame_interval{std::max(Settings::values.rewind_frame_interval.GetValue(), 1U)} {}
+
+RewindBuffer::~RewindBuffer() {
+    compressor.WaitForRequests();
+    ReleaseRam();
+}
+
+void RewindBuffer::CaptureFrame() {
+    if (capture_failed || !VideoCore::g_renderer) {
+        return;
+    }
+    // The frame counter starts over with the renderer, e.g. after a state was loaded
+    const s32 frame = VideoCore::g_renderer->GetCurrentFrame();
+    if (frame >= last_frame && frame - last_frame < static_cast<s64>(frame_interval)) {
+        return;
+    }
+    last_frame = frame;
+
+    MICROPROFILE_SCOPE(Core_RewindCapture);
+    CollectCompressed();
+    if (capture_failed) {
+        return;
+    }
+    try {
+        RawEntry raw = Capture();
+        ++pending_entries;
+        compressor.QueueWork([this, raw = std::move(raw)]() mutable {
+            try {
+                Entry entry = Compress(std::move(raw));
+                std::scoped_lock lock{compressed_mutex};
+                compressed.push_back(std::move(entry));
+            } catch (const std::exception& e) {
+                LOG_ERROR(Core, "Unable to compress rewind state: {}", e.what());
+                compression_failed = true;
+            }
+        });
+    } catch (const std::exception& e) {
+        LOG_ERROR(Core, "Unable to record rewind state, rewind is disabled: {}", e.what());
+        capture_failed = true;
+        Clear();
+    }
+}
+
+void RewindBuffer::CollectCompressed() {
+    {
+        std::scoped_lock lock{compressed_mutex};
+        for (auto& entry : compressed) {
+            total_size += entry.Size();
+            entries.push_back(std::move(entry));
+        }
+        pending_entries -= compressed.size();
+        compressed.clear();
+    }
+    if (compression_failed) {
+        // Later entries can't be applied without the lost one
+        LOG_ERROR(Core, "Rewind is disabled");
+        capture_failed = true;
+        Clear();
+        return;
+    }
+
+    // Always keep the newest entry, it is needed to rebuild RAM backwards
+    const std::size_t budget =
+        static_cast<std::size_t>(Settings::values.rewind_memory_budget.GetValue()) * 1024 * 1024;
+    while (total_size > budget && entries.size() > 1) {
+        total_size -= entries.front().Size();
+        entries.pop_front();
+    }
+}
+
+void RewindBuffer::WaitForCompression() {
+    compressor.WaitForRequests();
+    CollectCompressed();
+}
+
+RewindBuffer::RawEntry RewindBuffer::Capture() {
+    RawEntry entry;
+    {
+        // Serialize straight into the entry instead of copying a string stream's buffer
+        boost::iostreams::stream<boost::iostreams::back_insert_device<std::vector<char>>> stream{
+            entry.state};
+        {
+            system.serializing_ram = false;
+            SCOPE_EXIT({ system.serializing_ram = true; });
+            oarchive oa{stream};
+            oa& system;
+        }
+        stream.flush();
+    }
+
+    if (trackers.empty()) {
+        // Trackers that were never armed report all of RAM as written
+        AttachRam();
+    }
+    bool layout_changed = shadow.size() != regions.size();
+    for (std::size_t i = 0; !layout_changed && i < regions.size(); ++i) {
+        layout_changed = shadow[i].size() != regions[i].size();
+    }
+    if (layout_changed) {
+        WaitForCompression();
+        entries.clear();
+        total_size = 0;
+    }
+
+    const bool first_entry = entries.empty() && pending_entries == 0;
+    if (first_entry) {
+        // The oldest entry's delta is never applied, so the first one only needs the shadow
+        shadow.resize(regions.size());
+        for (std::size_t i = 0; i < regions.size(); ++i) {
+            shadow[i].assign(regions[i].begin(), regions[i].end());
+        }
+        for (auto& tracker : trackers) {
+            tracker->Arm();
+        }
+    } else {
+        std::size_t delta_size = 0;
+        for (u32 i = 0; i < trackers.size(); ++i) {
+            // Written pages are re-armed as they are collected, before RAM is read below, so any
+            // write made from here on belongs to this entry or the next one
+            trackers[i]->CollectDirtyRanges([&](std::size_t offset, std::size_t size) {
+                entry.ranges.push_back({i, static_cast<u32>(offset), static_cast<u32>(size)});
+                delta_size += size;
+            });
+        }
+
+        entry.delta.resize(delta_size);
+        u8* out = entry.delta.data();
+        for (const auto& range : entry.ranges) {
+            const u8* current = regions[range.region].data() + range.offset;
+            u8* previous = shadow[range.region].data() + range.offset;
+            for (u32 i = 0; i < range.size; ++i) {
+                out[i] = current[i] ^ previous[i];
+            }
+            std::memcpy(previous, current, range.size);
+            out += range.size;
+        }
+    }
+
+    const u64 keyframe_interval =
+        static_cast<u64>(Settings::values.rewind_keyframe_interval.GetValue() *
+                         GPU::SCREEN_REFRESH_RATE / frame_interval);
+    if (first_entry || entries_since_keyframe >= keyframe_interval) {
+        // The shadow changes with the next capture, so the worker compresses a copy of it
+        entry.keyframe = shadow;
+        entries_since_keyframe = 0;
+    } else {
+        ++entries_since_keyframe;
+    }
+    return entry;
+}
+
+RewindBuffer::Entry RewindBuffer::Compress(RawEntry raw) {
+    Entry entry;
+    entry.state = Common::Compression::CompressDataZSTD(
+        {reinterpret_cast<const u8*>(raw.state.data()), raw.state.size()}, CompressionLevel);
+    entry.ranges = std::move(raw.ranges);
+    entry.delta = Common::Compression::CompressDataZSTD(raw.delta, CompressionLevel);
+
+    if (!raw.keyframe.empty()) {
+        std::vector<std::span<const u8>> sources(raw.keyframe.begin(), raw.keyframe.end());
+        const bool compressed = Common::Compression::CompressDataZSTDStream(
+            sources, CompressionLevel, [&entry](std::span<const u8> data) {
+                entry.keyframe.insert(entry.keyframe.end(), data.begin(), data.end());
+                return true;
+            });
+        if (!compressed) {
+            throw std::runtime_error("Could not compress rewind keyframe");
+        }
+    }
+    return entry;
+}
+
+void RewindBuffer::ApplyDelta(const Entry& entry) {
+    const std::vector<u8> delta = Common::Compression::DecompressDataZSTD(entry.delta);
+    const u8* in = delta.data();
+    for (const auto& range : entry.ranges) {
+        u8* previous = shadow[range.region].data() + range.offset;
+        for (u32 i = 0; i < range.size; ++i) {
+            previous[i] ^= in[i];
+        }
+        in += range.size;
+    }
+}
+
+void RewindBuffer::LoadKeyframe(const Entry& entry) {
+    const std::vector<u8> ram = Common::Compression::DecompressDataZSTD(entry.keyframe);
+    const u8* in = ram.data();
+    for (auto& region : shadow) {
+        std::memcpy(region.data(), in, region.size());
+        in += region.size();
+    }
+}
+
+bool RewindBuffer::StepBack(u32 frames) {
+    WaitForCompression();
+    if (entries.empty()) {
+        return false;
+    }
+    const std::size_t newest = entries.size() - 1;
+    const std::size_t steps = (frames + frame_interval - 1) / frame_interval;
+    const std::size_t target = newest - std::min(steps, newest);
+
+    std::optional<std::size_t> keyframe;
+    for (std::size_t i = target + 1; i-- > 0;) {
+        if (!entries[i].keyframe.empty()) {
+            keyframe = i;
+            break;
+        }
+    }
+
+    // Rebuild RAM from whichever side needs fewer deltas
+    if (keyframe && target - *keyframe < newest - target) {
+        LoadKeyframe(entries[*keyframe]);
+        for (std::size_t i = *keyframe + 1; i <= target; ++i) {
+            ApplyDelta(entries[i]);
+        }
+    } else {
+        for (std::size_t i = newest; i > target; --i) {
+            ApplyDelta(entries[i]);
+        }
+    }
+
+    ReleaseRam();
+    {
+        const std::vector<u8> archive =
+            Common::Compression::DecompressDataZSTD(entries[target].state);
+        std::istringstream sstream{
+            std::string{reinterpret_cast<const char*>(archive.data()), archive.size()},
+            std::ios_base::binary};
+        system.serializing_ram = false;
+        SCOPE_EXIT({ system.serializing_ram = true; });
+        iarchive ia{sstream};
+        ia& system;
+    }
+
+    AttachRam();
+    if (regions.size() != shadow.size()) {
+        throw std::runtime_error("Guest RAM layout changed since the rewind state was recorded");
+    }
+    for (std::size_t i = 0; i < regions.size(); ++i) {
+        if (regions[i].size() != shadow[i].size()) {
+            throw std::runtime_error(
+                "Guest RAM layout changed since the rewind state was recorded");
+        }
+        std::memcpy(regions[i].data(), shadow[i].data(), shadow[i].size());
+    }
+    for (auto& tracker : trackers) {
+        tracker->Arm();
+    }
+
+    while (entries.size() > target + 1) {
+        total_size -= entries.back().Size();
+        entries.pop_back();
+    }
+    entries_since_keyframe = keyframe ? target - *keyframe : 0;
+    last_frame = VideoCore::g_renderer ? VideoCore::g_renderer->GetCurrentFrame() : -1;
+    return true;
+}
+
+void RewindBuffer::Clear() {
+    compressor.WaitForRequests();
+    {
+        std::scoped_lock lock{compressed_mutex};
+        compressed.clear();
+    }
+    pending_entries = 0;
+    compression_failed = false;
+    ReleaseRam();
+    entries.clear();
+    shadow.clear();
+    total_size = 0;
+    entries_since_keyframe = 0;
+    last_frame = -1;
+}
+
+void RewindBuffer::ReleaseRam() {
+    trackers.clear();
+    regions.clear();
+}
+
+void RewindBuffer::AttachRam() {
+    regions = system.Memory().GetRamRegions();
+    trackers.clear();
+    for (const auto& region : regions) {
+        trackers.push_back(std::make_unique<Common::DirtyPageTracker>(region));
+    }
+}
+
+} // namespace Core
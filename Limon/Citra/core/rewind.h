@@ -0,0 +1,140 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+#include "common/common_types.h"
+#include "common/thread_worker.h"
+
+namespace Common {
+class DirtyPageTracker;
+}
+
+namespace Core {
+
+class System;
+
+/**
+ * In-memory ring of the most recent emulation states, one every few presented frames, that can be
+ * stepped back through. Recording a state flushes the rasterizer caches to guest RAM, so states
+ * are only recorded every rewind_frame_interval frames.
+ *
+ * Each entry holds the compressed savestate archive of the system without guest RAM, plus the
+ * guest RAM pages written since the previous entry as a compressed XOR delta. Applying an entry's
+ * delta to the RAM of that entry yields the RAM of the previous entry and vice versa, so RAM can
+ * be rebuilt backwards from the newest entry or forwards from a keyframe, which stores a full copy
+ * of guest RAM and is recorded every few seconds. Written pages are found by write-protecting
+ * guest RAM instead of comparing it against the previous frame.
+ *
+ * The emulation thread only serializes the system, gathers the written RAM and, for keyframes,
+ * copies the RAM shadow; entries are compressed on a worker thread and join the ring afterwards.
+ */
+class RewindBuffer {
+public:
+    explicit RewindBuffer(System& system);
+    ~RewindBuffer();
+
+    RewindBuffer(const RewindBuffer&) = delete;
+    RewindBuffer& operator=(const RewindBuffer&) = delete;
+
+    /// Records the current state if enough frames have been presented since the last capture.
+    void CaptureFrame();
+
+    /**
+     * Restores the newest state recorded at least the given number of frames ago, clamped to the
+     * oldest recorded state, and discards every newer state.
+     * @returns false if nothing has been recorded yet.
+     */
+    bool StepBack(u32 frames);
+
+    /// Discards all recorded states.
+    void Clear();
+
+    /// Stops tracking guest RAM, which must be called before it is freed. Recorded states are kept.
+    void ReleaseRam();
+
+    /// Returns the number of frames that can currently be stepped back.
+    [[nodiscard]] std::size_t GetFrameCount() const {
+        const std::size_t count = entries.size() + pending_entries;
+        return count == 0 ? 0 : (count - 1) * frame_interval;
+    }
+
+private:
+    struct RamRange {
+        u32 region;
+        u32 offset;
+        u32 size;
+    };
+
+    struct Entry {
+        std::vector<u8> state;        ///< Compressed system archive without guest RAM
+        std::vector<RamRange> ranges; ///< Guest RAM written since the previous entry
+        std::vector<u8> delta;        ///< Compressed XOR of ranges against the previous entry
+        std::vector<u8> keyframe;     ///< Compressed copy of all guest RAM, may be empty
+
+        std::size_t Size() const {
+            return state.size() + ranges.size() * sizeof(RamRange) + delta.size() +
+                   keyframe.size();
+        }
+    };
+
+    /// Entry as captured on the emulation thread, before compression
+    struct RawEntry {
+        std::vector<char> state;               ///< System archive without guest RAM
+        std::vector<RamRange> ranges;          ///< Guest RAM written since the previous entry
+        std::vector<u8> delta;                 ///< XOR of ranges against the previous entry
+        std::vector<std::vector<u8>> keyframe; ///< Copy of all guest RAM, may be empty
+    };
+
+    /// Serializes everything except guest RAM and brings the RAM shadow up to date.
+    RawEntry Capture();
+
+    /// Compresses a captured entry, called on the worker thread.
+    static Entry Compress(RawEntry raw);
+
+    /// Moves the entries compressed by the worker into the ring and applies the memory budget.
+    void CollectCompressed();
+
+    /// Waits for the worker to compress all captured entries and collects them.
+    void WaitForCompression();
+
+    /// Applies the XOR delta of an entry to the RAM shadow.
+    void ApplyDelta(const Entry& entry);
+
+    /// Replaces the RAM shadow with the keyframe of an entry.
+    void LoadKeyframe(const Entry& entry);
+
+    /// Starts tracking writes to the guest RAM of the running system.
+    void AttachRam();
+
+    System& system;
+    /// Presented frames between two recorded states
+    const u32 frame_interval;
+
+    std::deque<Entry> entries;
+    std::size_t total_size = 0;
+    u64 entries_since_keyframe = 0;
+    s32 last_frame = -1;
+    bool capture_failed = false;
+
+    std::vector<std::span<u8>> regions;
+    std::vector<std::unique_ptr<Common::DirtyPageTracker>> trackers;
+    /// Guest RAM as of the newest entry
+    std::vector<std::vector<u8>> shadow;
+
+    std::size_t pending_entries = 0; ///< Entries captured but not collected yet
+    std::mutex compressed_mutex;
+    std::vector<Entry> compressed; ///< Entries compressed by the worker, in capture order
+    std::atomic_bool compression_failed{};
+    /// Compresses the captured entries in order. Declared last so it stops before the rest is freed
+    Common::ThreadWorker compressor{1, "RewindCompress"};
+};
+
+} // namespace Core
@@ -3,7 +3,8 @@
 // Refer to the license.txt file included.
 
 #include <chrono>
-#include <sstream>
+#include <istream>
+#include <streambuf>
 #include <cryptopp/hex.h>
 #include <fmt/format.h>
 #include "common/archives.h"
@@ -11,15 +12,28 @@
 #include "common/logging/log.h"
 #include "common/scm_rev.h"
 #include "common/swap.h"
+#include "common/thread_worker.h"
 #include "common/zstd_compression.h"
 #include "core/core.h"
 #include "core/movie.h"
+#include "core/rewind.h"
 #include "core/savestate.h"
 #include "core/savestate_data.h"
 #include "network/network.h"
 
 namespace Core {
 
+/// Layout of the compressed archive following the header
+enum class CSTFormat : u32 {
+    SingleFrame = 0, ///< One ZSTD frame, written by builds before frame indices were introduced
+    Frames = 1,      ///< Independent ZSTD frames listed in the header
+};
+
+/// Maximum number of frames that fit in the header
+constexpr std::size_t CSTMaxFrames = 43;
+/// Smallest decompressed frame size, so that small states don't lose compression ratio
+constexpr std::size_t CSTMinFrameSize = 1024 * 1024;
+
 #pragma pack(push, 1)
 struct CSTHeader {
     std::array<u8, 4> filetype;    /// Unique Identifier to check the file type (always "CST"0x1B)
@@ -29,13 +43,76 @@ struct CSTHeader {
     std::array<u8, 20> build_name; /// The build name (Canary/Nightly) with the version number
     u32_le zero = 0;               /// Should be zero, just in case.
 
-    std::array<u8, 192> reserved{}; /// Make heading 256 bytes so it has consistent size
+    // These used to be reserved bytes, which were always zero
+    u32_le format{};            /// Layout of the compressed archive (CSTFormat)
+    u32_le frame_count{};       /// Number of frames of the archive
+    u32_le frame_size{};        /// Decompressed size of every frame but the last one
+    u64_le decompressed_size{}; /// Decompressed size of the archive
+    std::array<u32_le, CSTMaxFrames> compressed_frame_sizes{}; /// Compressed size of each frame
 };
 static_assert(sizeof(CSTHeader) == 256, "CSTHeader should be 256 bytes");
 #pragma pack(pop)
 
 constexpr std::array<u8, 4> header_magic_bytes{{'C', 'S', 'T', 0x1B}};
 
+/**
+ * Output buffer for the savestate archive. Unlike std::stringbuf it never reallocates and copies
+ * what was already written: small writes are packed into fixed-size chunks and large writes, which
+ * are the binary objects of FCRAM, VRAM and DSP memory, are copied once into their own segment.
+ * This makes serializing cheap enough to run on the emulation thread, while the segments can be
+ * compressed on a worker thread after emulation has resumed.
+ */
+class SnapshotStreamBuf final : public std::streambuf {
+public:
+    std::vector<std::span<const u8>> Segments() const {
+        std::vector<std::span<const u8>> result;
+        result.reserve(segments.size());
+        for (const auto& segment : segments) {
+            result.emplace_back(segment.data(), segment.size());
+        }
+        return result;
+    }
+
+    std::size_t Size() const {
+        return size;
+    }
+
+protected:
+    std::streamsize xsputn(const char_type* s, std::streamsize n) override {
+        const auto data = reinterpret_cast<const u8*>(s);
+        const auto count = static_cast<std::size_t>(n);
+        if (count >= LargeWriteSize) {
+            segments.emplace_back(data, data + count);
+            chunk_open = false;
+        } else {
+            if (!chunk_open || segments.back().size() + count > ChunkSize) {
+                segments.emplace_back().reserve(ChunkSize);
+                chunk_open = true;
+            }
+            segments.back().insert(segments.back().end(), data, data + count);
+        }
+        size += count;
+        return n;
+    }
+
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) {
+            return traits_type::not_eof(ch);
+        }
+        const char_type c = traits_type::to_char_type(ch);
+        xsputn(&c, 1);
+        return ch;
+    }
+
+private:
+    static constexpr std::size_t ChunkSize = 1024 * 1024;
+    static constexpr std::size_t LargeWriteSize = 64 * 1024;
+
+    std::vector<std::vector<u8>> segments;
+    std::size_t size = 0;
+    bool chunk_open = false;
+};
+
 static std::string GetSaveStatePath(u64 program_id, u64 movie_id, u32 slot) {
     if (movie_id) {
         return fmt::format("{}{:016X}.movie{:016X}.{:02d}.cst",
@@ -121,26 +198,16 @@ std::vector<SaveStateInfo> ListSaveStates(u64 program_id, u64 movie_id) {
     return result;
 }
 
-void System::SaveState(u32 slot) const {
-    std::ostringstream sstream{std::ios_base::binary};
-    // Serialize
-    oarchive oa{sstream};
-    oa&* this;
-
-    const std::string& str{sstream.str()};
-    const auto data = std::span<const u8>{reinterpret_cast<const u8*>(str.data()), str.size()};
-    auto buffer = Common::Compression::CompressDataZSTDDefault(data);
+void System::SaveState(u32 slot) {
+    // Serialize. This is the only part that needs the emulation thread to be stopped.
+    auto snapshot = std::make_shared<SnapshotStreamBuf>();
+    {
+        oarchive oa{*snapshot};
+        oa&* this;
+    }
 
     const u64 movie_id = movie.GetCurrentMovieID();
     const auto path = GetSaveStatePath(title_id, movie_id, slot);
-    if (!FileUtil::CreateFullPath(path)) {
-        throw std::runtime_error("Could not create path " + path);
-    }
-
-    FileUtil::IOFile file(path, "wb");
-    if (!file) {
-        throw std::runtime_error("Could not open file " + path);
-    }
 
     CSTHeader header{};
     header.filetype = header_magic_bytes;
@@ -157,10 +224,75 @@ void System::SaveState(u32 slot) const {
     std::memcpy(header.build_name.data(), build_fullname.c_str(),
                 std::min(build_fullname.length(), sizeof(header.build_name) - 1));
 
-    if (file.WriteBytes(&header, sizeof(header)) != sizeof(header) ||
-        file.WriteBytes(buffer.data(), buffer.size()) != buffer.size()) {
-        throw std::runtime_error("Could not write to file " + path);
+    if (!savestate_worker) {
+        savestate_worker = std::make_unique<Common::ThreadWorker>(1, "SaveStateWorker");
     }
+    // Split the archive in as many frames as the header can describe, each of which can be
+    // compressed and decompressed on its own thread
+    const std::size_t frame_size = std::max(
+        CSTMinFrameSize, (snapshot->Size() + CSTMaxFrames - 1) / CSTMaxFrames);
+    header.format = static_cast<u32>(CSTFormat::Frames);
+    header.frame_size = static_cast<u32>(frame_size);
+    header.decompressed_size = snapshot->Size();
+
+    savestate_worker->QueueWork([snapshot, header, path, slot,
+                                 callback = savestate_callback]() mutable {
+        SaveStateProgress progress{slot, 0, snapshot->Size(),
+                                   SaveStateProgress::Status::InProgress};
+        const auto report = [&] {
+            if (callback) {
+                callback(progress);
+            }
+        };
+        const auto fail = [&](std::string error) {
+            LOG_ERROR(Core, "Error saving to slot {}: {}", slot, error);
+            progress.status = SaveStateProgress::Status::Failed;
+            progress.error = std::move(error);
+            report();
+        };
+
+        if (!FileUtil::CreateFullPath(path)) {
+            fail("Could not create path " + path);
+            return;
+        }
+
+        FileUtil::IOFile file(path, "wb");
+        if (!file) {
+            fail("Could not open file " + path);
+            return;
+        }
+        if (file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+            fail("Could not write to file " + path);
+            return;
+        }
+
+        report();
+        const bool written = Common::Compression::CompressDataZSTDFramesDefault(
+            snapshot->Segments(), header.frame_size,
+            [&](std::span<const u8> compressed) {
+                if (header.frame_count == CSTMaxFrames) {
+                    return false;
+                }
+                header.compressed_frame_sizes[header.frame_count++] =
+                    static_cast<u32>(compressed.size());
+                return file.WriteBytes(compressed.data(), compressed.size()) == compressed.size();
+            },
+            [&](std::size_t processed) {
+                progress.processed = processed;
+                report();
+            });
+        // The frame sizes are only known now, write the final header
+        if (!written || !file.Seek(0, SEEK_SET) ||
+            file.WriteBytes(&header, sizeof(header)) != sizeof(header)) {
+            fail("Could not write to file " + path);
+            return;
+        }
+
+        LOG_INFO(Core, "Save to slot {} completed", slot);
+        progress.processed = progress.total;
+        progress.status = SaveStateProgress::Status::Completed;
+        report();
+    });
 }
 
 void System::LoadState(u32 slot) {
@@ -168,40 +300,59 @@ void System::LoadState(u32 slot) {
         throw std::runtime_error("Unable to load while connected to multiplayer");
     }
 
+    // Don't read a slot that is still being written
+    if (savestate_worker) {
+        savestate_worker->WaitForRequests();
+    }
+    // Recorded states lead up to the current state, not the loaded one
+    if (rewind_buffer) {
+        rewind_buffer->Clear();
+    }
+
     const u64 movie_id = movie.GetCurrentMovieID();
     const auto path = GetSaveStatePath(title_id, movie_id, slot);
 
-    std::vector<u8> decompressed;
-    {
-        std::vector<u8> buffer(FileUtil::GetSize(path) - sizeof(CSTHeader));
+    FileUtil::IOFile file(path, "rb");
 
-        FileUtil::IOFile file(path, "rb");
+    // load header
+    CSTHeader header;
+    if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
+        throw std::runtime_error("Could not read from file at " + path);
+    }
 
-        // load header
-        CSTHeader header;
-        if (file.ReadBytes(&header, sizeof(header)) != sizeof(header)) {
-            throw std::runtime_error("Could not read from file at " + path);
-        }
+    // validate header
+    SaveStateInfo info;
+    if (!ValidateSaveState(header, info, title_id, movie_id, slot)) {
+        throw std::runtime_error("Invalid savestate");
+    }
 
-        // validate header
-        SaveStateInfo info;
-        if (!ValidateSaveState(header, info, title_id, movie_id, slot)) {
+    // Older states are a single frame that can only be decompressed sequentially
+    std::vector<Common::Compression::ZSTDFrameInfo> frames;
+    if (header.format == static_cast<u32>(CSTFormat::Frames)) {
+        if (header.frame_count == 0 || header.frame_count > CSTMaxFrames) {
             throw std::runtime_error("Invalid savestate");
         }
-
-        if (file.ReadBytes(buffer.data(), buffer.size()) != buffer.size()) {
-            throw std::runtime_error("Could not read from file at " + path);
+        frames.reserve(header.frame_count);
+        u64 remaining = header.decompressed_size;
+        for (u32 i = 0; i < header.frame_count; ++i) {
+            const u64 decompressed_size = std::min<u64>(remaining, header.frame_size);
+            frames.push_back({header.compressed_frame_sizes[i], decompressed_size});
+            remaining -= decompressed_size;
         }
-        decompressed = Common::Compression::DecompressDataZSTD(buffer);
+    } else if (header.format != static_cast<u32>(CSTFormat::SingleFrame)) {
+        throw std::runtime_error("Unsupported savestate format");
     }
-    std::istringstream sstream{
-        std::string{reinterpret_cast<char*>(decompressed.data()), decompressed.size()},
-        std::ios_base::binary};
-    decompressed.clear();
 
-    // Deserialize
-    iarchive ia{sstream};
-    ia&* this;
+    // Deserialize straight from the file
+    Common::Compression::ZSTDDecompressStreamBuf buffer{file, std::move(frames)};
+    std::istream stream{&buffer};
+    {
+        iarchive ia{stream};
+        ia&* this;
+    }
+    if (buffer.HasError()) {
+        throw std::runtime_error("Could not decompress file at " + path);
+    }
 }
 
 } // namespace Core
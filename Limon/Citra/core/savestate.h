@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <string>
 #include <vector>
 #include "common/common_types.h"
@@ -20,6 +21,22 @@ struct SaveStateInfo {
     std::string build_name;
 };
 
+/// Progress of a savestate that is being compressed and written in the background
+struct SaveStateProgress {
+    u32 slot;
+    std::size_t processed; ///< Uncompressed bytes written so far
+    std::size_t total;     ///< Uncompressed size of the savestate
+    enum class Status {
+        InProgress,
+        Completed,
+        Failed,
+    } status;
+    std::string error; ///< Reason for the failure when status is Failed
+};
+
+/// Called from the savestate worker thread whenever a background save makes progress
+using SaveStateCallback = std::function<void(const SaveStateProgress&)>;
+
 constexpr u32 SaveStateSlotCount = 10; // Maximum count of savestate slots
 
 std::vector<SaveStateInfo> ListSaveStates(u64 program_id, u64 movie_id);
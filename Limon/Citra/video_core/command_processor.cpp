@@ -2,11 +2,16 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
 #include <cstring>
+#include <limits>
 #include <memory>
+#include <span>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include "common/assert.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -39,6 +44,96 @@ constexpr std::array<u32, 16> expand_bits_to_bytes{
 
 MICROPROFILE_DEFINE(GPU_Drawing, "GPU", "Drawing", MP_RGB(50, 50, 240));
 
+// Vertex loaders keyed by the layout hash of the attribute configuration they were set up from
+static std::unordered_map<u64, VertexLoader> vertex_loaders;
+// Games only use a handful of layouts; the limit merely guards against unbounded growth
+constexpr std::size_t MAX_VERTEX_LOADERS = 256;
+
+/**
+ * Post-transform vertex cache of indexed draws. When the index range of the draw fits in the cache,
+ * entries are indexed directly by vertex id relative to the lowest one, so every vertex is shaded
+ * exactly once. Draws spanning a larger range fall back to a 4-way set-associative cache with
+ * round-robin replacement over the same entries.
+ */
+class VertexCache {
+public:
+    /// Entries of the cache, 1 MiB of shader outputs
+    static constexpr std::size_t MAX_ENTRIES = 4096;
+    static constexpr std::size_t WAYS = 4;
+    static constexpr std::size_t SETS = MAX_ENTRIES / WAYS;
+
+    /// Empties the cache for a draw using the vertex ids in [min_vertex, max_vertex].
+    void Reset(u32 min_vertex, u32 max_vertex) {
+        const std::size_t range = static_cast<std::size_t>(max_vertex) - min_vertex + 1;
+        direct = range <= MAX_ENTRIES;
+        base_vertex = min_vertex;
+        const std::size_t num_entries = direct ? range : MAX_ENTRIES;
+        if (outputs.size() < num_entries) {
+            outputs.resize(num_entries);
+            ids.resize(num_entries);
+        }
+        valid.assign(num_entries, false);
+        if (!direct) {
+            next_way.fill(0);
+        }
+    }
+
+    /// Returns the cached output of the vertex, or nullptr if it isn't cached.
+    const Shader::AttributeBuffer* Find(u32 vertex) const {
+        if (direct) {
+            const std::size_t slot = vertex - base_vertex;
+            return valid[slot] ? &outputs[slot] : nullptr;
+        }
+        const std::size_t first = (vertex % SETS) * WAYS;
+        for (std::size_t slot = first; slot < first + WAYS; ++slot) {
+            if (valid[slot] && ids[slot] == vertex) {
+                return &outputs[slot];
+            }
+        }
+        return nullptr;
+    }
+
+    void Insert(u32 vertex, const Shader::AttributeBuffer& output) {
+        std::size_t slot;
+        if (direct) {
+            slot = vertex - base_vertex;
+        } else {
+            const std::size_t set = vertex % SETS;
+            slot = set * WAYS + next_way[set];
+            next_way[set] = (next_way[set] + 1) % WAYS;
+        }
+        outputs[slot] = output;
+        ids[slot] = vertex;
+        valid[slot] = true;
+    }
+
+private:
+    std::vector<Shader::AttributeBuffer> outputs;
+    std::vector<u32> ids;
+    std::vector<bool> valid;
+    std::array<u8, SETS> next_way{};
+    u32 base_vertex = 0;
+    bool direct = true;
+};
+
+static VertexCache vertex_cache;
+static VertexCacheStats last_vertex_cache_stats{};
+
+VertexCacheStats GetLastVertexCacheStats() {
+    return last_vertex_cache_stats;
+}
+
+static const VertexLoader& GetVertexLoader(const PipelineRegs& regs) {
+    const u64 layout_hash = VertexLoader::ComputeLayoutHash(regs);
+    if (const auto it = vertex_loaders.find(layout_hash); it != vertex_loaders.end()) {
+        return it->second;
+    }
+    if (vertex_loaders.size() >= MAX_VERTEX_LOADERS) {
+        vertex_loaders.clear();
+    }
+    return vertex_loaders.emplace(layout_hash, VertexLoader{regs}).first->second;
+}
+
 static const char* GetShaderSetupTypeName(Shader::ShaderSetup& setup) {
     if (&setup == &g_state.vs) {
         return "vertex shader";
@@ -312,10 +407,9 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         }
 
         // Processes information about internal vertex attributes to figure out how a vertex is
-        // loaded.
-        // Later, these can be compiled and cached.
+        // loaded, or reuses the loader of a previous draw with the same attribute layout.
         const u32 base_address = regs.pipeline.vertex_attributes.GetPhysicalBaseAddress();
-        VertexLoader loader(regs.pipeline);
+        const VertexLoader& loader = GetVertexLoader(regs.pipeline);
         Shader::OutputVertex::ValidateSemantics(regs.rasterizer);
 
         // Load vertices
@@ -343,18 +437,21 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
 
         DebugUtils::MemoryAccessTracker memory_accesses;
 
-        // Simple circular-replacement vertex cache
-        // The size has been tuned for optimal balance between hit-rate and the cost of lookup
-        const std::size_t VERTEX_CACHE_SIZE = 32;
-        std::array<bool, VERTEX_CACHE_SIZE> vertex_cache_valid{};
-        std::array<u16, VERTEX_CACHE_SIZE> vertex_cache_ids;
-        std::array<Shader::AttributeBuffer, VERTEX_CACHE_SIZE> vertex_cache;
-        Shader::AttributeBuffer vs_output;
-
-        unsigned int vertex_cache_pos = 0;
+        // Vertices are loaded in batches, then shaded one after another by a unit kept for the draw
+        constexpr unsigned int VERTEX_BATCH_SIZE = 16;
+        std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> batch_input;
+        std::array<Shader::AttributeBuffer, VERTEX_BATCH_SIZE> batch_output;
 
         auto* shader_engine = Shader::GetEngine();
         Shader::UnitState shader_unit;
+        const Shader::UnitRegisterMap register_map{regs.vs};
+        const auto shade_batch = [&](unsigned int count) {
+            for (unsigned int i = 0; i < count; ++i) {
+                register_map.LoadInput(shader_unit, batch_input[i]);
+                shader_engine->Run(g_state.vs, shader_unit);
+                register_map.WriteOutput(shader_unit, batch_output[i]);
+            }
+        };
 
         shader_engine->SetupBatch(g_state.vs, regs.vs.main_offset);
 
@@ -363,58 +460,107 @@ static void WritePicaReg(u32 id, u32 value, u32 mask) {
         if (g_state.geometry_pipeline.NeedIndexInput())
             ASSERT(is_indexed);
 
-        for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+        const auto get_index_vertex = [&](unsigned int index) -> u32 {
             // Indexed rendering doesn't use the start offset
-            unsigned int vertex =
-                is_indexed ? (index_u16 ? index_address_16[index] : index_address_8[index])
-                           : (index + regs.pipeline.vertex_offset);
-
-            bool vertex_cache_hit = false;
-
-            if (is_indexed) {
-                if (g_state.geometry_pipeline.NeedIndexInput()) {
-                    g_state.geometry_pipeline.SubmitIndex(vertex);
-                    continue;
+            return index_u16 ? index_address_16[index] : index_address_8[index];
+        };
+        const auto track_index_access = [&](unsigned int index) {
+            if (g_debug_context && Pica::g_debug_context->recorder) {
+                int size = index_u16 ? 2 : 1;
+                memory_accesses.AddAccess(base_address + index_info.offset + size * index, size);
+            }
+        };
+
+        if (!is_indexed) {
+            for (unsigned int first = 0; first < regs.pipeline.num_vertices;
+                 first += VERTEX_BATCH_SIZE) {
+                const unsigned int count =
+                    std::min(VERTEX_BATCH_SIZE, regs.pipeline.num_vertices - first);
+                loader.LoadVertices(base_address, first, first + regs.pipeline.vertex_offset,
+                                    std::span{batch_input.data(), count}, memory_accesses);
+
+                if (g_debug_context) {
+                    for (unsigned int i = 0; i < count; ++i) {
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)&batch_input[i]);
+                    }
                 }
 
-                if (g_debug_context && Pica::g_debug_context->recorder) {
-                    int size = index_u16 ? 2 : 1;
-                    memory_accesses.AddAccess(base_address + index_info.offset + size * index,
-                                              size);
-                }
+                shade_batch(count);
 
-                for (unsigned int i = 0; i < VERTEX_CACHE_SIZE; ++i) {
-                    if (vertex_cache_valid[i] && vertex == vertex_cache_ids[i]) {
-                        vs_output = vertex_cache[i];
-                        vertex_cache_hit = true;
-                        break;
-                    }
+                // Send to geometry pipeline
+                for (unsigned int i = 0; i < count; ++i) {
+                    g_state.geometry_pipeline.SubmitVertex(batch_output[i]);
                 }
             }
+        } else if (g_state.geometry_pipeline.NeedIndexInput()) {
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                g_state.geometry_pipeline.SubmitIndex(get_index_vertex(index));
+            }
+        } else if (regs.pipeline.num_vertices != 0) {
+            u32 min_vertex = std::numeric_limits<u32>::max();
+            u32 max_vertex = 0;
+            for (unsigned int index = 0; index < regs.pipeline.num_vertices; ++index) {
+                const u32 vertex = get_index_vertex(index);
+                min_vertex = std::min(min_vertex, vertex);
+                max_vertex = std::max(max_vertex, vertex);
+            }
+            vertex_cache.Reset(min_vertex, max_vertex);
+
+            VertexCacheStats stats{};
+            // Vertex ids of the vertices shaded in the current run, and where the output of each
+            // index of the run comes from
+            std::array<u32, VERTEX_BATCH_SIZE> batch_vertices;
+            std::array<const Shader::AttributeBuffer*, VERTEX_BATCH_SIZE> run_outputs;
+            for (unsigned int first = 0; first < regs.pipeline.num_vertices;
+                 first += VERTEX_BATCH_SIZE) {
+                const unsigned int count =
+                    std::min(VERTEX_BATCH_SIZE, regs.pipeline.num_vertices - first);
+
+                // Look up the vertices of this run, gathering the ones that need to be shaded
+                unsigned int num_misses = 0;
+                for (unsigned int i = 0; i < count; ++i) {
+                    const unsigned int index = first + i;
+                    track_index_access(index);
+                    const u32 vertex = get_index_vertex(index);
+                    if (const auto* cached = vertex_cache.Find(vertex)) {
+                        ++stats.hits;
+                        run_outputs[i] = cached;
+                        continue;
+                    }
+                    const auto batch_end = batch_vertices.begin() + num_misses;
+                    if (const auto it = std::find(batch_vertices.begin(), batch_end, vertex);
+                        it != batch_end) {
+                        ++stats.hits;
+                        run_outputs[i] = &batch_output[it - batch_vertices.begin()];
+                        continue;
+                    }
 
-            if (!vertex_cache_hit) {
-                // Initialize data for the current vertex
-                Shader::AttributeBuffer input;
-                loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                    Shader::AttributeBuffer& input = batch_input[num_misses];
+                    loader.LoadVertex(base_address, index, vertex, input, memory_accesses);
+                    if (g_debug_context)
+                        g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
+                                                 (void*)&input);
+                    run_outputs[i] = &batch_output[num_misses];
+                    batch_vertices[num_misses++] = vertex;
+                }
+                stats.misses += num_misses;
 
-                // Send to vertex shader
-                if (g_debug_context)
-                    g_debug_context->OnEvent(DebugContext::Event::VertexShaderInvocation,
-                                             (void*)&input);
-                shader_unit.LoadInput(regs.vs, input);
-                shader_engine->Run(g_state.vs, shader_unit);
-                shader_unit.WriteOutput(regs.vs, vs_output);
+                shade_batch(num_misses);
 
-                if (is_indexed) {
-                    vertex_cache[vertex_cache_pos] = vs_output;
-                    vertex_cache_valid[vertex_cache_pos] = true;
-                    vertex_cache_ids[vertex_cache_pos] = vertex;
-                    vertex_cache_pos = (vertex_cache_pos + 1) % VERTEX_CACHE_SIZE;
+                // Send to geometry pipeline before the cache entries it reads from are replaced,
+                // which only happens when the index range didn't fit in the cache
+                for (unsigned int i = 0; i < count; ++i) {
+                    g_state.geometry_pipeline.SubmitVertex(*run_outputs[i]);
+                }
+                for (unsigned int i = 0; i < num_misses; ++i) {
+                    vertex_cache.Insert(batch_vertices[i], batch_output[i]);
                 }
             }
 
-            // Send to geometry pipeline
-            g_state.geometry_pipeline.SubmitVertex(vs_output);
+            last_vertex_cache_stats = stats;
+            LOG_TRACE(HW_GPU, "Indexed draw of {} vertices: {} shaded, {} cache hits",
+                      regs.pipeline.num_vertices, stats.misses, stats.hits);
         }
 
         for (auto& range : memory_accesses.ranges) {
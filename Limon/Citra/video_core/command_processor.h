@@ -34,4 +34,13 @@ static_assert(sizeof(CommandHeader) == sizeof(u32), "CommandHeader has incorrect
 
 void ProcessCommandList(PAddr list, u32 size);
 
+/// Post-transform vertex cache counters of an indexed draw, for diagnostics
+struct VertexCacheStats {
+    u64 hits;   ///< Indices whose vertex was found in the vertex cache
+    u64 misses; ///< Vertices shaded
+};
+
+/// Returns the vertex cache counters of the last indexed draw processed in software.
+VertexCacheStats GetLastVertexCacheStats();
+
 } // namespace Pica::CommandProcessor
@@ -0,0 +1,139 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include "common/microprofile.h"
+#include "common/thread.h"
+#include "video_core/gpu_thread.h"
+
+MICROPROFILE_DEFINE(GPU_Thread, "GPU", "Thread", MP_RGB(100, 100, 255));
+
+namespace VideoCore {
+
+GPUThread::GPUThread() {
+    thread = std::jthread([this](std::stop_token stop_token) { ThreadLoop(stop_token); });
+    thread_id = thread.get_id();
+}
+
+GPUThread::~GPUThread() {
+    // Let the queued work complete, it may be presenting or writing back to guest memory
+    Synchronize();
+}
+
+u64 GPUThread::Push(Command&& command, MemoryRange range) {
+    u64 fence;
+    {
+        std::scoped_lock lock{queue_mutex};
+        fence = ++last_fence;
+        commands.push(std::move(command));
+        while (!pending_ranges.empty() && IsFenceSignaled(pending_ranges.front().fence)) {
+            pending_ranges.pop_front();
+        }
+        if (range.size != 0) {
+            pending_ranges.push_back({fence, range.start, u64{range.start} + range.size});
+        }
+    }
+    queue_condition.notify_one();
+    return fence;
+}
+
+void GPUThread::WaitForFence(u64 fence) {
+    if (signaled_fence.load(std::memory_order_acquire) >= fence) {
+        return;
+    }
+    {
+        // Fences restored from a save state may belong to an earlier GPU thread
+        std::scoped_lock lock{queue_mutex};
+        fence = std::min(fence, last_fence);
+    }
+    std::unique_lock lock{fence_mutex};
+    fence_condition.wait(lock, [this, fence] {
+        return signaled_fence.load(std::memory_order_acquire) >= fence;
+    });
+}
+
+void GPUThread::Synchronize() {
+    u64 fence;
+    {
+        std::scoped_lock lock{queue_mutex};
+        fence = last_fence;
+    }
+    WaitForFence(fence);
+}
+
+u64 GPUThread::GetRegionFence(PAddr start, u32 size) {
+    const u64 end = u64{start} + size;
+    std::scoped_lock lock{queue_mutex};
+    for (auto it = pending_ranges.rbegin(); it != pending_ranges.rend(); ++it) {
+        if (IsFenceSignaled(it->fence)) {
+            break;
+        }
+        if (it->start < end && start < it->end) {
+            return it->fence;
+        }
+    }
+    return 0;
+}
+
+void GPUThread::RunSyncAfter(u64 fence, Command&& command) {
+    if (IsGPUThread()) {
+        command();
+        return;
+    }
+    u64 ticket;
+    {
+        std::scoped_lock lock{queue_mutex};
+        urgent_commands.push({fence, std::move(command)});
+        ticket = ++urgent_pushed;
+    }
+    queue_condition.notify_one();
+
+    std::unique_lock lock{fence_mutex};
+    fence_condition.wait(lock, [this, ticket] { return urgent_completed >= ticket; });
+}
+
+bool GPUThread::IsGPUThread() const {
+    return std::this_thread::get_id() == thread_id;
+}
+
+void GPUThread::ThreadLoop(std::stop_token stop_token) {
+    Common::SetCurrentThreadName("GPU");
+    while (!stop_token.stop_requested()) {
+        Command command;
+        bool is_urgent;
+        {
+            std::unique_lock lock{queue_mutex};
+            Common::CondvarWait(queue_condition, lock, stop_token,
+                                [this] { return !commands.empty() || IsUrgentCommandReady(); });
+            if (stop_token.stop_requested()) {
+                break;
+            }
+            is_urgent = IsUrgentCommandReady();
+            if (is_urgent) {
+                command = std::move(urgent_commands.front().command);
+                urgent_commands.pop();
+            } else {
+                command = std::move(commands.front());
+                commands.pop();
+            }
+        }
+        {
+            MICROPROFILE_SCOPE(GPU_Thread);
+            command();
+        }
+        {
+            std::scoped_lock lock{fence_mutex};
+            if (is_urgent) {
+                // Urgent commands are executed in order as well, so this is the next one
+                ++urgent_completed;
+            } else {
+                // Commands are executed in order, so the fence of this one is the next to signal
+                signaled_fence.fetch_add(1, std::memory_order_release);
+            }
+        }
+        fence_condition.notify_all();
+    }
+}
+
+} // namespace VideoCore
@@ -0,0 +1,117 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include "common/common_types.h"
+#include "common/polyfill_thread.h"
+#include "common/unique_function.h"
+
+namespace VideoCore {
+
+/// Physical memory read or written by a GPU thread command, all of it unless specified otherwise
+struct MemoryRange {
+    PAddr start = 0;
+    u32 size = std::numeric_limits<u32>::max();
+};
+
+/**
+ * Dedicated thread executing the work of the emulated GPU: command lists, memory fills, display
+ * transfers, texture copies and presentation. Work is executed in submission order, and every
+ * submission is assigned a fence that is signaled once it has completed, so that the emulated CPU
+ * only waits for the GPU when it needs the results, the way it does on hardware.
+ *
+ * Submissions also record the physical memory they access, so that rasterizer flushes and
+ * invalidations of a region only wait for the queued work that touches it and then run ahead of
+ * the rest of the queue.
+ */
+class GPUThread {
+public:
+    using Command = Common::UniqueFunction<void>;
+
+    GPUThread();
+    ~GPUThread();
+
+    GPUThread(const GPUThread&) = delete;
+    GPUThread& operator=(const GPUThread&) = delete;
+
+    /// Queues the command for execution and returns the fence signaled once it has completed.
+    u64 Push(Command&& command, MemoryRange range = {});
+
+    /// Returns true if the command of the given fence has completed.
+    [[nodiscard]] bool IsFenceSignaled(u64 fence) const {
+        return signaled_fence.load(std::memory_order_acquire) >= fence;
+    }
+
+    /// Blocks until the command of the given fence has completed.
+    void WaitForFence(u64 fence);
+
+    /// Blocks until all queued commands have completed.
+    void Synchronize();
+
+    /**
+     * Returns the fence of the last queued command accessing the physical memory region, or 0 if
+     * no queued command accesses it.
+     */
+    [[nodiscard]] u64 GetRegionFence(PAddr start, u32 size);
+
+    /**
+     * Executes the command on the GPU thread as soon as the command of the given fence has
+     * completed, ahead of the commands queued after it, and waits for it. When called from the
+     * GPU thread the command is executed right away.
+     */
+    void RunSyncAfter(u64 fence, Command&& command);
+
+    /// Returns the fence of the command being executed, called from the GPU thread.
+    [[nodiscard]] u64 GetCurrentFence() const {
+        return signaled_fence.load(std::memory_order_acquire) + 1;
+    }
+
+    /// Returns true when called from the GPU thread.
+    [[nodiscard]] bool IsGPUThread() const;
+
+private:
+    struct PendingRange {
+        u64 fence;
+        PAddr start;
+        u64 end;
+    };
+
+    struct UrgentCommand {
+        u64 fence; ///< Fence that must be signaled before the command runs
+        Command command;
+    };
+
+    void ThreadLoop(std::stop_token stop_token);
+
+    /// Returns true if the first urgent command can run. Requires queue_mutex.
+    bool IsUrgentCommandReady() const {
+        return !urgent_commands.empty() && IsFenceSignaled(urgent_commands.front().fence);
+    }
+
+    std::mutex queue_mutex;
+    std::condition_variable_any queue_condition;
+    std::queue<Command> commands;
+    u64 last_fence{};
+    std::deque<PendingRange> pending_ranges; ///< Memory accessed by the queued commands
+    std::queue<UrgentCommand> urgent_commands;
+    u64 urgent_pushed{};
+
+    std::mutex fence_mutex;
+    std::condition_variable fence_condition;
+    std::atomic<u64> signaled_fence{};
+    u64 urgent_completed{}; ///< Protected by fence_mutex
+
+    std::jthread thread;
+    std::thread::id thread_id;
+};
+
+} // namespace VideoCore
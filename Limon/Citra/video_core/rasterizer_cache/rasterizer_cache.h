@@ -4,10 +4,13 @@
 
 #pragma once
 
+#include <algorithm>
 #include <type_traits>
+#include <utility>
 #include <boost/container/small_vector.hpp>
 #include <boost/range/iterator_range.hpp>
 #include "common/alignment.h"
+#include "common/literals.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/scope_exit.h"
@@ -31,6 +34,9 @@ constexpr auto RangeFromInterval(const auto& map, const auto& interval) {
     return boost::make_iterator_range(map.equal_range(interval));
 }
 
+/// Surfaces looked up within this many frames are considered in use and never evicted
+constexpr u64 EVICTION_MIN_AGE = 2;
+
 template <class T>
 RasterizerCache<T>::RasterizerCache(Memory::MemorySystem& memory_,
                                     CustomTexManager& custom_tex_manager_, Runtime& runtime_,
@@ -70,6 +76,15 @@ RasterizerCache<T>::RasterizerCache(Memory::MemorySystem& memory_,
 
 template <class T>
 RasterizerCache<T>::~RasterizerCache() {
+    LOG_DEBUG(HW_GPU, "Surface cache: {} MiB resident, {} evictions ({} flushed)",
+              stats.memory_usage >> 20, stats.evictions, stats.flushed_evictions);
+    for (std::size_t format = 0; format < PIXEL_FORMAT_COUNT; format++) {
+        if (stats.format_memory_usage[format] != 0) {
+            LOG_DEBUG(HW_GPU, "    {}: {} KiB",
+                      PixelFormatAsString(static_cast<PixelFormat>(format)),
+                      stats.format_memory_usage[format] >> 10);
+        }
+    }
     ClearAll(false);
 }
 
@@ -109,9 +124,96 @@ void RasterizerCache<T>::RunGarbageCollector() {
             continue;
         }
         RemoveFramebuffers(surface_id);
+        UpdateMemoryUsage(slot_surfaces[surface_id], 0);
         slot_surfaces.erase(surface_id);
         it = sentenced.erase(it);
     }
+    EvictSurfaces();
+}
+
+template <class T>
+void RasterizerCache<T>::EvictSurfaces() {
+    using namespace Common::Literals;
+    const u64 budget = Settings::values.surface_cache_budget.GetValue() * 1_MiB;
+    if (budget == 0 || stats.memory_usage <= budget) {
+        return;
+    }
+
+    // Sentenced surfaces release their memory once the GPU is done with them
+    u64 pending_release = 0;
+    for (const auto& [surface_id, tick] : sentenced) {
+        pending_release += slot_surfaces[surface_id].memory_usage;
+    }
+    if (stats.memory_usage - pending_release <= budget) {
+        return;
+    }
+
+    std::vector<SurfaceId> candidates;
+    for (const auto& [page, surfaces] : page_table) {
+        for (const SurfaceId surface_id : surfaces) {
+            Surface& surface = slot_surfaces[surface_id];
+            if (True(surface.flags & SurfaceFlagBits::Picked) || surface.memory_usage == 0 ||
+                frame_tick - surface.last_used_tick < EVICTION_MIN_AGE) {
+                continue;
+            }
+            surface.flags |= SurfaceFlagBits::Picked;
+            candidates.push_back(surface_id);
+        }
+    }
+    for (const SurfaceId surface_id : candidates) {
+        slot_surfaces[surface_id].flags &= ~SurfaceFlagBits::Picked;
+    }
+    std::sort(candidates.begin(), candidates.end(), [this](SurfaceId lhs, SurfaceId rhs) {
+        return slot_surfaces[lhs].last_used_tick < slot_surfaces[rhs].last_used_tick;
+    });
+
+    const auto is_dirty = [this](SurfaceId surface_id) {
+        const Surface& surface = slot_surfaces[surface_id];
+        for (const auto& [region, owner_id] :
+             RangeFromInterval(dirty_regions, surface.GetInterval())) {
+            if (owner_id == surface_id) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // Evicting a dirty surface requires flushing it to guest memory, so clean ones go first
+    for (const bool flush : {false, true}) {
+        for (const SurfaceId surface_id : candidates) {
+            if (stats.memory_usage - pending_release <= budget) {
+                return;
+            }
+            Surface& surface = slot_surfaces[surface_id];
+            if (False(surface.flags & SurfaceFlagBits::Registered) ||
+                is_dirty(surface_id) != flush) {
+                continue;
+            }
+            if (flush) {
+                FlushRegion(surface.addr, surface.size, surface_id);
+                stats.flushed_evictions++;
+            }
+            pending_release += surface.memory_usage;
+            UnregisterSurface(surface_id);
+            stats.evictions++;
+        }
+    }
+}
+
+template <class T>
+void RasterizerCache<T>::UpdateMemoryUsage(Surface& surface, u64 memory_usage) {
+    const u64 old_usage = std::exchange(surface.memory_usage, memory_usage);
+    stats.memory_usage = stats.memory_usage - old_usage + memory_usage;
+    const auto format = static_cast<std::size_t>(surface.pixel_format);
+    if (format < PIXEL_FORMAT_COUNT) {
+        u64& format_usage = stats.format_memory_usage[format];
+        format_usage = format_usage - old_usage + memory_usage;
+    }
+}
+
+template <class T>
+SurfaceCacheStats RasterizerCache<T>::GetStats() const {
+    return stats;
 }
 
 template <class T>
@@ -403,6 +505,7 @@ void RasterizerCache<T>::CopySurface(Surface& src_surface, Surface& dst_surface,
     const u32 dst_scale = dst_surface.res_scale;
     if (src_scale > dst_scale) {
         dst_surface.ScaleUp(src_scale);
+        UpdateMemoryUsage(dst_surface, dst_surface.MemoryUsage());
     }
 
     const auto src_rect = src_surface.GetScaledSubRect(subrect_params);
@@ -615,6 +718,7 @@ typename T::Surface& RasterizerCache<T>::GetTextureCube(const TextureCubeConfig&
         }
         Surface& surface = slot_surfaces[face_id];
         surface.flags |= SurfaceFlagBits::Tracked;
+        surface.last_used_tick = frame_tick;
         if (cube.ticks[i] == surface.modification_tick) {
             continue;
         }
@@ -894,6 +998,9 @@ SurfaceId RasterizerCache<T>::FindMatch(const SurfaceParams& params, ScaleMatch
             return std::make_pair(surface.CanTexCopy(params), surface.GetInterval());
         });
     });
+    if (match_id) {
+        slot_surfaces[match_id].last_used_tick = frame_tick;
+    }
     return match_id;
 }
 
@@ -1057,6 +1164,10 @@ bool RasterizerCache<T>::UploadCustomSurface(SurfaceId surface_id, SurfaceInterv
                 slot_surfaces.swap_and_insert(surface_id, runtime, old_surface, material);
             slot_surfaces[old_id].flags &= ~SurfaceFlagBits::Registered;
             sentenced.emplace_back(old_id, frame_tick);
+            // The memory copied from the old surface is still accounted to it
+            Surface& surface = slot_surfaces[surface_id];
+            surface.memory_usage = 0;
+            UpdateMemoryUsage(surface, surface.MemoryUsage());
         }
         Surface& surface = slot_surfaces[surface_id];
         surface.UploadCustom(material, level);
@@ -1144,6 +1255,7 @@ bool RasterizerCache<T>::ValidateByReinterpretation(Surface& surface, SurfacePar
         const u32 res_scale = src_surface.res_scale;
         if (res_scale > surface.res_scale) {
             surface.ScaleUp(res_scale);
+            UpdateMemoryUsage(surface, surface.MemoryUsage());
         }
         const PAddr addr = boost::icl::lower(interval);
         const SurfaceParams copy_params = surface.FromInterval(copy_interval);
@@ -1323,6 +1435,8 @@ SurfaceId RasterizerCache<T>::CreateSurface(const SurfaceParams& params) {
     if (params.res_scale > surface.res_scale) {
         surface.ScaleUp(params.res_scale);
     }
+    UpdateMemoryUsage(surface, surface.MemoryUsage());
+    surface.last_used_tick = frame_tick;
     surface.MarkInvalid(surface.GetInterval());
     return surface_id;
 }
@@ -1369,6 +1483,7 @@ void RasterizerCache<T>::UnregisterSurface(SurfaceId surface_id) {
         return;
     }
 
+    UpdateMemoryUsage(surface, 0);
     slot_surfaces.erase(surface_id);
 }
 
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <array>
 #include <functional>
 #include <list>
 #include <optional>
@@ -51,6 +52,13 @@ enum class MatchFlags {
 
 DECLARE_ENUM_FLAG_OPERATORS(MatchFlags);
 
+struct SurfaceCacheStats {
+    u64 memory_usage;                                        ///< Host memory of all surfaces
+    std::array<u64, PIXEL_FORMAT_COUNT> format_memory_usage; ///< Host memory per pixel format
+    u64 evictions;         ///< Surfaces evicted to stay within the memory budget
+    u64 flushed_evictions; ///< Evicted surfaces that had to be flushed to guest memory first
+};
+
 class CustomTexManager;
 class RendererBase;
 
@@ -133,6 +141,9 @@ public:
     /// Clear all cached resources tracked by this cache manager
     void ClearAll(bool flush);
 
+    /// Returns the host memory usage and eviction statistics of the cache
+    [[nodiscard]] SurfaceCacheStats GetStats() const;
+
 private:
     /// Iterate over all page indices in a range
     template <typename Func>
@@ -162,6 +173,12 @@ private:
     /// Unregisters sentenced surfaces that have surpassed the destruction threshold.
     void RunGarbageCollector();
 
+    /// Evicts the least recently used surfaces while the host memory budget is exceeded.
+    void EvictSurfaces();
+
+    /// Sets the host memory accounted to the surface, after its allocations changed.
+    void UpdateMemoryUsage(Surface& surface, u64 memory_usage);
+
     /// Removes any framebuffers that reference the provided surface_id.
     void RemoveFramebuffers(SurfaceId surface_id);
 
@@ -226,6 +243,7 @@ private:
     PageMap cached_pages;
     u32 resolution_scale_factor;
     u64 frame_tick{};
+    SurfaceCacheStats stats{};
     FramebufferParams fb_params;
     Settings::TextureFilter filter;
     bool dump_textures;
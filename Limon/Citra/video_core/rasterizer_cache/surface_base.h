@@ -89,6 +89,8 @@ public:
     u32 fill_size = 0;
     std::array<u8, 4> fill_data;
     u64 modification_tick = 1;
+    u64 last_used_tick = 0; ///< Frame the surface was last looked up in
+    u64 memory_usage = 0;   ///< Host memory accounted to the surface by the rasterizer cache
 };
 
 } // namespace VideoCore
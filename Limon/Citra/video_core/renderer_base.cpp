@@ -11,6 +11,13 @@
 
 namespace VideoCore {
 
+FrameConfig FrameConfig::Capture() {
+    return FrameConfig{
+        .framebuffers{GPU::g_regs.framebuffer_config[0], GPU::g_regs.framebuffer_config[1]},
+        .color_fills{LCD::g_regs.color_fill_top, LCD::g_regs.color_fill_bottom},
+    };
+}
+
 RendererBase::RendererBase(Core::System& system_, Frontend::EmuWindow& window,
                            Frontend::EmuWindow* secondary_window_)
     : system{system_}, render_window{window}, secondary_window{secondary_window_} {}
@@ -4,8 +4,11 @@
 
 #pragma once
 
+#include <array>
 #include "common/common_types.h"
 #include "core/frontend/framebuffer_layout.h"
+#include "core/hw/gpu.h"
+#include "core/hw/lcd.h"
 #include "video_core/rasterizer_interface.h"
 
 namespace Frontend {
@@ -24,6 +27,18 @@ enum class ScreenId : u32 {
     Bottom,
 };
 
+/**
+ * Display registers of a frame, copied on the emulation thread when the frame ends so that the GPU
+ * thread can present it while the guest already configures the next one.
+ */
+struct FrameConfig {
+    std::array<GPU::Regs::FramebufferConfig, 2> framebuffers; ///< Top and bottom screen
+    std::array<LCD::Regs::ColorFill, 2> color_fills;          ///< Top and bottom screen
+
+    /// Copies the display registers of the current frame.
+    [[nodiscard]] static FrameConfig Capture();
+};
+
 struct RendererSettings {
     // Screenshot
     std::atomic_bool screenshot_requested{false};
@@ -45,7 +60,7 @@ public:
     virtual VideoCore::RasterizerInterface* Rasterizer() = 0;
 
     /// Finalize rendering the guest frame and draw into the presentation texture
-    virtual void SwapBuffers() = 0;
+    virtual void SwapBuffers(const FrameConfig& frame) = 0;
 
     /// Draws the latest frame to the window waiting timeout_ms for a frame to arrive (Renderer
     /// specific implementation)
@@ -72,7 +87,7 @@ public:
     /// Updates the framebuffer layout of the contained render window handle.
     void UpdateCurrentFramebufferLayout(bool is_portrait_mode = {});
 
-    /// Ends the current frame
+    /// Ends the current frame, called on the emulation thread after the frame has been swapped
     void EndFrame();
 
     f32 GetCurrentFPS() const {
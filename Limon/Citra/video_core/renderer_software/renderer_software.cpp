@@ -5,8 +5,6 @@
 #include "common/color.h"
 #include "core/core.h"
 #include "core/hw/gpu.h"
-#include "core/hw/hw.h"
-#include "core/hw/lcd.h"
 #include "video_core/renderer_software/renderer_software.h"
 
 namespace SwRenderer {
@@ -17,30 +15,20 @@ RendererSoftware::RendererSoftware(Core::System& system, Frontend::EmuWindow& wi
 
 RendererSoftware::~RendererSoftware() = default;
 
-void RendererSoftware::SwapBuffers() {
-    PrepareRenderTarget();
-    EndFrame();
+void RendererSoftware::SwapBuffers(const VideoCore::FrameConfig& frame) {
+    PrepareRenderTarget(frame);
 }
 
-void RendererSoftware::PrepareRenderTarget() {
+void RendererSoftware::PrepareRenderTarget(const VideoCore::FrameConfig& frame) {
     for (u32 i = 0; i < 3; i++) {
         const int fb_id = i == 2 ? 1 : 0;
-
-        u32 lcd_color_addr =
-            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill = {0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
-
-        if (!color_fill.is_enabled) {
-            LoadFBToScreenInfo(i);
+        if (!frame.color_fills[fb_id].is_enabled) {
+            LoadFBToScreenInfo(frame.framebuffers[fb_id], i);
         }
     }
 }
 
-void RendererSoftware::LoadFBToScreenInfo(int i) {
-    const u32 fb_id = i == 2 ? 1 : 0;
-    const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
+void RendererSoftware::LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer, int i) {
     auto& info = screen_infos[i];
 
     const PAddr framebuffer_addr =
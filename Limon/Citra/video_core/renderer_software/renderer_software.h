@@ -32,13 +32,13 @@ public:
         return screen_infos[static_cast<u32>(id)];
     }
 
-    void SwapBuffers() override;
+    void SwapBuffers(const VideoCore::FrameConfig& frame) override;
     void TryPresent(int timeout_ms, bool is_secondary) override {}
     void Sync() override {}
 
 private:
-    void PrepareRenderTarget();
-    void LoadFBToScreenInfo(int i);
+    void PrepareRenderTarget(const VideoCore::FrameConfig& frame);
+    void LoadFBToScreenInfo(const GPU::Regs::FramebufferConfig& framebuffer, int i);
 
 private:
     Memory::MemorySystem& memory;
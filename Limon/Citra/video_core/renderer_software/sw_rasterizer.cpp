@@ -2,6 +2,7 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <bit>
 #include <boost/container/static_vector.hpp>
 #include "common/logging/log.h"
 #include "common/microprofile.h"
@@ -33,6 +34,23 @@ using Pica::Texture::TextureInfo;
 // we can use a very small epsilon value for clip plane comparison.
 constexpr f32 EPSILON_Z = 0.00000001f;
 
+/// Size in pixels of the square screen tiles triangles are binned into.
+constexpr u32 TILE_SIZE = 32;
+/// Number of tiles along each axis needed to cover the 12.4 fixed point coordinate range.
+constexpr u32 NUM_TILES = 4096 / TILE_SIZE;
+/// Number of triangles after which the binned triangles are rasterized even if the batch goes on.
+constexpr std::size_t MAX_BINNED_TRIANGLES = 4096;
+
+/// Fragment features the rasterization loop is specialised for.
+constexpr u32 FEATURE_LIGHTING = 1 << 0;
+constexpr u32 FEATURE_ALPHA_TEST = 1 << 1;
+constexpr u32 FEATURE_FOG = 1 << 2;
+constexpr u32 FEATURE_SHADOW_RENDERING = 1 << 3;
+constexpr u32 NUM_FEATURE_COMBINATIONS = 1 << 4;
+
+/// Number of pixels whose coverage and depth are computed together.
+constexpr u32 SPAN_SIZE = 8;
+
 struct Vertex : Pica::Shader::OutputVertex {
     Vertex(const OutputVertex& v) : OutputVertex(v) {}
 
@@ -67,10 +85,87 @@ struct Vertex : Pica::Shader::OutputVertex {
     }
 };
 
+/// Triangle set up for rasterization, in rasterizer coordinates.
+struct RasterizerSoftware::Triangle {
+    std::array<Vertex, 3> vertices;
+    std::array<Common::Vec3<Fix12P4>, 3> vtxpos;
+    std::array<int, 3> bias;
+    u16 min_x;
+    u16 min_y;
+    u16 max_x;
+    u16 max_y;
+};
+
 namespace {
 
 MICROPROFILE_DEFINE(GPU_Rasterization, "GPU", "Rasterization", MP_RGB(50, 50, 240));
 
+/**
+ * Edge function of a triangle in rasterizer coordinates, which is linear in the sample position.
+ * Evaluates to the same value as SignedArea plus the edge bias.
+ */
+struct EdgeFunction {
+    EdgeFunction(const Common::Vec2<Fix12P4>& vtx1, const Common::Vec2<Fix12P4>& vtx2, int bias_)
+        : x1{vtx1.x}, y1{vtx1.y}, dx{vtx2.x - vtx1.x}, dy{vtx2.y - vtx1.y}, bias{bias_} {}
+
+    s32 Evaluate(s32 x, s32 y) const {
+        return bias + (dx * (y - y1) - dy * (x - x1));
+    }
+
+    s32 x1;
+    s32 y1;
+    s32 dx;
+    s32 dy;
+    s32 bias;
+};
+
+// Debug builds of the app define DEBUG rather than the _DEBUG that enables DEBUG_ASSERT, so the
+// block and span coverage is checked against the per pixel test with regular asserts under DEBUG.
+#ifdef DEBUG
+/// Returns true if the sample is covered by the triangle, evaluated one pixel at a time.
+bool IsCovered(std::span<const Common::Vec3<Fix12P4>, 3> vtxpos, std::span<const int, 3> bias,
+               u16 x, u16 y) {
+    return bias[0] + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y}) >= 0 &&
+           bias[1] + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y}) >= 0 &&
+           bias[2] + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y}) >= 0;
+}
+#endif
+
+/// Returns true if the depth value passes the depth test against the stored one.
+bool TestDepth(FramebufferRegs::CompareFunc func, u32 z, u32 ref_z) {
+    switch (func) {
+    case FramebufferRegs::CompareFunc::Never:
+        return false;
+    case FramebufferRegs::CompareFunc::Always:
+        return true;
+    case FramebufferRegs::CompareFunc::Equal:
+        return z == ref_z;
+    case FramebufferRegs::CompareFunc::NotEqual:
+        return z != ref_z;
+    case FramebufferRegs::CompareFunc::LessThan:
+        return z < ref_z;
+    case FramebufferRegs::CompareFunc::LessThanOrEqual:
+        return z <= ref_z;
+    case FramebufferRegs::CompareFunc::GreaterThan:
+        return z > ref_z;
+    case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
+        return z >= ref_z;
+    }
+    return false;
+}
+
+/// Returns true if the TEV stage outputs the result of the previous stage unchanged.
+bool IsPassThroughTevStage(const TexturingRegs::TevStageConfig& stage) {
+    using TevStageConfig = TexturingRegs::TevStageConfig;
+    return (stage.color_op == TevStageConfig::Operation::Replace &&
+            stage.alpha_op == TevStageConfig::Operation::Replace &&
+            stage.color_source1 == TevStageConfig::Source::Previous &&
+            stage.alpha_source1 == TevStageConfig::Source::Previous &&
+            stage.color_modifier1 == TevStageConfig::ColorModifier::SourceColor &&
+            stage.alpha_modifier1 == TevStageConfig::AlphaModifier::SourceAlpha &&
+            stage.GetColorMultiplier() == 1 && stage.GetAlphaMultiplier() == 1);
+}
+
 struct ClippingEdge {
 public:
     constexpr ClippingEdge(Common::Vec4<f24> coeffs,
@@ -104,7 +199,10 @@ private:
 RasterizerSoftware::RasterizerSoftware(Memory::MemorySystem& memory_)
     : memory{memory_}, state{Pica::g_state}, regs{state.regs},
       num_sw_threads{std::max(std::thread::hardware_concurrency(), 2U)},
-      sw_workers{num_sw_threads, "SwRenderer workers"}, fb{memory, regs.framebuffer} {}
+      sw_workers{num_sw_threads, "SwRenderer workers"}, fb{memory, regs.framebuffer},
+      texture_cache{memory}, bins(NUM_TILES * NUM_TILES) {}
+
+RasterizerSoftware::~RasterizerSoftware() = default;
 
 void RasterizerSoftware::AddTriangle(const Pica::Shader::OutputVertex& v0,
                                      const Pica::Shader::OutputVertex& v1,
@@ -207,6 +305,22 @@ void RasterizerSoftware::AddTriangle(const Pica::Shader::OutputVertex& v0,
     }
 }
 
+void RasterizerSoftware::DrawTriangles() {
+    FlushTriangles();
+}
+
+void RasterizerSoftware::InvalidateRegion(PAddr addr, u32 size) {
+    texture_cache.InvalidateRegion(addr, size);
+}
+
+void RasterizerSoftware::FlushAndInvalidateRegion(PAddr addr, u32 size) {
+    texture_cache.InvalidateRegion(addr, size);
+}
+
+void RasterizerSoftware::ClearAll(bool flush) {
+    texture_cache.Clear();
+}
+
 void RasterizerSoftware::MakeScreenCoords(Vertex& vtx) {
     Viewport viewport{};
     viewport.halfsize_x = f24::FromRaw(regs.rasterizer.viewport_size_x);
@@ -231,8 +345,6 @@ void RasterizerSoftware::MakeScreenCoords(Vertex& vtx) {
 
 void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                                          bool reversed) {
-    MICROPROFILE_SCOPE(GPU_Rasterization);
-
     // Vertex positions in rasterizer coordinates
     static auto screen_to_rasterizer_coords = [](const Common::Vec3<f24>& vec) {
         return Common::Vec3{Fix12P4::FromFloat24(vec.x), Fix12P4::FromFloat24(vec.y),
@@ -288,6 +400,10 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
     max_x = ((max_x + Fix12P4::FracMask()) & Fix12P4::IntMask());
     max_y = ((max_y + Fix12P4::FracMask()) & Fix12P4::IntMask());
 
+    if (min_x >= max_x || min_y >= max_y) {
+        return;
+    }
+
     const int bias0 =
         IsRightSideOrFlatBottomEdge(vtxpos[0].xy(), vtxpos[1].xy(), vtxpos[2].xy()) ? -1 : 0;
     const int bias1 =
@@ -295,182 +411,453 @@ void RasterizerSoftware::ProcessTriangle(const Vertex& v0, const Vertex& v1, con
     const int bias2 =
         IsRightSideOrFlatBottomEdge(vtxpos[2].xy(), vtxpos[0].xy(), vtxpos[1].xy()) ? -1 : 0;
 
+    const u32 index = static_cast<u32>(triangles.size());
+    triangles.push_back({
+        .vertices = {v0, v1, v2},
+        .vtxpos = vtxpos,
+        .bias = {bias0, bias1, bias2},
+        .min_x = min_x,
+        .min_y = min_y,
+        .max_x = max_x,
+        .max_y = max_y,
+    });
+
+    // Append the triangle to the bins of all tiles its bounding box overlaps. Since each tile is
+    // rasterized by a single worker in bin order, triangles overlapping each other are still
+    // drawn in submission order.
+    const u32 first_tile_x = (min_x >> 4) / TILE_SIZE;
+    const u32 first_tile_y = (min_y >> 4) / TILE_SIZE;
+    const u32 last_tile_x = ((max_x >> 4) - 1) / TILE_SIZE;
+    const u32 last_tile_y = ((max_y >> 4) - 1) / TILE_SIZE;
+    for (u32 tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++) {
+        for (u32 tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++) {
+            auto& bin = bins[tile_y * NUM_TILES + tile_x];
+            if (bin.empty()) {
+                active_bins.push_back(tile_y * NUM_TILES + tile_x);
+            }
+            bin.push_back(index);
+        }
+    }
+
+    if (triangles.size() >= MAX_BINNED_TRIANGLES) {
+        FlushTriangles();
+    }
+}
+
+void RasterizerSoftware::FlushTriangles() {
+    if (triangles.empty()) {
+        return;
+    }
+
+    MICROPROFILE_SCOPE(GPU_Rasterization);
+
+    fb.Bind();
+    texture_cache.RunGarbageCollector();
+    BindTextures();
+    fragment_pipeline = &GetFragmentPipeline();
+
+    for (const u32 tile : active_bins) {
+        sw_workers.QueueWork([this, tile] {
+            // Tile bounds in 12.4 fixed point, clamped to the range of the coordinates
+            const u32 tile_x = (tile % NUM_TILES) * TILE_SIZE << 4;
+            const u32 tile_y = (tile / NUM_TILES) * TILE_SIZE << 4;
+            const u32 tile_end_x = std::min<u32>(tile_x + (TILE_SIZE << 4), 0xFFFF);
+            const u32 tile_end_y = std::min<u32>(tile_y + (TILE_SIZE << 4), 0xFFFF);
+            const RasterizeFunc rasterize = fragment_pipeline->rasterize;
+            for (const u32 index : bins[tile]) {
+                const Triangle& triangle = triangles[index];
+                (this->*rasterize)(triangle,
+                                   static_cast<u16>(std::max<u32>(triangle.min_x, tile_x)),
+                                   static_cast<u16>(std::max<u32>(triangle.min_y, tile_y)),
+                                   static_cast<u16>(std::min<u32>(triangle.max_x, tile_end_x)),
+                                   static_cast<u16>(std::min<u32>(triangle.max_y, tile_end_y)));
+            }
+        });
+    }
+    sw_workers.WaitForRequests();
+
+    // The framebuffer is written to directly, so textures decoded from it are now outdated.
+    // Pixels are at most 4 bytes large, including those of shadow maps.
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const u32 framebuffer_size = framebuffer.GetWidth() * framebuffer.GetHeight() * 4;
+    texture_cache.InvalidateRegion(framebuffer.GetColorBufferPhysicalAddress(), framebuffer_size);
+    texture_cache.InvalidateRegion(framebuffer.GetDepthBufferPhysicalAddress(), framebuffer_size);
+
+    for (const u32 tile : active_bins) {
+        bins[tile].clear();
+    }
+    active_bins.clear();
+    triangles.clear();
+}
+
+const RasterizerSoftware::FragmentPipeline& RasterizerSoftware::GetFragmentPipeline() {
+    // Key the pipelines like the fragment shaders of the hardware renderers, without any of the
+    // host specific emulation.
+    const Pica::Shader::Generator::PicaFSConfig config{regs, false, false, false, false};
+    const auto [iter, is_new] = fragment_pipelines.try_emplace(config);
+    FragmentPipeline& pipeline = iter->second;
+    if (!is_new) {
+        return pipeline;
+    }
+
+    static constexpr auto rasterize_funcs =
+        []<u32... feature_sets>(std::integer_sequence<u32, feature_sets...>) {
+            return std::array<RasterizeFunc, sizeof...(feature_sets)>{
+                &RasterizerSoftware::RasterizeTriangle<feature_sets>...};
+        }(std::make_integer_sequence<u32, NUM_FEATURE_COMBINATIONS>{});
+
+    const auto& fs_state = config.state;
+    u32 features = 0;
+    if (fs_state.lighting.enable) {
+        features |= FEATURE_LIGHTING;
+    }
+    if (fs_state.alpha_test_func != FramebufferRegs::CompareFunc::Always) {
+        features |= FEATURE_ALPHA_TEST;
+    }
+    if (fs_state.fog_mode == TexturingRegs::FogMode::Fog) {
+        features |= FEATURE_FOG;
+    }
+    if (fs_state.shadow_rendering) {
+        features |= FEATURE_SHADOW_RENDERING;
+    }
+    pipeline.rasterize = rasterize_funcs[features];
+
+    // Pass-through stages can only be skipped if none of the stages reads the combiner buffer,
+    // which is updated by every stage.
+    using Source = TexturingRegs::TevStageConfig::Source;
+    pipeline.uses_combiner_buffer = false;
+    for (const auto& raw_stage : fs_state.tev_stages) {
+        const auto stage = static_cast<TexturingRegs::TevStageConfig>(raw_stage);
+        for (const Source source : {stage.color_source1.Value(), stage.color_source2.Value(),
+                                    stage.color_source3.Value(), stage.alpha_source1.Value(),
+                                    stage.alpha_source2.Value(), stage.alpha_source3.Value()}) {
+            pipeline.uses_combiner_buffer |= source == Source::PreviousBuffer;
+        }
+    }
+
+    pipeline.num_tev_stages = 0;
+    for (u32 i = 0; i < fs_state.tev_stages.size(); ++i) {
+        const auto stage = static_cast<TexturingRegs::TevStageConfig>(fs_state.tev_stages[i]);
+        if (pipeline.uses_combiner_buffer || !IsPassThroughTevStage(stage)) {
+            pipeline.tev_stages[pipeline.num_tev_stages++] = static_cast<u8>(i);
+        }
+    }
+
+    LOG_DEBUG(Render_Software, "Created fragment pipeline with features {:#x} and {} TEV stages",
+              features, pipeline.num_tev_stages);
+    return pipeline;
+}
+
+void RasterizerSoftware::BindTextures() {
+    const auto textures = regs.texturing.GetTextures();
+    for (u32 i = 0; i < 3; ++i) {
+        const auto& texture = textures[i];
+        bound_textures[i] = nullptr;
+        if (!texture.enabled || texture.config.address == 0) {
+            continue;
+        }
+
+        auto info = TextureInfo::FromPicaRegister(texture.config, texture.format);
+        if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::TextureCube ||
+                       texture.config.type == TexturingRegs::TextureConfig::ShadowCube)) {
+            for (u32 face = 0; face < bound_cube_faces.size(); ++face) {
+                const auto cube_face = static_cast<TexturingRegs::CubeFace>(face);
+                info.physical_address = regs.texturing.GetCubePhysicalAddress(cube_face);
+                bound_cube_faces[face] = texture_cache.GetTexture(info);
+            }
+        } else if (i != 0 || texture.config.type != TexturingRegs::TextureConfig::Disabled) {
+            bound_textures[i] = texture_cache.GetTexture(info);
+        }
+    }
+}
+
+template <u32 features>
+void RasterizerSoftware::RasterizeTriangle(const Triangle& triangle, u16 min_x, u16 min_y,
+                                           u16 max_x, u16 max_y) const {
+    const auto& [v0, v1, v2] = triangle.vertices;
+    const auto& vtxpos = triangle.vtxpos;
+    const std::array<EdgeFunction, 3> edges{{
+        {vtxpos[1].xy(), vtxpos[2].xy(), triangle.bias[0]},
+        {vtxpos[2].xy(), vtxpos[0].xy(), triangle.bias[1]},
+        {vtxpos[0].xy(), vtxpos[1].xy(), triangle.bias[2]},
+    }};
+
+    // Convert the scissor box coordinates to 12.4 fixed point
+    const u16 scissor_x1 = static_cast<u16>(regs.rasterizer.scissor_test.x1 << 4);
+    const u16 scissor_y1 = static_cast<u16>(regs.rasterizer.scissor_test.y1 << 4);
+    // x2,y2 have +1 added to cover the entire sub-pixel area
+    const u16 scissor_x2 = static_cast<u16>((regs.rasterizer.scissor_test.x2 + 1) << 4);
+    const u16 scissor_y2 = static_cast<u16>((regs.rasterizer.scissor_test.y2 + 1) << 4);
+    const bool scissor_exclude =
+        regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude;
+
     const auto w_inverse = Common::MakeVec(v0.pos.w, v1.pos.w, v2.pos.w);
 
     const auto textures = regs.texturing.GetTextures();
     const auto tev_stages = regs.texturing.GetTevStages();
 
-    fb.Bind();
+    // Not fully accurate. About 3 bits in precision are missing.
+    // Z-Buffer (z / w * scale + offset)
+    const float depth_scale = f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
+    const float depth_offset =
+        f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
+    const bool w_buffering =
+        regs.rasterizer.depthmap_enable == Pica::RasterizerRegs::DepthBuffering::WBuffering;
 
-    // Enter rasterization loop, starting at the center of the topleft bounding box corner.
-    // TODO: Not sure if looping through x first might be faster
-    for (u16 y = min_y + 8; y < max_y; y += 0x10) {
-        const auto process_scanline = [&, y] {
-            for (u16 x = min_x + 8; x < max_x; x += 0x10) {
-                // Do not process the pixel if it's inside the scissor box and the scissor mode is
-                // set to Exclude.
-                if (regs.rasterizer.scissor_test.mode == RasterizerRegs::ScissorMode::Exclude) {
-                    if (x >= scissor_x1 && x < scissor_x2 && y >= scissor_y1 && y < scissor_y2) {
-                        continue;
-                    }
+    // Without stencil actions, a fragment failing the depth test has no effect at all, so the
+    // depth test can be done for a whole span before any of its fragments is shaded.
+    const auto& framebuffer = regs.framebuffer.framebuffer;
+    const auto& output_merger = regs.framebuffer.output_merger;
+    const bool early_depth_test =
+        (features & FEATURE_SHADOW_RENDERING) == 0 && output_merger.depth_test_enable &&
+        output_merger.depth_test_func != FramebufferRegs::CompareFunc::Always &&
+        !(output_merger.stencil_test.enable &&
+          framebuffer.depth_format == FramebufferRegs::DepthFormat::D24S8);
+    const u32 depth_bits = FramebufferRegs::DepthBitsPerPixel(framebuffer.depth_format);
+
+    const auto get_baricentric_coordinates = [](s32 w0, s32 w1, s32 w2) {
+        return Common::MakeVec(f24::FromFloat32(static_cast<f32>(w0)),
+                               f24::FromFloat32(static_cast<f32>(w1)),
+                               f24::FromFloat32(static_cast<f32>(w2)));
+    };
+
+    const auto get_depth = [&](s32 w0, s32 w1, s32 w2) {
+        const s32 wsum = w0 + w1 + w2;
+
+        // interpolated_z = z / w
+        const float interpolated_z_over_w =
+            (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
+             v2.screenpos[2].ToFloat32() * w2) /
+            wsum;
+        float depth = interpolated_z_over_w * depth_scale + depth_offset;
+
+        // Potentially switch to W-Buffer
+        if (w_buffering) {
+            // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
+            const f24 interpolated_w_inverse =
+                f24::One() / Common::Dot(w_inverse, get_baricentric_coordinates(w0, w1, w2));
+            depth *= interpolated_w_inverse.ToFloat32() * wsum;
+        }
+
+        // Clamp the result
+        return std::clamp(depth, 0.0f, 1.0f);
+    };
+
+    const auto process_fragment = [&](u16 x, u16 y, s32 w0, s32 w1, s32 w2, float depth) {
+        const auto baricentric_coordinates = get_baricentric_coordinates(w0, w1, w2);
+        const f24 interpolated_w_inverse =
+            f24::One() / Common::Dot(w_inverse, baricentric_coordinates);
+
+        /**
+         * Perspective correct attribute interpolation:
+         * Attribute values cannot be calculated by simple linear interpolation since
+         * they are not linear in screen space. For example, when interpolating a
+         * texture coordinate across two vertices, something simple like
+         *     u = (u0*w0 + u1*w1)/(w0+w1)
+         * will not work. However, the attribute value divided by the
+         * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
+         * in screenspace. Hence, we can linearly interpolate these two independently and
+         * calculate the interpolated attribute by dividing the results.
+         * I.e.
+         *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
+         *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
+         *     u = u_over_w / one_over_w
+         *
+         * The generalization to three vertices is straightforward in baricentric
+         *coordinates.
+         **/
+        const auto get_interpolated_attribute = [&](f24 attr0, f24 attr1, f24 attr2) {
+            auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
+            f24 interpolated_attr_over_w = Common::Dot(attr_over_w, baricentric_coordinates);
+            return interpolated_attr_over_w * interpolated_w_inverse;
+        };
+
+        const Common::Vec4<u8> primary_color{
+            static_cast<u8>(
+                round(get_interpolated_attribute(v0.color.r(), v1.color.r(), v2.color.r())
+                          .ToFloat32() *
+                      255)),
+            static_cast<u8>(
+                round(get_interpolated_attribute(v0.color.g(), v1.color.g(), v2.color.g())
+                          .ToFloat32() *
+                      255)),
+            static_cast<u8>(
+                round(get_interpolated_attribute(v0.color.b(), v1.color.b(), v2.color.b())
+                          .ToFloat32() *
+                      255)),
+            static_cast<u8>(
+                round(get_interpolated_attribute(v0.color.a(), v1.color.a(), v2.color.a())
+                          .ToFloat32() *
+                      255)),
+        };
+
+        std::array<Common::Vec2<f24>, 3> uv;
+        uv[0].u() = get_interpolated_attribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
+        uv[0].v() = get_interpolated_attribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
+        uv[1].u() = get_interpolated_attribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
+        uv[1].v() = get_interpolated_attribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
+        uv[2].u() = get_interpolated_attribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
+        uv[2].v() = get_interpolated_attribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
+
+        // Sample bound texture units.
+        const f24 tc0_w = get_interpolated_attribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
+        const auto texture_color = TextureColor(uv, textures, tc0_w);
+
+        Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
+        Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
+
+        if constexpr ((features & FEATURE_LIGHTING) != 0) {
+            const auto normquat =
+                Common::Quaternion<f32>{
+                    {get_interpolated_attribute(v0.quat.x, v1.quat.x, v2.quat.x).ToFloat32(),
+                     get_interpolated_attribute(v0.quat.y, v1.quat.y, v2.quat.y).ToFloat32(),
+                     get_interpolated_attribute(v0.quat.z, v1.quat.z, v2.quat.z).ToFloat32()},
+                    get_interpolated_attribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
                 }
+                    .Normalized();
+
+            const Common::Vec3f view{
+                get_interpolated_attribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
+                get_interpolated_attribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
+                get_interpolated_attribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
+            };
+            std::tie(primary_fragment_color, secondary_fragment_color) =
+                ComputeFragmentsColors(regs.lighting, state.lighting, normquat, view,
+                                       texture_color);
+        }
 
-                // Calculate the barycentric coordinates w0, w1 and w2
-                const s32 w0 = bias0 + SignedArea(vtxpos[1].xy(), vtxpos[2].xy(), {x, y});
-                const s32 w1 = bias1 + SignedArea(vtxpos[2].xy(), vtxpos[0].xy(), {x, y});
-                const s32 w2 = bias2 + SignedArea(vtxpos[0].xy(), vtxpos[1].xy(), {x, y});
-                const s32 wsum = w0 + w1 + w2;
+        // Write the TEV stages.
+        auto combiner_output =
+            WriteTevConfig(texture_color, tev_stages, *fragment_pipeline, primary_color,
+                           primary_fragment_color, secondary_fragment_color);
+
+        if constexpr ((features & FEATURE_SHADOW_RENDERING) != 0) {
+            const u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
+            // Use green color as the shadow intensity
+            const u8 stencil = combiner_output.y;
+            fb.DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
+            // Skip the normal output merger pipeline if it is in shadow mode
+            return;
+        }
 
-                // If current pixel is not covered by the current primitive
-                if (w0 < 0 || w1 < 0 || w2 < 0) {
-                    continue;
+        // Does alpha testing happen before or after stencil?
+        if constexpr ((features & FEATURE_ALPHA_TEST) != 0) {
+            if (!DoAlphaTest(combiner_output.a())) {
+                return;
+            }
+        }
+        if constexpr ((features & FEATURE_FOG) != 0) {
+            WriteFog(depth, combiner_output);
+        }
+        if (!DoDepthStencilTest(x, y, depth)) {
+            return;
+        }
+        const auto result = PixelColor(x, y, combiner_output);
+        if (regs.framebuffer.framebuffer.allow_color_write != 0) {
+            fb.DrawPixel(x >> 4, y >> 4, result);
+        }
+    };
+
+    // Rasterize the bounding box in blocks aligned to the 8x8 tiles of the framebuffer. Each row
+    // of a block is processed as a span, computing coverage and depth for all of its pixels
+    // before shading the covered ones.
+    constexpr u32 BLOCK_STEP = SPAN_SIZE << 4;
+    const u32 first_x = min_x + 8;
+    const u32 first_y = min_y + 8;
+    for (u32 block_y = min_y & ~(BLOCK_STEP - 1); block_y < max_y; block_y += BLOCK_STEP) {
+        const u32 span_first_y = std::max(block_y + 8, first_y);
+        const u32 span_last_y = std::min<u32>(block_y + BLOCK_STEP, max_y) - 8;
+        for (u32 block_x = min_x & ~(BLOCK_STEP - 1); block_x < max_x; block_x += BLOCK_STEP) {
+            const u32 span_first_x = std::max(block_x + 8, first_x);
+            const u32 span_last_x = std::min<u32>(block_x + BLOCK_STEP, max_x) - 8;
+
+            // Edge functions are linear, so if all corner samples of the block are outside of
+            // one edge, so are all the others.
+            const bool outside = std::any_of(edges.begin(), edges.end(), [&](const auto& edge) {
+                return edge.Evaluate(span_first_x, span_first_y) < 0 &&
+                       edge.Evaluate(span_last_x, span_first_y) < 0 &&
+                       edge.Evaluate(span_first_x, span_last_y) < 0 &&
+                       edge.Evaluate(span_last_x, span_last_y) < 0;
+            });
+            if (outside) {
+#ifdef DEBUG
+                for (u32 y = span_first_y; y <= span_last_y; y += 0x10) {
+                    for (u32 x = span_first_x; x <= span_last_x; x += 0x10) {
+                        ASSERT_MSG(!IsCovered(vtxpos, triangle.bias, x, y),
+                                   "Rejected block covers sample ({}, {})", x, y);
+                    }
                 }
+#endif
+                continue;
+            }
 
-                const auto baricentric_coordinates = Common::MakeVec(
-                    f24::FromFloat32(static_cast<f32>(w0)), f24::FromFloat32(static_cast<f32>(w1)),
-                    f24::FromFloat32(static_cast<f32>(w2)));
-                const f24 interpolated_w_inverse =
-                    f24::One() / Common::Dot(w_inverse, baricentric_coordinates);
-
-                // interpolated_z = z / w
-                const float interpolated_z_over_w =
-                    (v0.screenpos[2].ToFloat32() * w0 + v1.screenpos[2].ToFloat32() * w1 +
-                     v2.screenpos[2].ToFloat32() * w2) /
-                    wsum;
-
-                // Not fully accurate. About 3 bits in precision are missing.
-                // Z-Buffer (z / w * scale + offset)
-                const float depth_scale =
-                    f24::FromRaw(regs.rasterizer.viewport_depth_range).ToFloat32();
-                const float depth_offset =
-                    f24::FromRaw(regs.rasterizer.viewport_depth_near_plane).ToFloat32();
-                float depth = interpolated_z_over_w * depth_scale + depth_offset;
-
-                // Potentially switch to W-Buffer
-                if (regs.rasterizer.depthmap_enable ==
-                    Pica::RasterizerRegs::DepthBuffering::WBuffering) {
-                    // W-Buffer (z * scale + w * offset = (z / w * scale + offset) * w)
-                    depth *= interpolated_w_inverse.ToFloat32() * wsum;
+            for (u32 y = span_first_y; y <= span_last_y; y += 0x10) {
+                std::array<s32, SPAN_SIZE> w0;
+                std::array<s32, SPAN_SIZE> w1;
+                std::array<s32, SPAN_SIZE> w2;
+                u32 coverage = 0;
+                for (u32 lane = 0; lane < SPAN_SIZE; ++lane) {
+                    const u32 x = block_x + (lane << 4) + 8;
+                    w0[lane] = edges[0].Evaluate(x, y);
+                    w1[lane] = edges[1].Evaluate(x, y);
+                    w2[lane] = edges[2].Evaluate(x, y);
+                    const bool inside = x >= span_first_x && x <= span_last_x &&
+                                        (w0[lane] | w1[lane] | w2[lane]) >= 0;
+                    coverage |= static_cast<u32>(inside) << lane;
                 }
 
-                // Clamp the result
-                depth = std::clamp(depth, 0.0f, 1.0f);
-
-                /**
-                 * Perspective correct attribute interpolation:
-                 * Attribute values cannot be calculated by simple linear interpolation since
-                 * they are not linear in screen space. For example, when interpolating a
-                 * texture coordinate across two vertices, something simple like
-                 *     u = (u0*w0 + u1*w1)/(w0+w1)
-                 * will not work. However, the attribute value divided by the
-                 * clipspace w-coordinate (u/w) and and the inverse w-coordinate (1/w) are linear
-                 * in screenspace. Hence, we can linearly interpolate these two independently and
-                 * calculate the interpolated attribute by dividing the results.
-                 * I.e.
-                 *     u_over_w   = ((u0/v0.pos.w)*w0 + (u1/v1.pos.w)*w1)/(w0+w1)
-                 *     one_over_w = (( 1/v0.pos.w)*w0 + ( 1/v1.pos.w)*w1)/(w0+w1)
-                 *     u = u_over_w / one_over_w
-                 *
-                 * The generalization to three vertices is straightforward in baricentric
-                 *coordinates.
-                 **/
-                const auto get_interpolated_attribute = [&](f24 attr0, f24 attr1, f24 attr2) {
-                    auto attr_over_w = Common::MakeVec(attr0, attr1, attr2);
-                    f24 interpolated_attr_over_w =
-                        Common::Dot(attr_over_w, baricentric_coordinates);
-                    return interpolated_attr_over_w * interpolated_w_inverse;
-                };
-
-                const Common::Vec4<u8> primary_color{
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.r(), v1.color.r(), v2.color.r())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.g(), v1.color.g(), v2.color.g())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.b(), v1.color.b(), v2.color.b())
-                                  .ToFloat32() *
-                              255)),
-                    static_cast<u8>(
-                        round(get_interpolated_attribute(v0.color.a(), v1.color.a(), v2.color.a())
-                                  .ToFloat32() *
-                              255)),
-                };
-
-                std::array<Common::Vec2<f24>, 3> uv;
-                uv[0].u() = get_interpolated_attribute(v0.tc0.u(), v1.tc0.u(), v2.tc0.u());
-                uv[0].v() = get_interpolated_attribute(v0.tc0.v(), v1.tc0.v(), v2.tc0.v());
-                uv[1].u() = get_interpolated_attribute(v0.tc1.u(), v1.tc1.u(), v2.tc1.u());
-                uv[1].v() = get_interpolated_attribute(v0.tc1.v(), v1.tc1.v(), v2.tc1.v());
-                uv[2].u() = get_interpolated_attribute(v0.tc2.u(), v1.tc2.u(), v2.tc2.u());
-                uv[2].v() = get_interpolated_attribute(v0.tc2.v(), v1.tc2.v(), v2.tc2.v());
-
-                // Sample bound texture units.
-                const f24 tc0_w = get_interpolated_attribute(v0.tc0_w, v1.tc0_w, v2.tc0_w);
-                const auto texture_color = TextureColor(uv, textures, tc0_w);
-
-                Common::Vec4<u8> primary_fragment_color = {0, 0, 0, 0};
-                Common::Vec4<u8> secondary_fragment_color = {0, 0, 0, 0};
-
-                if (!regs.lighting.disable) {
-                    const auto normquat =
-                        Common::Quaternion<f32>{
-                            {get_interpolated_attribute(v0.quat.x, v1.quat.x, v2.quat.x)
-                                 .ToFloat32(),
-                             get_interpolated_attribute(v0.quat.y, v1.quat.y, v2.quat.y)
-                                 .ToFloat32(),
-                             get_interpolated_attribute(v0.quat.z, v1.quat.z, v2.quat.z)
-                                 .ToFloat32()},
-                            get_interpolated_attribute(v0.quat.w, v1.quat.w, v2.quat.w).ToFloat32(),
+                // Do not process the pixels inside the scissor box if the scissor mode is set
+                // to Exclude.
+                if (scissor_exclude && y >= scissor_y1 && y < scissor_y2) {
+                    for (u32 lane = 0; lane < SPAN_SIZE; ++lane) {
+                        const u32 x = block_x + (lane << 4) + 8;
+                        if (x >= scissor_x1 && x < scissor_x2) {
+                            coverage &= ~(1U << lane);
                         }
-                            .Normalized();
-
-                    const Common::Vec3f view{
-                        get_interpolated_attribute(v0.view.x, v1.view.x, v2.view.x).ToFloat32(),
-                        get_interpolated_attribute(v0.view.y, v1.view.y, v2.view.y).ToFloat32(),
-                        get_interpolated_attribute(v0.view.z, v1.view.z, v2.view.z).ToFloat32(),
-                    };
-                    std::tie(primary_fragment_color, secondary_fragment_color) =
-                        ComputeFragmentsColors(regs.lighting, state.lighting, normquat, view,
-                                               texture_color);
+                    }
                 }
 
-                // Write the TEV stages.
-                auto combiner_output =
-                    WriteTevConfig(texture_color, tev_stages, primary_color, primary_fragment_color,
-                                   secondary_fragment_color);
-
-                const auto& output_merger = regs.framebuffer.output_merger;
-                if (output_merger.fragment_operation_mode ==
-                    FramebufferRegs::FragmentOperationMode::Shadow) {
-                    const u32 depth_int = static_cast<u32>(depth * 0xFFFFFF);
-                    // Use green color as the shadow intensity
-                    const u8 stencil = combiner_output.y;
-                    fb.DrawShadowMapPixel(x >> 4, y >> 4, depth_int, stencil);
-                    // Skip the normal output merger pipeline if it is in shadow mode
-                    continue;
+#ifdef DEBUG
+                // Check the span against the per pixel coverage test
+                for (u32 lane = 0; lane < SPAN_SIZE; ++lane) {
+                    const u32 x = block_x + (lane << 4) + 8;
+                    const bool excluded = scissor_exclude && x >= scissor_x1 && x < scissor_x2 &&
+                                          y >= scissor_y1 && y < scissor_y2;
+                    if (x >= span_first_x && x <= span_last_x && !excluded) {
+                        const bool covered = ((coverage >> lane) & 1) != 0;
+                        ASSERT_MSG(covered == IsCovered(vtxpos, triangle.bias, x, y),
+                                   "Span coverage mismatch at sample ({}, {})", x, y);
+                    }
                 }
+#endif
 
-                // Does alpha testing happen before or after stencil?
-                if (!DoAlphaTest(combiner_output.a())) {
-                    continue;
+                std::array<float, SPAN_SIZE> depth;
+                for (u32 mask = coverage; mask != 0; mask &= mask - 1) {
+                    const u32 lane = std::countr_zero(mask);
+                    depth[lane] = get_depth(w0[lane], w1[lane], w2[lane]);
                 }
-                WriteFog(depth, combiner_output);
-                if (!DoDepthStencilTest(x, y, depth)) {
-                    continue;
+
+                if (early_depth_test) {
+                    for (u32 mask = coverage; mask != 0; mask &= mask - 1) {
+                        const u32 lane = std::countr_zero(mask);
+                        const u32 x = block_x + (lane << 4) + 8;
+                        const u32 z = static_cast<u32>(depth[lane] * ((1 << depth_bits) - 1));
+                        if (!TestDepth(output_merger.depth_test_func, z,
+                                       fb.GetDepth(x >> 4, y >> 4))) {
+                            coverage &= ~(1U << lane);
+                        }
+                    }
                 }
-                const auto result = PixelColor(x, y, combiner_output);
-                if (regs.framebuffer.framebuffer.allow_color_write != 0) {
-                    fb.DrawPixel(x >> 4, y >> 4, result);
+
+                for (u32 mask = coverage; mask != 0; mask &= mask - 1) {
+                    const u32 lane = std::countr_zero(mask);
+                    process_fragment(static_cast<u16>(block_x + (lane << 4) + 8),
+                                     static_cast<u16>(y), w0[lane], w1[lane], w2[lane],
+                                     depth[lane]);
                 }
             }
-        };
-        sw_workers.QueueWork(std::move(process_scanline));
+        }
     }
-    sw_workers.WaitForRequests();
 }
 
 std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
@@ -493,6 +880,7 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
 
         // Only unit 0 respects the texturing type (according to 3DBrew)
         PAddr texture_address = texture.config.GetPhysicalAddress();
+        const TextureCache::Texture* decoded_texture = bound_textures[i];
         f24 shadow_z;
         if (i == 0) {
             switch (texture.config.type) {
@@ -502,6 +890,11 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
             case TexturingRegs::TextureConfig::TextureCube: {
                 std::tie(u, v, shadow_z, texture_address) =
                     ConvertCubeCoord(u, v, tc0_w, regs.texturing);
+                const auto iter = std::find_if(
+                    bound_cube_faces.begin(), bound_cube_faces.end(), [&](const auto* face) {
+                        return face && face->info.physical_address == texture_address;
+                    });
+                decoded_texture = iter != bound_cube_faces.end() ? *iter : nullptr;
                 break;
             }
             case TexturingRegs::TextureConfig::Projection2D: {
@@ -559,11 +952,14 @@ std::array<Common::Vec4<u8>, 4> RasterizerSoftware::TextureColor(
             t = texture.config.height - 1 -
                 GetWrappedTexCoord(texture.config.wrap_t, t, texture.config.height);
 
-            const u8* texture_data = memory.GetPhysicalPointer(texture_address);
-            const auto info = TextureInfo::FromPicaRegister(texture.config, texture.format);
-
             // TODO: Apply the min and mag filters to the texture
-            texture_color[i] = LookupTexture(texture_data, s, t, info);
+            if (decoded_texture) [[likely]] {
+                texture_color[i] = decoded_texture->Lookup(s, t);
+            } else {
+                const u8* texture_data = memory.GetPhysicalPointer(texture_address);
+                const auto info = TextureInfo::FromPicaRegister(texture.config, texture.format);
+                texture_color[i] = LookupTexture(texture_data, s, t, info);
+            }
         }
 
         if (i == 0 && (texture.config.type == TexturingRegs::TextureConfig::Shadow2D ||
@@ -687,8 +1083,8 @@ Common::Vec4<u8> RasterizerSoftware::PixelColor(u16 x, u16 y,
 Common::Vec4<u8> RasterizerSoftware::WriteTevConfig(
     std::span<const Common::Vec4<u8>, 4> texture_color,
     std::span<const Pica::TexturingRegs::TevStageConfig, 6> tev_stages,
-    Common::Vec4<u8> primary_color, Common::Vec4<u8> primary_fragment_color,
-    Common::Vec4<u8> secondary_fragment_color) {
+    const FragmentPipeline& pipeline, Common::Vec4<u8> primary_color,
+    Common::Vec4<u8> primary_fragment_color, Common::Vec4<u8> secondary_fragment_color) const {
     /**
      * Texture environment - consists of 6 stages of color and alpha combining.
      * Color combiners take three input color values from some source (e.g. interpolated
@@ -706,7 +1102,8 @@ Common::Vec4<u8> RasterizerSoftware::WriteTevConfig(
                         regs.texturing.tev_combiner_buffer_color.a.Value())
             .Cast<u8>();
 
-    for (u32 tev_stage_index = 0; tev_stage_index < tev_stages.size(); ++tev_stage_index) {
+    for (u32 i = 0; i < pipeline.num_tev_stages; ++i) {
+        const u32 tev_stage_index = pipeline.tev_stages[i];
         const auto& tev_stage = tev_stages[tev_stage_index];
         using Source = TexturingRegs::TevStageConfig::Source;
 
@@ -774,6 +1171,10 @@ Common::Vec4<u8> RasterizerSoftware::WriteTevConfig(
         combiner_output[2] = std::min(255U, color_output.b() * tev_stage.GetColorMultiplier());
         combiner_output[3] = std::min(255U, alpha_output * tev_stage.GetAlphaMultiplier());
 
+        if (!pipeline.uses_combiner_buffer) {
+            continue;
+        }
+
         combiner_buffer = next_combiner_buffer;
 
         if (regs.texturing.tev_combiner_buffer_input.TevStageUpdatesCombinerBufferColor(
@@ -914,34 +1315,7 @@ bool RasterizerSoftware::DoDepthStencilTest(u16 x, u16 y, float depth) const {
     const auto& output_merger = regs.framebuffer.output_merger;
     if (output_merger.depth_test_enable) {
         const u32 ref_z = fb.GetDepth(x >> 4, y >> 4);
-        bool pass = false;
-        switch (output_merger.depth_test_func) {
-        case FramebufferRegs::CompareFunc::Never:
-            pass = false;
-            break;
-        case FramebufferRegs::CompareFunc::Always:
-            pass = true;
-            break;
-        case FramebufferRegs::CompareFunc::Equal:
-            pass = z == ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::NotEqual:
-            pass = z != ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::LessThan:
-            pass = z < ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::LessThanOrEqual:
-            pass = z <= ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThan:
-            pass = z > ref_z;
-            break;
-        case FramebufferRegs::CompareFunc::GreaterThanOrEqual:
-            pass = z >= ref_z;
-            break;
-        }
-        if (!pass) {
+        if (!TestDepth(output_merger.depth_test_func, z, ref_z)) {
             if (stencil_action_enable) {
                 update_stencil(stencil_test.action_depth_fail);
             }
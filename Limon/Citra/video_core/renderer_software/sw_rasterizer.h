@@ -5,11 +5,15 @@
 #pragma once
 
 #include <span>
+#include <unordered_map>
+#include <vector>
 #include "common/thread_worker.h"
 #include "video_core/rasterizer_interface.h"
 #include "video_core/regs_texturing.h"
 #include "video_core/renderer_software/sw_clipper.h"
 #include "video_core/renderer_software/sw_framebuffer.h"
+#include "video_core/renderer_software/sw_texture_cache.h"
+#include "video_core/shader/generator/shader_gen.h"
 
 namespace Pica::Shader {
 struct OutputVertex;
@@ -27,25 +31,56 @@ struct Vertex;
 class RasterizerSoftware : public VideoCore::RasterizerInterface {
 public:
     explicit RasterizerSoftware(Memory::MemorySystem& memory);
+    ~RasterizerSoftware() override;
 
     void AddTriangle(const Pica::Shader::OutputVertex& v0, const Pica::Shader::OutputVertex& v1,
                      const Pica::Shader::OutputVertex& v2) override;
-    void DrawTriangles() override {}
+    void DrawTriangles() override;
     void NotifyPicaRegisterChanged(u32 id) override {}
     void FlushAll() override {}
     void FlushRegion(PAddr addr, u32 size) override {}
-    void InvalidateRegion(PAddr addr, u32 size) override {}
-    void FlushAndInvalidateRegion(PAddr addr, u32 size) override {}
-    void ClearAll(bool flush) override {}
+    void InvalidateRegion(PAddr addr, u32 size) override;
+    void FlushAndInvalidateRegion(PAddr addr, u32 size) override;
+    void ClearAll(bool flush) override;
 
 private:
+    struct Triangle;
+
+    using RasterizeFunc = void (RasterizerSoftware::*)(const Triangle& triangle, u16 min_x,
+                                                       u16 min_y, u16 max_x, u16 max_y) const;
+
+    /// Fragment processing specialised for a fragment configuration.
+    struct FragmentPipeline {
+        RasterizeFunc rasterize;      ///< Rasterization loop without the disabled features
+        std::array<u8, 6> tev_stages; ///< Indices of the TEV stages that need to be evaluated
+        u32 num_tev_stages;
+        bool uses_combiner_buffer;
+    };
+
     /// Computes the screen coordinates of the provided vertex.
     void MakeScreenCoords(Vertex& vtx);
 
-    /// Processes the triangle defined by the provided vertices.
+    /// Sets up the triangle defined by the provided vertices and bins it into the tiles it covers.
     void ProcessTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2,
                          bool reversed = false);
 
+    /// Returns the fragment pipeline of the current fragment configuration, creating it if needed.
+    const FragmentPipeline& GetFragmentPipeline();
+
+    /// Looks up the decoded textures of the enabled texture units in the texture cache.
+    void BindTextures();
+
+    /// Rasterizes all binned triangles, each tile on a worker thread, and empties the bins.
+    void FlushTriangles();
+
+    /**
+     * Rasterizes the part of the triangle inside the given bounds, in 12.4 fixed point.
+     * @tparam features the fragment features enabled in the current configuration
+     */
+    template <u32 features>
+    void RasterizeTriangle(const Triangle& triangle, u16 min_x, u16 min_y, u16 max_x,
+                           u16 max_y) const;
+
     /// Returns the texture color of the currently processed pixel.
     std::array<Common::Vec4<u8>, 4> TextureColor(
         std::span<const Common::Vec2<f24>, 3> uv,
@@ -58,8 +93,8 @@ private:
     Common::Vec4<u8> WriteTevConfig(
         std::span<const Common::Vec4<u8>, 4> texture_color,
         std::span<const Pica::TexturingRegs::TevStageConfig, 6> tev_stages,
-        Common::Vec4<u8> primary_color, Common::Vec4<u8> primary_fragment_color,
-        Common::Vec4<u8> secondary_fragment_color);
+        const FragmentPipeline& pipeline, Common::Vec4<u8> primary_color,
+        Common::Vec4<u8> primary_fragment_color, Common::Vec4<u8> secondary_fragment_color) const;
 
     /// Blends fog to the combiner output if enabled.
     void WriteFog(float depth, Common::Vec4<u8>& combiner_output) const;
@@ -77,6 +112,14 @@ private:
     size_t num_sw_threads;
     Common::ThreadWorker sw_workers;
     Framebuffer fb;
+    TextureCache texture_cache;
+    std::array<const TextureCache::Texture*, 3> bound_textures{};
+    std::array<const TextureCache::Texture*, 6> bound_cube_faces{};
+    std::unordered_map<Pica::Shader::Generator::PicaFSConfig, FragmentPipeline> fragment_pipelines;
+    const FragmentPipeline* fragment_pipeline{};
+    std::vector<Triangle> triangles;
+    std::vector<std::vector<u32>> bins; ///< Indices of the triangles covering each tile, in order
+    std::vector<u32> active_bins;       ///< Tiles covered by at least one triangle
 };
 
 } // namespace SwRenderer
@@ -0,0 +1,134 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include "common/assert.h"
+#include "common/literals.h"
+#include "core/memory.h"
+#include "video_core/renderer_software/sw_texture_cache.h"
+
+namespace SwRenderer {
+
+using namespace Common::Literals;
+using Pica::Texture::TextureInfo;
+
+namespace {
+
+/// Maximum size of the decoded textures kept in the cache.
+constexpr std::size_t MAX_CACHED_SIZE = 64_MiB;
+
+u64 MakeKey(const TextureInfo& info) {
+    // Texture dimensions are 11 bits wide and formats 4 bits wide
+    return u64{info.physical_address} | u64{info.width} << 32 | u64{info.height} << 43 |
+           static_cast<u64>(info.format) << 54;
+}
+
+} // Anonymous namespace
+
+TextureCache::TextureCache(Memory::MemorySystem& memory_) : memory{memory_} {}
+
+TextureCache::~TextureCache() {
+    Clear();
+}
+
+const TextureCache::Texture* TextureCache::GetTexture(const TextureInfo& info) {
+    const u64 key = MakeKey(info);
+    if (const auto iter = lookup.find(key); iter != lookup.end()) {
+        textures.splice(textures.begin(), textures, iter->second);
+        return &*iter->second;
+    }
+
+    const u8* source = memory.GetPhysicalPointer(info.physical_address);
+    if (!source) [[unlikely]] {
+        return nullptr;
+    }
+
+    Texture& texture = textures.emplace_front();
+    texture.info = info;
+    texture.size = static_cast<u32>(Pica::Texture::CalculateTileSize(info.format) *
+                                    (info.width / 8) * (info.height / 8));
+    texture.texels.resize(info.width * info.height);
+    for (u32 y = 0; y < info.height; y++) {
+        for (u32 x = 0; x < info.width; x++) {
+            texture.texels[y * info.width + x] = Pica::Texture::LookupTexture(source, x, y, info);
+        }
+    }
+
+    lookup.emplace(key, textures.begin());
+    cached_size += texture.texels.size() * sizeof(Common::Vec4<u8>);
+    UpdatePagesCachedCount(info.physical_address, texture.size, 1);
+    return &texture;
+}
+
+void TextureCache::RunGarbageCollector() {
+    while (cached_size > MAX_CACHED_SIZE && !textures.empty()) {
+        Erase(std::prev(textures.end()));
+    }
+}
+
+void TextureCache::InvalidateRegion(PAddr addr, u32 size) {
+    if (textures.empty()) {
+        return;
+    }
+    const PAddr end = addr + size;
+    for (auto iter = textures.begin(); iter != textures.end();) {
+        const PAddr texture_addr = iter->info.physical_address;
+        if (texture_addr < end && addr < texture_addr + iter->size) {
+            Erase(iter++);
+        } else {
+            ++iter;
+        }
+    }
+}
+
+void TextureCache::Clear() {
+    while (!textures.empty()) {
+        Erase(textures.begin());
+    }
+}
+
+void TextureCache::Erase(TextureList::iterator iter) {
+    UpdatePagesCachedCount(iter->info.physical_address, iter->size, -1);
+    cached_size -= iter->texels.size() * sizeof(Common::Vec4<u8>);
+    lookup.erase(MakeKey(iter->info));
+    textures.erase(iter);
+}
+
+void TextureCache::UpdatePagesCachedCount(PAddr addr, u32 size, int delta) {
+    if (size == 0) {
+        return;
+    }
+    const u32 page_start = addr >> Memory::CITRA_PAGE_BITS;
+    const u32 page_end = ((addr + size - 1) >> Memory::CITRA_PAGE_BITS) + 1;
+
+    // Interval maps will erase segments if count reaches 0, so if delta is negative we have to
+    // subtract after iterating
+    const auto pages_interval = PageMap::interval_type::right_open(page_start, page_end);
+    if (delta > 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+
+    const auto [begin, end] = cached_pages.equal_range(pages_interval);
+    for (auto iter = begin; iter != end; ++iter) {
+        const auto interval = iter->first & pages_interval;
+        const int count = iter->second;
+
+        const PAddr interval_start_addr = boost::icl::first(interval) << Memory::CITRA_PAGE_BITS;
+        const PAddr interval_end_addr = boost::icl::last_next(interval) << Memory::CITRA_PAGE_BITS;
+        const u32 interval_size = interval_end_addr - interval_start_addr;
+
+        if (delta > 0 && count == delta) {
+            memory.RasterizerMarkRegionCached(interval_start_addr, interval_size, true);
+        } else if (delta < 0 && count == -delta) {
+            memory.RasterizerMarkRegionCached(interval_start_addr, interval_size, false);
+        } else {
+            ASSERT(count >= 0);
+        }
+    }
+
+    if (delta < 0) {
+        cached_pages.add({pages_interval, delta});
+    }
+}
+
+} // namespace SwRenderer
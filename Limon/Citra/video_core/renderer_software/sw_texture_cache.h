@@ -0,0 +1,75 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <boost/icl/interval_map.hpp>
+#include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/texture/texture_decode.h"
+
+namespace Memory {
+class MemorySystem;
+}
+
+namespace SwRenderer {
+
+/**
+ * Cache of guest textures decoded to linear RGBA8, so that sampling a texel is a plain array read
+ * instead of a morton swizzle and format decode. The pages backing each cached texture are marked
+ * as cached, which makes guest writes to them invalidate the texture through InvalidateRegion.
+ */
+class TextureCache {
+public:
+    struct Texture {
+        Pica::Texture::TextureInfo info;
+        u32 size; ///< Size of the encoded texture in guest memory
+        std::vector<Common::Vec4<u8>> texels;
+
+        /// Returns the texel at the given coordinates, as addressed by LookupTexture.
+        Common::Vec4<u8> Lookup(u32 x, u32 y) const {
+            return texels[y * info.width + x];
+        }
+    };
+
+    explicit TextureCache(Memory::MemorySystem& memory);
+    ~TextureCache();
+
+    /**
+     * Returns the decoded texture described by info, decoding it if it isn't cached. The texture
+     * stays valid until the next call to RunGarbageCollector, InvalidateRegion or Clear.
+     * Returns nullptr if the texture isn't backed by memory.
+     */
+    const Texture* GetTexture(const Pica::Texture::TextureInfo& info);
+
+    /// Evicts the least recently used textures while the cache is over its budget.
+    void RunGarbageCollector();
+
+    /// Drops all textures overlapping the given region.
+    void InvalidateRegion(PAddr addr, u32 size);
+
+    /// Drops all textures.
+    void Clear();
+
+private:
+    using TextureList = std::list<Texture>;
+    using PageMap = boost::icl::interval_map<u32, int>;
+
+    /// Removes the texture from the cache.
+    void Erase(TextureList::iterator iter);
+
+    /// Increases or decreases the number of textures in each page of the region.
+    void UpdatePagesCachedCount(PAddr addr, u32 size, int delta);
+
+    Memory::MemorySystem& memory;
+    TextureList textures; ///< Ordered from most to least recently used
+    std::unordered_map<u64, TextureList::iterator> lookup;
+    PageMap cached_pages;
+    std::size_t cached_size{}; ///< Size of all decoded texels in bytes
+};
+
+} // namespace SwRenderer
@@ -9,8 +9,6 @@
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
 #include "core/hw/gpu.h"
-#include "core/hw/hw.h"
-#include "core/hw/lcd.h"
 #include "video_core/renderer_vulkan/renderer_vulkan.h"
 #include "video_core/renderer_vulkan/vk_shader_util.h"
 
@@ -100,17 +98,11 @@ void RendererVulkan::Sync() {
     rasterizer.SyncEntireState();
 }
 
-void RendererVulkan::PrepareRendertarget() {
+void RendererVulkan::PrepareRendertarget(const VideoCore::FrameConfig& frame) {
     for (u32 i = 0; i < 3; i++) {
         const u32 fb_id = i == 2 ? 1 : 0;
-        const auto& framebuffer = GPU::g_regs.framebuffer_config[fb_id];
-
-        // Main LCD (0): 0x1ED02204, Sub LCD (1): 0x1ED02A04
-        u32 lcd_color_addr =
-            (fb_id == 0) ? LCD_REG_INDEX(color_fill_top) : LCD_REG_INDEX(color_fill_bottom);
-        lcd_color_addr = HW::VADDR_LCD + 4 * lcd_color_addr;
-        LCD::Regs::ColorFill color_fill{0};
-        LCD::Read(color_fill.raw, lcd_color_addr);
+        const auto& framebuffer = frame.framebuffers[fb_id];
+        const auto& color_fill = frame.color_fills[fb_id];
 
         if (color_fill.is_enabled) {
             LoadColorToActiveVkTexture(color_fill.color_r, color_fill.color_g, color_fill.color_b,
@@ -838,9 +830,9 @@ void RendererVulkan::DrawScreens(Frame* frame, const Layout::FramebufferLayout&
     });
 }
 
-void RendererVulkan::SwapBuffers() {
+void RendererVulkan::SwapBuffers(const VideoCore::FrameConfig& frame) {
     const Layout::FramebufferLayout& layout = render_window.GetFramebufferLayout();
-    PrepareRendertarget();
+    PrepareRendertarget(frame);
     RenderScreenshot();
     RenderToWindow(main_window, layout, false);
 #ifndef ANDROID
@@ -855,7 +847,6 @@ void RendererVulkan::SwapBuffers() {
     }
 #endif
     rasterizer.TickFrame();
-    EndFrame();
 }
 
 void RendererVulkan::RenderScreenshot() {
@@ -76,7 +76,7 @@ public:
         main_window.NotifySurfaceChanged();
     }
 
-    void SwapBuffers() override;
+    void SwapBuffers(const VideoCore::FrameConfig& frame) override;
     void TryPresent(int timeout_ms, bool is_secondary) override {}
     void Sync() override;
 
@@ -88,7 +88,7 @@ private:
     void ConfigureFramebufferTexture(TextureInfo& texture,
                                      const GPU::Regs::FramebufferConfig& framebuffer);
     void ConfigureRenderPipeline();
-    void PrepareRendertarget();
+    void PrepareRendertarget(const VideoCore::FrameConfig& frame);
     void RenderScreenshot();
     void PrepareDraw(Frame* frame, const Layout::FramebufferLayout& layout);
     void RenderToWindow(PresentWindow& window, const Layout::FramebufferLayout& layout,
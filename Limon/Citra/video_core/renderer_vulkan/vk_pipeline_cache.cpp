@@ -2,10 +2,15 @@
 // Licensed under GPLv2 or any later version
 // Refer to the license.txt file included.
 
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <thread>
 #include <boost/container/static_vector.hpp>
 
 #include "common/common_paths.h"
 #include "common/file_util.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/microprofile.h"
 #include "common/settings.h"
@@ -14,6 +19,7 @@
 #include "video_core/renderer_vulkan/vk_pipeline_cache.h"
 #include "video_core/renderer_vulkan/vk_renderpass_cache.h"
 #include "video_core/renderer_vulkan/vk_scheduler.h"
+#include "video_core/renderer_vulkan/vk_shader_disk_cache.h"
 #include "video_core/renderer_vulkan/vk_shader_util.h"
 
 using namespace Pica::Shader::Generator;
@@ -47,6 +53,22 @@ AttribLoadFlags MakeAttribLoadFlag(Pica::PipelineRegs::VertexAttributeFormat for
     }
 }
 
+/// Restores a PICA shader config from the raw state stored in the shader disk cache
+template <typename Config>
+std::optional<Config> ReadShaderConfig(std::span<const u8> data) {
+    Config config;
+    if (data.size() != sizeof(config.state)) {
+        return std::nullopt;
+    }
+    std::memcpy(&config.state, data.data(), sizeof(config.state));
+    return config;
+}
+
+template <typename Config>
+std::span<const u8> ShaderConfigBytes(const Config& config) {
+    return {reinterpret_cast<const u8*>(&config.state), sizeof(config.state)};
+}
+
 constexpr std::array<vk::DescriptorSetLayoutBinding, 6> BUFFER_BINDINGS = {{
     {0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex},
     {1, vk::DescriptorType::eUniformBufferDynamic, 1,
@@ -105,14 +127,22 @@ void PipelineCache::BuildLayout() {
 }
 
 PipelineCache::~PipelineCache() {
+    // Pending compilations reference the shaders and the shader disk cache
+    workers.WaitForRequests();
     SaveDiskCache();
 }
 
-void PipelineCache::LoadDiskCache() {
+void PipelineCache::LoadDiskCache(u64 title_id, const std::atomic_bool& stop_loading,
+                                  const VideoCore::DiskResourceLoadCallback& callback) {
     if (!Settings::values.use_disk_shader_cache || !EnsureDirectories()) {
         return;
     }
 
+    LoadPipelineCache();
+    LoadShaderDiskCache(title_id, stop_loading, callback);
+}
+
+void PipelineCache::LoadPipelineCache() {
     const std::string cache_file_path = fmt::format("{}{:x}{:x}.bin", GetPipelineCacheDir(),
                                                     instance.GetVendorID(), instance.GetDeviceID());
     vk::PipelineCacheCreateInfo cache_info = {
@@ -143,6 +173,129 @@ void PipelineCache::LoadDiskCache() {
     pipeline_cache = device.createPipelineCacheUnique(cache_info);
 }
 
+void PipelineCache::LoadShaderDiskCache(u64 title_id, const std::atomic_bool& stop_loading,
+                                        const VideoCore::DiskResourceLoadCallback& callback) {
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Prepare, 0, 0);
+    }
+
+    shader_disk_cache = std::make_unique<ShaderDiskCache>(instance, title_id);
+    std::vector<ShaderDiskCache::ShaderEntry> shader_entries;
+    std::vector<ShaderDiskCache::PipelineEntry> pipeline_entries;
+    shader_disk_cache->Load(shader_entries, pipeline_entries);
+
+    // Everything is compiled on the workers, this thread only tracks the progress
+    const vk::Device device = instance.GetDevice();
+    std::vector<const Common::AsyncHandle*> pending;
+    std::array<std::unordered_map<u64, Shader*>, MAX_SHADER_STAGES> loaded_shaders;
+    const auto compile = [&](Shader& shader, std::vector<u32>&& spirv) {
+        pending.push_back(&shader);
+        workers.QueueWork([device, &shader, spirv = std::move(spirv)] {
+            shader.module = CompileSPV(spirv, device);
+            shader.MarkDone();
+        });
+    };
+
+    for (auto& entry : shader_entries) {
+        switch (entry.type) {
+        case ShaderDiskCacheEntryType::VertexShader: {
+            const auto config = ReadShaderConfig<PicaVSConfig>(entry.config);
+            if (!config) {
+                break;
+            }
+            auto [it, new_config] = programmable_vertex_map.try_emplace(*config);
+            if (new_config) {
+                auto [iter, new_program] =
+                    programmable_vertex_cache.try_emplace(entry.program_hash, instance);
+                if (new_program) {
+                    compile(iter->second, std::move(entry.spirv));
+                }
+                it->second = &iter->second;
+            }
+            if (it->second) {
+                loaded_shaders[ProgramType::VS].emplace(config->Hash(), it->second);
+            }
+            break;
+        }
+        case ShaderDiskCacheEntryType::GeometryShader: {
+            const auto config = ReadShaderConfig<PicaFixedGSConfig>(entry.config);
+            if (!config) {
+                break;
+            }
+            auto [it, new_shader] = fixed_geometry_shaders.try_emplace(*config, instance);
+            if (new_shader) {
+                compile(it->second, std::move(entry.spirv));
+            }
+            loaded_shaders[ProgramType::GS].emplace(config->Hash(), &it->second);
+            break;
+        }
+        case ShaderDiskCacheEntryType::FragmentShader: {
+            const auto config = ReadShaderConfig<PicaFSConfig>(entry.config);
+            if (!config) {
+                break;
+            }
+            auto [it, new_shader] = fragment_shaders.try_emplace(*config, instance);
+            if (new_shader) {
+                compile(it->second, std::move(entry.spirv));
+            }
+            loaded_shaders[ProgramType::FS].emplace(config->Hash(), &it->second);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    for (const auto& entry : pipeline_entries) {
+        std::array<Shader*, MAX_SHADER_STAGES> stages{};
+        bool has_stages = true;
+        for (u32 i = 0; i < MAX_SHADER_STAGES && has_stages; i++) {
+            const u64 hash = entry.shader_hashes[i];
+            if (hash == 0 && i != ProgramType::FS) {
+                // Passthrough stages aren't recorded
+                stages[i] = i == ProgramType::VS ? &trivial_vertex_shader : nullptr;
+                continue;
+            }
+            const auto it = loaded_shaders[i].find(hash);
+            has_stages = it != loaded_shaders[i].end();
+            if (has_stages) {
+                stages[i] = it->second;
+            }
+        }
+        if (!has_stages) {
+            continue;
+        }
+
+        const u64 pipeline_hash = ComputePipelineHash(entry.shader_hashes, entry.info);
+        auto [it, new_pipeline] = graphics_pipelines.try_emplace(pipeline_hash);
+        if (!new_pipeline) {
+            continue;
+        }
+        it.value() = std::make_unique<GraphicsPipeline>(instance, renderpass_cache, entry.info,
+                                                        *pipeline_cache, *pipeline_layout, stages,
+                                                        &workers);
+        it->second->TryBuild(true);
+        pending.push_back(it->second.get());
+    }
+
+    const std::size_t total = pending.size();
+    while (!stop_loading) {
+        const std::size_t done = std::count_if(pending.begin(), pending.end(),
+                                               [](const auto* handle) { return handle->IsDone(); });
+        if (callback) {
+            callback(VideoCore::LoadCallbackStage::Build, done, total);
+        }
+        if (done == total) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    if (callback) {
+        callback(VideoCore::LoadCallbackStage::Complete, 0, 0);
+    }
+}
+
 void PipelineCache::SaveDiskCache() {
     if (!Settings::values.use_disk_shader_cache || !EnsureDirectories() || !pipeline_cache) {
         return;
@@ -169,19 +322,15 @@ void PipelineCache::SaveDiskCache() {
 bool PipelineCache::BindPipeline(const PipelineInfo& info, bool wait_built) {
     MICROPROFILE_SCOPE(Vulkan_Bind);
 
-    u64 shader_hash = 0;
-    for (u32 i = 0; i < MAX_SHADER_STAGES; i++) {
-        shader_hash = Common::HashCombine(shader_hash, shader_hashes[i]);
-    }
-
-    const u64 info_hash = info.Hash(instance);
-    const u64 pipeline_hash = Common::HashCombine(shader_hash, info_hash);
-
+    const u64 pipeline_hash = ComputePipelineHash(shader_hashes, info);
     auto [it, new_pipeline] = graphics_pipelines.try_emplace(pipeline_hash);
     if (new_pipeline) {
         it.value() =
             std::make_unique<GraphicsPipeline>(instance, renderpass_cache, info, *pipeline_cache,
                                                *pipeline_layout, current_shaders, &workers);
+        if (shader_disk_cache) {
+            shader_disk_cache->SavePipeline(shader_hashes, info);
+        }
     }
 
     GraphicsPipeline* const pipeline{it->second.get()};
@@ -316,14 +465,23 @@ bool PipelineCache::UseProgrammableVertexShader(const Pica::Regs& regs,
             return false;
         }
 
-        auto [iter, new_program] = programmable_vertex_cache.try_emplace(program, instance);
+        const u64 program_hash = Common::ComputeHash64(program.data(), program.size());
+        auto [iter, new_program] = programmable_vertex_cache.try_emplace(program_hash, instance);
         auto& shader = iter->second;
 
         if (new_program) {
             shader.program = std::move(program);
             const vk::Device device = instance.GetDevice();
-            workers.QueueWork([device, &shader] {
-                shader.module = Compile(shader.program, vk::ShaderStageFlagBits::eVertex, device);
+            workers.QueueWork([device, config, program_hash, &shader,
+                               disk_cache = shader_disk_cache.get()] {
+                const auto spirv = CompileGLSL(shader.program, vk::ShaderStageFlagBits::eVertex);
+                if (!spirv.empty()) {
+                    shader.module = CompileSPV(spirv, device);
+                }
+                if (disk_cache) {
+                    disk_cache->SaveShader(ShaderDiskCacheEntryType::VertexShader,
+                                           ShaderConfigBytes(config), program_hash, spirv);
+                }
                 shader.MarkDone();
             });
         }
@@ -359,9 +517,17 @@ bool PipelineCache::UseFixedGeometryShader(const Pica::Regs& regs) {
     auto& shader = it->second;
 
     if (new_shader) {
-        workers.QueueWork([gs_config, device = instance.GetDevice(), &shader]() {
+        workers.QueueWork([gs_config, device = instance.GetDevice(), &shader,
+                           disk_cache = shader_disk_cache.get()]() {
             const auto code = GLSL::GenerateFixedGeometryShader(gs_config, true);
-            shader.module = Compile(code, vk::ShaderStageFlagBits::eGeometry, device);
+            const auto spirv = CompileGLSL(code, vk::ShaderStageFlagBits::eGeometry);
+            if (!spirv.empty()) {
+                shader.module = CompileSPV(spirv, device);
+            }
+            if (disk_cache) {
+                disk_cache->SaveShader(ShaderDiskCacheEntryType::GeometryShader,
+                                       ShaderConfigBytes(gs_config), 0, spirv);
+            }
             shader.MarkDone();
         });
     }
@@ -394,11 +560,23 @@ void PipelineCache::UseFragmentShader(const Pica::Regs& regs) {
         if (use_spirv && !is_shadow) {
             const std::vector code = SPIRV::GenerateFragmentShader(config);
             shader.module = CompileSPV(code, instance.GetDevice());
+            if (shader_disk_cache) {
+                shader_disk_cache->SaveShader(ShaderDiskCacheEntryType::FragmentShader,
+                                              ShaderConfigBytes(config), 0, code);
+            }
             shader.MarkDone();
         } else {
-            workers.QueueWork([config, device = instance.GetDevice(), &shader]() {
+            workers.QueueWork([config, device = instance.GetDevice(), &shader,
+                               disk_cache = shader_disk_cache.get()]() {
                 const std::string code = GLSL::GenerateFragmentShader(config, true);
-                shader.module = Compile(code, vk::ShaderStageFlagBits::eFragment, device);
+                const auto spirv = CompileGLSL(code, vk::ShaderStageFlagBits::eFragment);
+                if (!spirv.empty()) {
+                    shader.module = CompileSPV(spirv, device);
+                }
+                if (disk_cache) {
+                    disk_cache->SaveShader(ShaderDiskCacheEntryType::FragmentShader,
+                                           ShaderConfigBytes(config), 0, spirv);
+                }
                 shader.MarkDone();
             });
         }
@@ -458,6 +636,15 @@ void PipelineCache::SetBufferOffset(u32 binding, size_t offset) {
     offsets[binding] = static_cast<u32>(offset);
 }
 
+u64 PipelineCache::ComputePipelineHash(const std::array<u64, MAX_SHADER_STAGES>& stage_hashes,
+                                       const PipelineInfo& info) const {
+    u64 shader_hash = 0;
+    for (u32 i = 0; i < MAX_SHADER_STAGES; i++) {
+        shader_hash = Common::HashCombine(shader_hash, stage_hashes[i]);
+    }
+    return Common::HashCombine(shader_hash, info.Hash(instance));
+}
+
 bool PipelineCache::IsCacheValid(std::span<const u8> data) const {
     if (data.size() < sizeof(vk::PipelineCacheHeaderVersionOne)) {
         LOG_ERROR(Render_Vulkan, "Pipeline cache failed validation: Invalid header");
@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <atomic>
 #include <bitset>
 #include <tsl/robin_map.h>
 
+#include "video_core/rasterizer_interface.h"
 #include "video_core/renderer_vulkan/vk_descriptor_pool.h"
 #include "video_core/renderer_vulkan/vk_graphics_pipeline.h"
 #include "video_core/shader/generator/glsl_shader_gen.h"
@@ -22,6 +24,7 @@ class Instance;
 class Scheduler;
 class RenderpassCache;
 class DescriptorPool;
+class ShaderDiskCache;
 
 constexpr u32 NUM_RASTERIZER_SETS = 3;
 constexpr u32 NUM_DYNAMIC_OFFSETS = 3;
@@ -39,8 +42,13 @@ public:
         return descriptor_set_providers[1];
     }
 
-    /// Loads the pipeline cache stored to disk
-    void LoadDiskCache();
+    /**
+     * Loads the pipeline cache stored to disk, then rebuilds the shaders and pipelines recorded
+     * for the title in previous sessions on the pipeline workers, reporting the progress to the
+     * callback.
+     */
+    void LoadDiskCache(u64 title_id, const std::atomic_bool& stop_loading,
+                       const VideoCore::DiskResourceLoadCallback& callback);
 
     /// Stores the generated pipeline cache to disk
     void SaveDiskCache();
@@ -83,6 +91,17 @@ private:
     /// Builds the rasterizer pipeline layout
     void BuildLayout();
 
+    /// Loads the driver pipeline cache
+    void LoadPipelineCache();
+
+    /// Rebuilds the shaders and pipelines recorded in the shader disk cache of the title
+    void LoadShaderDiskCache(u64 title_id, const std::atomic_bool& stop_loading,
+                             const VideoCore::DiskResourceLoadCallback& callback);
+
+    /// Returns the key of the pipeline built from the given shaders and state
+    u64 ComputePipelineHash(const std::array<u64, MAX_SHADER_STAGES>& stage_hashes,
+                            const PipelineInfo& info) const;
+
     /// Returns true when the disk data can be used by the current driver
     bool IsCacheValid(std::span<const u8> cache_data) const;
 
@@ -116,10 +135,11 @@ private:
     std::array<u64, MAX_SHADER_STAGES> shader_hashes;
     std::array<Shader*, MAX_SHADER_STAGES> current_shaders;
     std::unordered_map<Pica::Shader::Generator::PicaVSConfig, Shader*> programmable_vertex_map;
-    std::unordered_map<std::string, Shader> programmable_vertex_cache;
+    std::unordered_map<u64, Shader> programmable_vertex_cache;
     std::unordered_map<Pica::Shader::Generator::PicaFixedGSConfig, Shader> fixed_geometry_shaders;
     std::unordered_map<Pica::Shader::Generator::PicaFSConfig, Shader> fragment_shaders;
     Shader trivial_vertex_shader;
+    std::unique_ptr<ShaderDiskCache> shader_disk_cache;
 };
 
 } // namespace Vulkan
@@ -7,6 +7,9 @@
 #include "common/math_util.h"
 #include "common/microprofile.h"
 #include "common/settings.h"
+#include "core/core.h"
+#include "core/hle/kernel/kernel.h"
+#include "core/hle/kernel/process.h"
 #include "video_core/pica_state.h"
 #include "video_core/regs_framebuffer.h"
 #include "video_core/regs_pipeline.h"
@@ -139,7 +142,9 @@ void RasterizerVulkan::TickFrame() {
 
 void RasterizerVulkan::LoadDiskResources(const std::atomic_bool& stop_loading,
                                          const VideoCore::DiskResourceLoadCallback& callback) {
-    pipeline_cache.LoadDiskCache();
+    const auto process = Core::System::GetInstance().Kernel().GetCurrentProcess();
+    const u64 title_id = process ? process->codeset->program_id : 0;
+    pipeline_cache.LoadDiskCache(title_id, stop_loading, callback);
 }
 
 void RasterizerVulkan::SyncFixedState() {
@@ -0,0 +1,175 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <cstring>
+#include <fmt/format.h>
+
+#include "common/common_paths.h"
+#include "common/hash.h"
+#include "common/logging/log.h"
+#include "common/scm_rev.h"
+#include "video_core/renderer_vulkan/vk_instance.h"
+#include "video_core/renderer_vulkan/vk_shader_disk_cache.h"
+#include "video_core/shader/generator/shader_gen.h"
+
+namespace Vulkan {
+
+namespace {
+
+constexpr u32 CacheMagic = 0x43535643; // "CVSC"
+constexpr u32 CacheVersion = 1;
+
+struct CacheHeader {
+    u32 magic;
+    u32 version;
+    u64 build_hash;
+};
+
+struct EntryHeader {
+    ShaderDiskCacheEntryType type;
+    u32 config_size;
+    u32 spirv_size; ///< In words
+    u32 padding;
+    u64 program_hash;
+};
+
+static_assert(std::is_trivially_copyable_v<PipelineInfo>,
+              "PipelineInfo must be trivially copyable to be stored in the shader disk cache");
+
+/**
+ * Identifies the shader generator and the device capabilities that are baked into the generated
+ * shaders. Entries recorded with any of these being different can't be reused.
+ */
+u64 ComputeBuildHash(const Instance& instance) {
+    using namespace Pica::Shader::Generator;
+    u64 hash = Common::ComputeHash64(Common::g_scm_rev, std::strlen(Common::g_scm_rev));
+    hash = Common::HashCombine(hash, sizeof(PicaFSConfigState));
+    hash = Common::HashCombine(hash, sizeof(PicaVSConfigState));
+    hash = Common::HashCombine(hash, sizeof(PicaGSConfigState));
+    hash = Common::HashCombine(hash, sizeof(PipelineInfo));
+    hash = Common::HashCombine(hash, instance.IsShaderClipDistanceSupported());
+    hash = Common::HashCombine(hash, instance.UseGeometryShaders());
+    hash = Common::HashCombine(hash, instance.IsFragmentShaderInterlockSupported());
+    hash = Common::HashCombine(hash, instance.NeedsLogicOpEmulation());
+    hash = Common::HashCombine(hash, instance.IsCustomBorderColorSupported());
+    return hash;
+}
+
+} // Anonymous namespace
+
+ShaderDiskCache::ShaderDiskCache(const Instance& instance, u64 title_id)
+    : path{fmt::format("{}vulkan{}transferable{}{:016X}.bin",
+                       FileUtil::GetUserPath(FileUtil::UserPath::ShaderDir), DIR_SEP, DIR_SEP,
+                       title_id)},
+      build_hash{ComputeBuildHash(instance)} {}
+
+ShaderDiskCache::~ShaderDiskCache() = default;
+
+void ShaderDiskCache::Load(std::vector<ShaderEntry>& shaders,
+                           std::vector<PipelineEntry>& pipelines) {
+    std::scoped_lock lock{mutex};
+
+    u64 valid_size = 0;
+    FileUtil::IOFile in{path, "rb"};
+    if (in.IsOpen()) {
+        const u64 file_size = in.GetSize();
+        CacheHeader header{};
+        if (in.ReadArray(&header, 1) != 1 || header.magic != CacheMagic ||
+            header.version != CacheVersion || header.build_hash != build_hash) {
+            LOG_INFO(Render_Vulkan, "Shader disk cache is outdated, recreating it");
+        } else {
+            valid_size = sizeof(CacheHeader);
+            EntryHeader entry{};
+            while (in.ReadArray(&entry, 1) == 1) {
+                const u64 entry_size = sizeof(EntryHeader) + entry.config_size +
+                                       u64{entry.spirv_size} * sizeof(u32);
+                if (valid_size + entry_size > file_size) {
+                    break;
+                }
+                std::vector<u8> config(entry.config_size);
+                std::vector<u32> spirv(entry.spirv_size);
+                if ((!config.empty() &&
+                     in.ReadBytes(config.data(), config.size()) != config.size()) ||
+                    (!spirv.empty() && in.ReadArray(spirv.data(), spirv.size()) != spirv.size())) {
+                    break;
+                }
+                if (entry.type == ShaderDiskCacheEntryType::Pipeline) {
+                    if (config.size() != sizeof(PipelineEntry)) {
+                        break;
+                    }
+                    PipelineEntry& pipeline = pipelines.emplace_back();
+                    std::memcpy(&pipeline, config.data(), sizeof(PipelineEntry));
+                } else {
+                    shaders.push_back({entry.type, std::move(config), entry.program_hash,
+                                       std::move(spirv)});
+                }
+                valid_size += entry_size;
+            }
+            if (valid_size != file_size) {
+                LOG_WARNING(Render_Vulkan, "Shader disk cache has a truncated entry, dropping it");
+            }
+        }
+        in.Close();
+    }
+
+    LOG_INFO(Render_Vulkan, "Loaded {} shaders and {} pipelines from the shader disk cache",
+             shaders.size(), pipelines.size());
+
+    if (!FileUtil::CreateFullPath(path) || !OpenForAppend(valid_size)) {
+        LOG_ERROR(Render_Vulkan, "Unable to open shader disk cache {} for writing", path);
+    }
+}
+
+bool ShaderDiskCache::OpenForAppend(u64 size) {
+    if (size == 0) {
+        file = FileUtil::IOFile{path, "wb"};
+        const CacheHeader header{CacheMagic, CacheVersion, build_hash};
+        return file.IsOpen() && file.WriteObject(header) == 1 && file.Flush();
+    }
+    file = FileUtil::IOFile{path, "r+b"};
+    return file.IsOpen() && file.Resize(size) && file.Seek(0, SEEK_END);
+}
+
+void ShaderDiskCache::SaveShader(ShaderDiskCacheEntryType type, std::span<const u8> config,
+                                 u64 program_hash, std::span<const u32> spirv) {
+    if (spirv.empty()) {
+        return;
+    }
+    std::scoped_lock lock{mutex};
+    Append(type, config, program_hash, spirv);
+}
+
+void ShaderDiskCache::SavePipeline(const std::array<u64, MAX_SHADER_STAGES>& shader_hashes,
+                                   const PipelineInfo& info) {
+    PipelineEntry entry{};
+    entry.shader_hashes = shader_hashes;
+    entry.info = info;
+
+    std::scoped_lock lock{mutex};
+    Append(ShaderDiskCacheEntryType::Pipeline,
+           {reinterpret_cast<const u8*>(&entry), sizeof(entry)}, 0, {});
+}
+
+void ShaderDiskCache::Append(ShaderDiskCacheEntryType type, std::span<const u8> config,
+                             u64 program_hash, std::span<const u32> spirv) {
+    if (!file.IsOpen()) {
+        return;
+    }
+    const EntryHeader header{type, static_cast<u32>(config.size()),
+                             static_cast<u32>(spirv.size()), 0, program_hash};
+    // Flush after every entry so that a crash loses at most the entry being written
+    bool written = file.WriteObject(header) == 1;
+    if (written && !config.empty()) {
+        written = file.WriteBytes(config.data(), config.size()) == config.size();
+    }
+    if (written && !spirv.empty()) {
+        written = file.WriteArray(spirv.data(), spirv.size()) == spirv.size();
+    }
+    if (!written || !file.Flush()) {
+        LOG_ERROR(Render_Vulkan, "Failed to write to the shader disk cache, disabling it");
+        file.Close();
+    }
+}
+
+} // namespace Vulkan
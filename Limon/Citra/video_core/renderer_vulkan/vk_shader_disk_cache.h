@@ -0,0 +1,82 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "common/file_util.h"
+#include "video_core/renderer_vulkan/vk_graphics_pipeline.h"
+
+namespace Vulkan {
+
+class Instance;
+
+enum class ShaderDiskCacheEntryType : u32 {
+    VertexShader = 0,
+    FragmentShader = 1,
+    GeometryShader = 2,
+    Pipeline = 3,
+};
+
+/**
+ * Per-title record of the shader configurations and pipelines encountered while playing, stored
+ * along with the SPIR-V generated for every shader. Unlike the driver pipeline cache it does not
+ * depend on the driver version, so the shaders and pipelines of a title can be rebuilt ahead of
+ * time on boot instead of when they are first drawn with.
+ *
+ * The file is only ever appended to; entries are written as they are discovered.
+ */
+class ShaderDiskCache {
+public:
+    struct ShaderEntry {
+        ShaderDiskCacheEntryType type;
+        std::vector<u8> config; ///< Raw state of the PICA shader config the shader was built from
+        u64 program_hash;       ///< Hash of the generated program, only used by vertex shaders
+        std::vector<u32> spirv;
+    };
+
+    struct PipelineEntry {
+        std::array<u64, MAX_SHADER_STAGES> shader_hashes;
+        PipelineInfo info;
+    };
+
+    explicit ShaderDiskCache(const Instance& instance, u64 title_id);
+    ~ShaderDiskCache();
+
+    ShaderDiskCache(const ShaderDiskCache&) = delete;
+    ShaderDiskCache& operator=(const ShaderDiskCache&) = delete;
+
+    /**
+     * Reads all entries of the cache file and opens it for appending new ones. A file written by
+     * a different build or for a device with different capabilities is discarded.
+     */
+    void Load(std::vector<ShaderEntry>& shaders, std::vector<PipelineEntry>& pipelines);
+
+    /// Appends a shader entry. Can be called from any thread.
+    void SaveShader(ShaderDiskCacheEntryType type, std::span<const u8> config, u64 program_hash,
+                    std::span<const u32> spirv);
+
+    /// Appends a pipeline entry. Can be called from any thread.
+    void SavePipeline(const std::array<u64, MAX_SHADER_STAGES>& shader_hashes,
+                      const PipelineInfo& info);
+
+private:
+    /// Truncates the file to the given size and positions it for appending.
+    bool OpenForAppend(u64 size);
+
+    /// Writes a single entry to the end of the file.
+    void Append(ShaderDiskCacheEntryType type, std::span<const u8> config, u64 program_hash,
+                std::span<const u32> spirv);
+
+    std::string path;
+    u64 build_hash;
+    std::mutex mutex;
+    FileUtil::IOFile file;
+};
+
+} // namespace Vulkan
@@ -158,7 +158,7 @@ bool InitializeCompiler() {
 }
 } // Anonymous namespace
 
-vk::ShaderModule Compile(std::string_view code, vk::ShaderStageFlagBits stage, vk::Device device) {
+std::vector<u32> CompileGLSL(std::string_view code, vk::ShaderStageFlagBits stage) {
     if (!InitializeCompiler()) {
         return {};
     }
@@ -212,7 +212,15 @@ vk::ShaderModule Compile(std::string_view code, vk::ShaderStageFlagBits stage, v
         LOG_INFO(Render_Vulkan, "SPIR-V conversion messages: {}", spv_messages);
     }
 
-    return CompileSPV(out_code, device);
+    return out_code;
+}
+
+vk::ShaderModule Compile(std::string_view code, vk::ShaderStageFlagBits stage, vk::Device device) {
+    const std::vector<u32> spirv = CompileGLSL(code, stage);
+    if (spirv.empty()) {
+        return {};
+    }
+    return CompileSPV(spirv, device);
 }
 
 vk::ShaderModule CompileSPV(std::span<const u32> code, vk::Device device) {
@@ -5,11 +5,20 @@
 #pragma once
 
 #include <span>
+#include <vector>
 
 #include "video_core/renderer_vulkan/vk_common.h"
 
 namespace Vulkan {
 
+/**
+ * @brief Converts GLSL to SPIR-V using glslang.
+ * @param code The string containing GLSL code.
+ * @param stage The pipeline stage the shader will be used in.
+ * @return The SPIR-V bytecode, empty if compilation failed.
+ */
+std::vector<u32> CompileGLSL(std::string_view code, vk::ShaderStageFlagBits stage);
+
 /**
  * @brief Creates a vulkan shader module from GLSL by converting it to SPIR-V using glslang.
  * @param code The string containing GLSL code.
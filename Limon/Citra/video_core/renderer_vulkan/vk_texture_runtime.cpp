@@ -1113,6 +1113,22 @@ u32 Surface::GetInternalBytesPerPixel() const {
     return vk::blockSize(traits.native);
 }
 
+u64 Surface::MemoryUsage() const {
+    const auto allocation_size = [this](const Handle& handle) -> u64 {
+        if (!handle.image) {
+            return 0;
+        }
+        VmaAllocationInfo info{};
+        vmaGetAllocationInfo(instance->GetAllocator(), handle.alloc, &info);
+        return info.size;
+    };
+    u64 usage = allocation_size(copy_handle);
+    for (const Handle& handle : handles) {
+        usage += allocation_size(handle);
+    }
+    return usage;
+}
+
 vk::AccessFlags Surface::AccessFlags() const noexcept {
     const bool is_color = static_cast<bool>(Aspect() & vk::ImageAspectFlagBits::eColor);
     const vk::AccessFlags attachment_flags =
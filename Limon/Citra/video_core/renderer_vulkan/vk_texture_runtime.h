@@ -162,6 +162,9 @@ public:
     /// Returns the bpp of the internal surface format
     u32 GetInternalBytesPerPixel() const;
 
+    /// Returns the size of the device memory backing the surface images
+    u64 MemoryUsage() const;
+
     /// Returns the access flags indicative of the surface
     vk::AccessFlags AccessFlags() const noexcept;
 
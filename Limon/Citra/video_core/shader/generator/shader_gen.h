@@ -150,6 +150,9 @@ struct PicaFSConfigState {
  * be) two separate shaders sharing the same key.
  */
 struct PicaFSConfig : Common::HashableStruct<PicaFSConfigState> {
+    /// Creates a zeroed config, to be filled in from a serialized state
+    PicaFSConfig() = default;
+
     PicaFSConfig(const Pica::Regs& regs, bool has_fragment_shader_interlock, bool emulate_logic_op,
                  bool emulate_custom_border_color, bool emulate_blend_minmax_factor,
                  bool use_custom_normal_map = false);
@@ -223,6 +226,9 @@ struct PicaVSConfigState {
  * shader.
  */
 struct PicaVSConfig : Common::HashableStruct<PicaVSConfigState> {
+    /// Creates a zeroed config, to be filled in from a serialized state
+    PicaVSConfig() = default;
+
     explicit PicaVSConfig(const Pica::Regs& regs, Pica::Shader::ShaderSetup& setup,
                           bool use_clip_planes_, bool use_geometry_shader_);
 };
@@ -232,6 +238,9 @@ struct PicaVSConfig : Common::HashableStruct<PicaVSConfigState> {
  * shader pipeline
  */
 struct PicaFixedGSConfig : Common::HashableStruct<PicaGSConfigState> {
+    /// Creates a zeroed config, to be filled in from a serialized state
+    PicaFixedGSConfig() = default;
+
     explicit PicaFixedGSConfig(const Pica::Regs& regs, bool use_clip_planes_);
 };
 
@@ -106,6 +106,16 @@ void UnitState::WriteOutput(const ShaderRegs& config, AttributeBuffer& output) {
 
 UnitState::UnitState(GSEmitter* emitter) : emitter_ptr(emitter) {}
 
+UnitRegisterMap::UnitRegisterMap(const ShaderRegs& config) {
+    num_inputs = config.max_input_attribute_index + 1;
+    for (u32 attr = 0; attr < num_inputs; ++attr) {
+        input_registers[attr] = static_cast<u8>(config.GetRegisterForAttribute(attr));
+    }
+    for (u32 reg : Common::BitSet<u32>(config.output_mask)) {
+        output_registers[num_outputs++] = static_cast<u8>(reg);
+    }
+}
+
 GSEmitter::GSEmitter() {
     handlers = new Handlers;
 }
@@ -140,6 +150,7 @@ void GSUnitState::ConfigOutput(const ShaderRegs& config) {
 }
 
 MICROPROFILE_DEFINE(GPU_Shader, "GPU", "Shader", MP_RGB(50, 50, 240));
+MICROPROFILE_DEFINE(GPU_ShaderJit, "GPU", "Shader JIT", MP_RGB(100, 100, 240));
 
 #if CITRA_ARCH(x86_64)
 static std::unique_ptr<JitX64Engine> jit_engine;
@@ -164,8 +175,23 @@ ShaderEngine* GetEngine() {
 
 void Shutdown() {
 #if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (jit_engine) {
+        const JitCacheStats stats = jit_engine->GetCacheStats();
+        LOG_DEBUG(HW_GPU, "Shader JIT cache: {} hits, {} misses, {} pending, {} evictions, {} ms",
+                  stats.hits, stats.misses, stats.pending, stats.evictions,
+                  stats.compile_time_us / 1000);
+    }
     jit_engine = nullptr;
 #endif
 }
 
+JitCacheStats GetJitCacheStats() {
+#if CITRA_ARCH(x86_64) || CITRA_ARCH(arm64)
+    if (jit_engine) {
+        return jit_engine->GetCacheStats();
+    }
+#endif
+    return {};
+}
+
 } // namespace Pica::Shader
@@ -243,6 +243,35 @@ private:
     }
 };
 
+/**
+ * Mapping between the attributes of a vertex and the registers of a shader unit, resolved once
+ * from the shader configuration so that it can be applied to every vertex of a draw.
+ */
+class UnitRegisterMap {
+public:
+    explicit UnitRegisterMap(const ShaderRegs& config);
+
+    /// Loads the unit state with an input vertex, like UnitState::LoadInput.
+    void LoadInput(UnitState& state, const AttributeBuffer& input) const {
+        for (u32 attr = 0; attr < num_inputs; ++attr) {
+            state.registers.input[input_registers[attr]] = input.attr[attr];
+        }
+    }
+
+    /// Writes the output registers of the unit state, like UnitState::WriteOutput.
+    void WriteOutput(const UnitState& state, AttributeBuffer& output) const {
+        for (u32 i = 0; i < num_outputs; ++i) {
+            output.attr[i] = state.registers.output[output_registers[i]];
+        }
+    }
+
+private:
+    u32 num_inputs = 0;
+    u32 num_outputs = 0;
+    std::array<u8, 16> input_registers{};
+    std::array<u8, 16> output_registers{};
+};
+
 struct ShaderSetup {
     Uniforms uniforms;
 
@@ -318,8 +347,20 @@ public:
     virtual void Run(const ShaderSetup& setup, UnitState& state) const = 0;
 };
 
+/// Counters of the JIT shader cache, for diagnostics
+struct JitCacheStats {
+    u64 hits;            ///< Batches that ran an already compiled shader
+    u64 misses;          ///< Batches that had to queue a compilation
+    u64 pending;         ///< Batches interpreted because their shader was still compiling
+    u64 evictions;       ///< Compiled shaders dropped to stay within the memory budget
+    u64 compile_time_us; ///< Total time spent compiling, in microseconds
+};
+
 // TODO(yuriks): Remove and make it non-global state somewhere
 ShaderEngine* GetEngine();
 void Shutdown();
 
+/// Returns the counters of the JIT shader cache, all zero if the JIT isn't in use.
+JitCacheStats GetJitCacheStats();
+
 } // namespace Pica::Shader
@@ -0,0 +1,832 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <nihstro/shader_bytecode.h>
+#include "common/assert.h"
+#include "common/logging/log.h"
+#include "video_core/pica_types.h"
+#include "video_core/shader/shader_decoder.h"
+
+using nihstro::Instruction;
+using nihstro::OpCode;
+using nihstro::RegisterType;
+using nihstro::SourceRegister;
+using nihstro::SwizzlePattern;
+
+namespace Pica::Shader {
+
+// Micro-ops, in the order of the dispatch table
+#define PICA_MICRO_OPS(X)                                                                          \
+    X(ADD)                                                                                         \
+    X(MUL)                                                                                         \
+    X(FLR)                                                                                         \
+    X(MAX)                                                                                         \
+    X(MIN)                                                                                         \
+    X(DP3)                                                                                         \
+    X(DP4)                                                                                         \
+    X(DPH)                                                                                         \
+    X(RCP)                                                                                         \
+    X(RSQ)                                                                                         \
+    X(MOVA)                                                                                        \
+    X(MOV)                                                                                         \
+    X(SGE)                                                                                         \
+    X(SLT)                                                                                         \
+    X(CMP)                                                                                         \
+    X(EX2)                                                                                         \
+    X(LG2)                                                                                         \
+    X(MAD)                                                                                         \
+    X(END)                                                                                         \
+    X(JMPC)                                                                                        \
+    X(JMPU)                                                                                        \
+    X(CALL)                                                                                        \
+    X(CALLU)                                                                                       \
+    X(CALLC)                                                                                       \
+    X(IFU)                                                                                         \
+    X(IFC)                                                                                         \
+    X(LOOP)                                                                                        \
+    X(BREAK)                                                                                       \
+    X(BREAKC)                                                                                      \
+    X(EMIT)                                                                                        \
+    X(SETEMIT)                                                                                     \
+    X(NOP)                                                                                         \
+    X(UNHANDLED)
+
+namespace {
+
+enum class MicroOpType : u8 {
+#define MICRO_OP_ENUM(name) name,
+    PICA_MICRO_OPS(MICRO_OP_ENUM)
+#undef MICRO_OP_ENUM
+};
+
+enum class SourceFile : u8 {
+    Input,
+    Temporary,
+    Uniform,
+    Zero, ///< Register types that can't be read, which read as zero
+};
+
+enum class DestFile : u8 {
+    Output,
+    Temporary,
+    Discard, ///< Register types that can't be written
+};
+
+struct SourceOperand {
+    SourceFile file;
+    u8 index;
+    u8 address_register; ///< Address register offsetting the uniform index plus one, 0 if none
+    u8 selector;         ///< Component read by each lane, 2 bits per lane starting from x
+    bool negate;
+};
+
+struct FlowControl {
+    u16 dest_offset;
+    u16 num_instructions;
+    u8 uniform_id; ///< Bool uniform of JMPU, CALLU and IFU, int uniform of LOOP
+    u8 condition;  ///< Instruction::FlowControlType::Op
+    bool refx;
+    bool refy;
+};
+
+struct SetEmit {
+    u8 vertex_id;
+    bool prim_emit;
+    bool winding;
+};
+
+struct IfScope {
+    u32 else_address;
+    u32 end_address;
+};
+
+struct CallScope {
+    u32 end_address;
+    u32 return_address;
+};
+
+struct LoopScope {
+    u32 entry_address;
+    u32 end_address;
+    u8 loop_downcounter;
+    u8 address_increment;
+    u8 previous_aL;
+};
+
+/// Fixed capacity stack dropping its oldest element when full, like boost::circular_buffer
+template <typename T, std::size_t Capacity>
+class ScopeStack {
+public:
+    [[nodiscard]] bool empty() const {
+        return count == 0;
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        return count;
+    }
+
+    T& back() {
+        return elements[count - 1];
+    }
+
+    void push_back(const T& element) {
+        if (count == Capacity) {
+            std::move(elements.begin() + 1, elements.end(), elements.begin());
+            --count;
+        }
+        elements[count++] = element;
+    }
+
+    void pop_back() {
+        --count;
+    }
+
+private:
+    std::array<T, Capacity> elements;
+    std::size_t count = 0;
+};
+
+static_assert(sizeof(Common::Vec4<f24>) == 4 * sizeof(f24),
+              "Registers are addressed as arrays of four components");
+
+SourceOperand MakeSource(SourceRegister reg, u32 address_register_index,
+                         const std::array<SwizzlePattern::Selector, 4>& selectors, bool negate) {
+    SourceOperand source{};
+    switch (reg.GetRegisterType()) {
+    case RegisterType::Input:
+        source.file = SourceFile::Input;
+        source.index = static_cast<u8>(reg.GetIndex());
+        break;
+    case RegisterType::Temporary:
+        source.file = SourceFile::Temporary;
+        source.index = static_cast<u8>(reg.GetIndex());
+        break;
+    case RegisterType::FloatUniform:
+        source.file = SourceFile::Uniform;
+        source.index = static_cast<u8>(reg.GetIndex());
+        source.address_register = static_cast<u8>(address_register_index);
+        break;
+    default:
+        source.file = SourceFile::Zero;
+        break;
+    }
+    for (u32 i = 0; i < 4; ++i) {
+        source.selector |= static_cast<u8>(static_cast<u32>(selectors[i]) << (2 * i));
+    }
+    source.negate = negate;
+    return source;
+}
+
+std::array<SwizzlePattern::Selector, 4> Src1Selectors(SwizzlePattern swizzle) {
+    return {swizzle.src1_selector_0.Value(), swizzle.src1_selector_1.Value(),
+            swizzle.src1_selector_2.Value(), swizzle.src1_selector_3.Value()};
+}
+
+std::array<SwizzlePattern::Selector, 4> Src2Selectors(SwizzlePattern swizzle) {
+    return {swizzle.src2_selector_0.Value(), swizzle.src2_selector_1.Value(),
+            swizzle.src2_selector_2.Value(), swizzle.src2_selector_3.Value()};
+}
+
+std::array<SwizzlePattern::Selector, 4> Src3Selectors(SwizzlePattern swizzle) {
+    return {swizzle.src3_selector_0.Value(), swizzle.src3_selector_1.Value(),
+            swizzle.src3_selector_2.Value(), swizzle.src3_selector_3.Value()};
+}
+
+} // Anonymous namespace
+
+struct DecodedShader::MicroOp {
+    MicroOpType type;
+    DestFile dest_file;
+    u8 dest_index;
+    u8 dest_mask; ///< Bit i is set when component i is written
+    std::array<u8, 2> compare_ops; ///< Instruction::Common::CompareOpType of CMP for x and y
+    union {
+        std::array<SourceOperand, 3> src;
+        FlowControl flow;
+        SetEmit set_emit;
+        u32 hex; ///< Unhandled instruction, for logging
+    };
+};
+
+DecodedShader::DecodedShader(const ProgramCode& program_code, const SwizzleData& swizzle_data) {
+    // One more op than instructions, so that running off the end of the program stops it
+    ops.resize(MAX_PROGRAM_CODE_LENGTH + 1);
+    ops.back().type = MicroOpType::END;
+
+    for (u32 offset = 0; offset < MAX_PROGRAM_CODE_LENGTH; ++offset) {
+        const Instruction instr = {program_code[offset]};
+        MicroOp& op = ops[offset];
+        op.type = MicroOpType::UNHANDLED;
+        op.hex = instr.hex;
+
+        const auto set_dest = [&op](auto dest, SwizzlePattern swizzle) {
+            if (dest < 0x10) {
+                op.dest_file = DestFile::Output;
+                op.dest_index = static_cast<u8>(dest.GetIndex());
+            } else if (dest < 0x20) {
+                op.dest_file = DestFile::Temporary;
+                op.dest_index = static_cast<u8>(dest.GetIndex());
+            } else {
+                op.dest_file = DestFile::Discard;
+                op.dest_index = 0;
+            }
+            op.dest_mask = 0;
+            for (u32 i = 0; i < 4; ++i) {
+                op.dest_mask |= swizzle.DestComponentEnabled(i) ? 1 << i : 0;
+            }
+        };
+
+        switch (instr.opcode.Value().GetInfo().type) {
+        case OpCode::Type::Arithmetic: {
+            const SwizzlePattern swizzle = {swizzle_data[instr.common.operand_desc_id]};
+            const bool is_inverted =
+                (0 != (instr.opcode.Value().GetInfo().subtype & OpCode::Info::SrcInversed));
+            const auto op_type = [&]() -> std::optional<MicroOpType> {
+                switch (instr.opcode.Value().EffectiveOpCode()) {
+                case OpCode::Id::ADD:
+                    return MicroOpType::ADD;
+                case OpCode::Id::MUL:
+                    return MicroOpType::MUL;
+                case OpCode::Id::FLR:
+                    return MicroOpType::FLR;
+                case OpCode::Id::MAX:
+                    return MicroOpType::MAX;
+                case OpCode::Id::MIN:
+                    return MicroOpType::MIN;
+                case OpCode::Id::DP3:
+                    return MicroOpType::DP3;
+                case OpCode::Id::DP4:
+                    return MicroOpType::DP4;
+                case OpCode::Id::DPH:
+                case OpCode::Id::DPHI:
+                    return MicroOpType::DPH;
+                case OpCode::Id::RCP:
+                    return MicroOpType::RCP;
+                case OpCode::Id::RSQ:
+                    return MicroOpType::RSQ;
+                case OpCode::Id::MOVA:
+                    return MicroOpType::MOVA;
+                case OpCode::Id::MOV:
+                    return MicroOpType::MOV;
+                case OpCode::Id::SGE:
+                case OpCode::Id::SGEI:
+                    return MicroOpType::SGE;
+                case OpCode::Id::SLT:
+                case OpCode::Id::SLTI:
+                    return MicroOpType::SLT;
+                case OpCode::Id::CMP:
+                    return MicroOpType::CMP;
+                case OpCode::Id::EX2:
+                    return MicroOpType::EX2;
+                case OpCode::Id::LG2:
+                    return MicroOpType::LG2;
+                default:
+                    return std::nullopt;
+                }
+            }();
+            if (!op_type) {
+                break;
+            }
+            op.type = *op_type;
+            op.src[0] = MakeSource(instr.common.GetSrc1(is_inverted),
+                                   !is_inverted * instr.common.address_register_index,
+                                   Src1Selectors(swizzle), swizzle.negate_src1.Value() != 0);
+            op.src[1] = MakeSource(instr.common.GetSrc2(is_inverted),
+                                   is_inverted * instr.common.address_register_index,
+                                   Src2Selectors(swizzle), swizzle.negate_src2.Value() != 0);
+            set_dest(instr.common.dest.Value(), swizzle);
+            op.compare_ops = {static_cast<u8>(instr.common.compare_op.x.Value()),
+                              static_cast<u8>(instr.common.compare_op.y.Value())};
+            break;
+        }
+
+        case OpCode::Type::MultiplyAdd: {
+            if ((instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MAD) &&
+                (instr.opcode.Value().EffectiveOpCode() != OpCode::Id::MADI)) {
+                break;
+            }
+            const SwizzlePattern swizzle = {swizzle_data[instr.mad.operand_desc_id]};
+            const bool is_inverted = (instr.opcode.Value().EffectiveOpCode() == OpCode::Id::MADI);
+            op.type = MicroOpType::MAD;
+            op.src[0] = MakeSource(instr.mad.GetSrc1(is_inverted), 0, Src1Selectors(swizzle),
+                                   swizzle.negate_src1.Value() != 0);
+            op.src[1] = MakeSource(instr.mad.GetSrc2(is_inverted),
+                                   !is_inverted * instr.mad.address_register_index,
+                                   Src2Selectors(swizzle), swizzle.negate_src2.Value() != 0);
+            op.src[2] = MakeSource(instr.mad.GetSrc3(is_inverted),
+                                   is_inverted * instr.mad.address_register_index,
+                                   Src3Selectors(swizzle), swizzle.negate_src3.Value() != 0);
+            set_dest(instr.mad.dest.Value(), swizzle);
+            break;
+        }
+
+        default: {
+            const auto set_flow = [&op, &instr](MicroOpType type, u32 uniform_id) {
+                op.type = type;
+                op.flow = {
+                    .dest_offset = static_cast<u16>(instr.flow_control.dest_offset),
+                    .num_instructions = static_cast<u16>(instr.flow_control.num_instructions),
+                    .uniform_id = static_cast<u8>(uniform_id),
+                    .condition = static_cast<u8>(instr.flow_control.op.Value()),
+                    .refx = instr.flow_control.refx.Value() != 0,
+                    .refy = instr.flow_control.refy.Value() != 0,
+                };
+            };
+
+            switch (instr.opcode.Value()) {
+            case OpCode::Id::END:
+                op.type = MicroOpType::END;
+                break;
+            case OpCode::Id::JMPC:
+                set_flow(MicroOpType::JMPC, 0);
+                break;
+            case OpCode::Id::JMPU:
+                set_flow(MicroOpType::JMPU, instr.flow_control.bool_uniform_id);
+                break;
+            case OpCode::Id::CALL:
+                set_flow(MicroOpType::CALL, 0);
+                break;
+            case OpCode::Id::CALLU:
+                set_flow(MicroOpType::CALLU, instr.flow_control.bool_uniform_id);
+                break;
+            case OpCode::Id::CALLC:
+                set_flow(MicroOpType::CALLC, 0);
+                break;
+            case OpCode::Id::NOP:
+                op.type = MicroOpType::NOP;
+                break;
+            case OpCode::Id::IFU:
+                set_flow(MicroOpType::IFU, instr.flow_control.bool_uniform_id);
+                break;
+            case OpCode::Id::IFC:
+                set_flow(MicroOpType::IFC, 0);
+                break;
+            case OpCode::Id::LOOP:
+                set_flow(MicroOpType::LOOP, instr.flow_control.int_uniform_id);
+                break;
+            case OpCode::Id::BREAK:
+                op.type = MicroOpType::BREAK;
+                break;
+            case OpCode::Id::BREAKC:
+                set_flow(MicroOpType::BREAKC, 0);
+                break;
+            case OpCode::Id::EMIT:
+                op.type = MicroOpType::EMIT;
+                break;
+            case OpCode::Id::SETEMIT:
+                op.type = MicroOpType::SETEMIT;
+                op.set_emit = {
+                    .vertex_id = static_cast<u8>(instr.setemit.vertex_id),
+                    .prim_emit = instr.setemit.prim_emit != 0,
+                    .winding = instr.setemit.winding != 0,
+                };
+                break;
+            default:
+                break;
+            }
+            break;
+        }
+        }
+    }
+}
+
+DecodedShader::~DecodedShader() = default;
+
+// GCC and Clang have a C++ extension to support a lookup table of labels. Otherwise, fallback to a
+// switch statement.
+#if defined __GNUC__ || defined __clang__
+#define DISPATCH() goto* dispatch_table[static_cast<std::size_t>(op->type)]
+#else
+#define DISPATCH() goto dispatch
+#endif
+
+/// Closes the scopes ending after the instruction at pc and moves on to the next micro-op
+#define NEXT(target, is_break)                                                                     \
+    pc = close_scopes(pc, target, is_break);                                                       \
+    op = &ops[pc];                                                                                 \
+    DISPATCH()
+
+void DecodedShader::Run(const ShaderSetup& setup, UnitState& state, unsigned entry_point) const {
+    // Constants for handling invalid inputs
+    static const f24 zeros[4] = {f24::Zero(), f24::Zero(), f24::Zero(), f24::Zero()};
+    static const f24 ones[4] = {f24::One(), f24::One(), f24::One(), f24::One()};
+
+    ScopeStack<IfScope, 8> if_stack;
+    ScopeStack<CallScope, 4> call_stack;
+    ScopeStack<LoopScope, 4> loop_stack;
+
+    state.conditional_code[0] = false;
+    state.conditional_code[1] = false;
+
+    const auto& uniforms = setup.uniforms;
+    const std::array<const f24*, 4> source_files = {
+        &state.registers.input[0].x,
+        &state.registers.temporary[0].x,
+        &uniforms.f[0].x,
+        zeros,
+    };
+    f24 discard[4];
+    const std::array<f24*, 3> dest_files = {
+        &state.registers.output[0].x,
+        &state.registers.temporary[0].x,
+        discard,
+    };
+
+    const auto load = [&](const SourceOperand& source, f24 (&value)[4]) {
+        const f24* reg = source_files[static_cast<std::size_t>(source.file)] + source.index * 4;
+        if (source.address_register != 0) {
+            s32 offset = state.address_registers[source.address_register - 1];
+            if (offset < std::numeric_limits<s8>::min() ||
+                offset > std::numeric_limits<s8>::max()) [[unlikely]] {
+                offset = 0;
+            }
+            const u32 index = (source.index + offset) & 0x7F;
+            // If the index is above 96, the result is all one.
+            reg = index < 96 ? &uniforms.f[index].x : ones;
+        }
+        for (u32 i = 0; i < 4; ++i) {
+            value[i] = reg[(source.selector >> (2 * i)) & 3];
+        }
+        if (source.negate) {
+            for (u32 i = 0; i < 4; ++i) {
+                value[i] = -value[i];
+            }
+        }
+    };
+
+    const auto store = [&](const MicroOp& micro_op, const f24 (&value)[4]) {
+        f24* dest = dest_files[static_cast<std::size_t>(micro_op.dest_file)] +
+                    micro_op.dest_index * 4;
+        for (u32 i = 0; i < 4; ++i) {
+            if (micro_op.dest_mask & (1 << i)) {
+                dest[i] = value[i];
+            }
+        }
+    };
+
+    const auto store_all = [&](const MicroOp& micro_op, f24 value) {
+        const f24 values[4] = {value, value, value, value};
+        store(micro_op, values);
+    };
+
+    const auto evaluate_condition = [&state](const FlowControl& flow) {
+        using Op = Instruction::FlowControlType::Op;
+
+        const bool result_x = flow.refx == state.conditional_code[0];
+        const bool result_y = flow.refy == state.conditional_code[1];
+
+        switch (static_cast<Op>(flow.condition)) {
+        case Op::Or:
+            return result_x || result_y;
+        case Op::And:
+            return result_x && result_y;
+        case Op::JustX:
+            return result_x;
+        case Op::JustY:
+            return result_y;
+        default:
+            UNREACHABLE();
+            return false;
+        }
+    };
+
+    const auto call = [&](u32 pc, const FlowControl& flow) {
+        call_stack.push_back({
+            .end_address = u32{flow.dest_offset} + flow.num_instructions,
+            .return_address = pc + 1,
+        });
+        return u32{flow.dest_offset};
+    };
+
+    const auto begin_if = [&](u32 pc, const FlowControl& flow, bool condition) {
+        if (!condition) {
+            return u32{flow.dest_offset};
+        }
+        if_stack.push_back({
+            .else_address = flow.dest_offset,
+            .end_address = u32{flow.dest_offset} + flow.num_instructions,
+        });
+        return pc + 1;
+    };
+
+    // Stacks are checked in the order CALL -> IF -> LOOP, see RunInterpreter
+    const auto close_scopes = [&](u32 pc, u32 target, bool is_break) {
+        if (call_stack.empty() && if_stack.empty() && loop_stack.empty()) [[likely]] {
+            return target;
+        }
+
+        u32 program_counter = target;
+        u32 next_program_counter = pc + 1;
+        for (u32 i = 0; i < 4; i++) {
+            if (call_stack.empty() || call_stack.back().end_address != next_program_counter)
+                break;
+            // Hardware bug: when popping four CALL scopes at once, the last
+            // one doesn't update the program counter
+            if (i < 3) {
+                program_counter = call_stack.back().return_address;
+                next_program_counter = program_counter;
+            }
+            call_stack.pop_back();
+        }
+
+        if (!if_stack.empty() && if_stack.back().else_address == pc + 1) {
+            program_counter = if_stack.back().end_address;
+            if_stack.pop_back();
+        }
+
+        if (!loop_stack.empty() && (loop_stack.back().end_address == pc + 1 || is_break)) {
+            auto& loop = loop_stack.back();
+            state.address_registers[2] += loop.address_increment;
+            if (!is_break && loop.loop_downcounter--) {
+                program_counter = loop.entry_address;
+            } else {
+                program_counter = loop.end_address;
+                // Only restore previous value if there is a surrounding LOOP scope.
+                if (loop_stack.size() > 1)
+                    state.address_registers[2] = loop.previous_aL;
+                loop_stack.pop_back();
+            }
+        }
+        return program_counter;
+    };
+
+#if defined __GNUC__ || defined __clang__
+#define MICRO_OP_LABEL(name) &&name##_OP,
+    static void* const dispatch_table[] = {PICA_MICRO_OPS(MICRO_OP_LABEL)};
+#undef MICRO_OP_LABEL
+#endif
+
+    f24 src1[4];
+    f24 src2[4];
+    f24 src3[4];
+    f24 result[4];
+    u32 pc = entry_point;
+    const MicroOp* op = &ops[pc];
+    DISPATCH();
+
+#if !(defined __GNUC__ || defined __clang__)
+dispatch:
+    switch (op->type) {
+#define MICRO_OP_CASE(name)                                                                        \
+    case MicroOpType::name:                                                                        \
+        goto name##_OP;
+        PICA_MICRO_OPS(MICRO_OP_CASE)
+#undef MICRO_OP_CASE
+    }
+#endif
+
+ADD_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = src1[i] + src2[i];
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+MUL_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = src1[i] * src2[i];
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+FLR_OP:
+    load(op->src[0], src1);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = f24::FromFloat32(std::floor(src1[i].ToFloat32()));
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+MAX_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        // NOTE: Exact form required to match NaN semantics to hardware:
+        //   max(0, NaN) -> NaN
+        //   max(NaN, 0) -> 0
+        result[i] = (src1[i] > src2[i]) ? src1[i] : src2[i];
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+MIN_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        // NOTE: Exact form required to match NaN semantics to hardware:
+        //   min(0, NaN) -> NaN
+        //   min(NaN, 0) -> 0
+        result[i] = (src1[i] < src2[i]) ? src1[i] : src2[i];
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+DP3_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    store_all(*op, f24::Zero() + src1[0] * src2[0] + src1[1] * src2[1] + src1[2] * src2[2]);
+    NEXT(pc + 1, false);
+
+DP4_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    store_all(*op, f24::Zero() + src1[0] * src2[0] + src1[1] * src2[1] + src1[2] * src2[2] +
+                       src1[3] * src2[3]);
+    NEXT(pc + 1, false);
+
+DPH_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    src1[3] = f24::One();
+    store_all(*op, f24::Zero() + src1[0] * src2[0] + src1[1] * src2[1] + src1[2] * src2[2] +
+                       src1[3] * src2[3]);
+    NEXT(pc + 1, false);
+
+RCP_OP:
+    load(op->src[0], src1);
+    store_all(*op, f24::FromFloat32(1.0f / src1[0].ToFloat32()));
+    NEXT(pc + 1, false);
+
+RSQ_OP:
+    load(op->src[0], src1);
+    store_all(*op, f24::FromFloat32(1.0f / std::sqrt(src1[0].ToFloat32())));
+    NEXT(pc + 1, false);
+
+MOVA_OP:
+    load(op->src[0], src1);
+    for (u32 i = 0; i < 2; ++i) {
+        if (op->dest_mask & (1 << i)) {
+            // TODO: Figure out how the rounding is done on hardware
+            state.address_registers[i] = static_cast<s32>(src1[i].ToFloat32());
+        }
+    }
+    NEXT(pc + 1, false);
+
+MOV_OP:
+    load(op->src[0], src1);
+    store(*op, src1);
+    NEXT(pc + 1, false);
+
+SGE_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = (src1[i] >= src2[i]) ? f24::One() : f24::Zero();
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+SLT_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = (src1[i] < src2[i]) ? f24::One() : f24::Zero();
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+CMP_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    for (u32 i = 0; i < 2; ++i) {
+        using CompareOp = Instruction::Common::CompareOpType;
+        const auto compare_op = static_cast<CompareOp>(op->compare_ops[i]);
+        switch (compare_op) {
+        case CompareOp::Equal:
+            state.conditional_code[i] = (src1[i] == src2[i]);
+            break;
+        case CompareOp::NotEqual:
+            state.conditional_code[i] = (src1[i] != src2[i]);
+            break;
+        case CompareOp::LessThan:
+            state.conditional_code[i] = (src1[i] < src2[i]);
+            break;
+        case CompareOp::LessEqual:
+            state.conditional_code[i] = (src1[i] <= src2[i]);
+            break;
+        case CompareOp::GreaterThan:
+            state.conditional_code[i] = (src1[i] > src2[i]);
+            break;
+        case CompareOp::GreaterEqual:
+            state.conditional_code[i] = (src1[i] >= src2[i]);
+            break;
+        default:
+            LOG_ERROR(HW_GPU, "Unknown compare mode {:x}", static_cast<int>(compare_op));
+            break;
+        }
+    }
+    NEXT(pc + 1, false);
+
+EX2_OP:
+    load(op->src[0], src1);
+    // EX2 only takes first component exp2 and writes it to all dest components
+    store_all(*op, f24::FromFloat32(std::exp2(src1[0].ToFloat32())));
+    NEXT(pc + 1, false);
+
+LG2_OP:
+    load(op->src[0], src1);
+    // LG2 only takes the first component log2 and writes it to all dest components
+    store_all(*op, f24::FromFloat32(std::log2(src1[0].ToFloat32())));
+    NEXT(pc + 1, false);
+
+MAD_OP:
+    load(op->src[0], src1);
+    load(op->src[1], src2);
+    load(op->src[2], src3);
+    for (u32 i = 0; i < 4; ++i) {
+        result[i] = src1[i] * src2[i] + src3[i];
+    }
+    store(*op, result);
+    NEXT(pc + 1, false);
+
+END_OP:
+    close_scopes(pc, pc + 1, false);
+    return;
+
+JMPC_OP:
+    NEXT(evaluate_condition(op->flow) ? u32{op->flow.dest_offset} : pc + 1, false);
+
+JMPU_OP:
+    NEXT(uniforms.b[op->flow.uniform_id] == !(op->flow.num_instructions & 1)
+             ? u32{op->flow.dest_offset}
+             : pc + 1,
+         false);
+
+CALL_OP:
+    NEXT(call(pc, op->flow), false);
+
+CALLU_OP:
+    NEXT(uniforms.b[op->flow.uniform_id] ? call(pc, op->flow) : pc + 1, false);
+
+CALLC_OP:
+    NEXT(evaluate_condition(op->flow) ? call(pc, op->flow) : pc + 1, false);
+
+IFU_OP:
+    NEXT(begin_if(pc, op->flow, uniforms.b[op->flow.uniform_id]), false);
+
+IFC_OP:
+    NEXT(begin_if(pc, op->flow, evaluate_condition(op->flow)), false);
+
+LOOP_OP: {
+    const Common::Vec4<u8>& loop_param = uniforms.i[op->flow.uniform_id];
+    state.address_registers[2] = loop_param.y;
+    loop_stack.push_back({
+        .entry_address = pc + 1,
+        .end_address = u32{op->flow.dest_offset} + 1,
+        .loop_downcounter = loop_param.x,
+        .address_increment = loop_param.z,
+        // Matches the reference interpreter, which reads aL after it has been set
+        .previous_aL = loop_param.y,
+    });
+    NEXT(pc + 1, false);
+}
+
+BREAK_OP:
+    NEXT(pc + 1, true);
+
+BREAKC_OP:
+    NEXT(pc + 1, evaluate_condition(op->flow));
+
+EMIT_OP: {
+    GSEmitter* emitter = state.emitter_ptr;
+    ASSERT_MSG(emitter, "Execute EMIT on VS");
+    emitter->Emit(state.registers.output);
+    NEXT(pc + 1, false);
+}
+
+SETEMIT_OP: {
+    GSEmitter* emitter = state.emitter_ptr;
+    ASSERT_MSG(emitter, "Execute SETEMIT on VS");
+    emitter->vertex_id = op->set_emit.vertex_id;
+    emitter->prim_emit = op->set_emit.prim_emit;
+    emitter->winding = op->set_emit.winding;
+    NEXT(pc + 1, false);
+}
+
+NOP_OP:
+    NEXT(pc + 1, false);
+
+UNHANDLED_OP: {
+    const Instruction instr = {op->hex};
+    LOG_ERROR(HW_GPU, "Unhandled instruction: 0x{:02x} ({}): 0x{:08x}",
+              (int)instr.opcode.Value().EffectiveOpCode(), instr.opcode.Value().GetInfo().name,
+              instr.hex);
+    NEXT(pc + 1, false);
+}
+}
+
+#undef NEXT
+#undef DISPATCH
+#undef PICA_MICRO_OPS
+
+} // namespace Pica::Shader
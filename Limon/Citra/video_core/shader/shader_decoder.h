@@ -0,0 +1,41 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <vector>
+#include "common/common_types.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+/**
+ * Shader program translated once into micro-ops, with register files, swizzles, write masks and
+ * jump targets resolved, so that running it on a vertex doesn't have to decode the instructions
+ * and operand descriptors again. Behaves exactly like the reference interpreter, which is kept for
+ * producing debug information.
+ */
+class DecodedShader {
+public:
+    DecodedShader(const ProgramCode& program_code, const SwizzleData& swizzle_data);
+    ~DecodedShader();
+
+    DecodedShader(const DecodedShader&) = delete;
+    DecodedShader& operator=(const DecodedShader&) = delete;
+
+    /**
+     * Runs the program on a shader unit.
+     * @param setup Shader engine state providing the uniforms
+     * @param state Shader unit state, loaded with the input vertex
+     * @param entry_point Offset of the first instruction to execute
+     */
+    void Run(const ShaderSetup& setup, UnitState& state, unsigned entry_point) const;
+
+private:
+    struct MicroOp;
+
+    std::vector<MicroOp> ops;
+};
+
+} // namespace Pica::Shader
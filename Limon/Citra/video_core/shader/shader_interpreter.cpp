@@ -724,9 +724,38 @@ static void RunInterpreter(const ShaderSetup& setup, UnitState& state, DebugData
     }
 }
 
+namespace {
+/// Maximum number of decoded programs kept, each taking about 90 KiB
+constexpr std::size_t MAX_DECODED_SHADERS = 32;
+} // Anonymous namespace
+
+InterpreterEngine::InterpreterEngine() = default;
+InterpreterEngine::~InterpreterEngine() = default;
+
 void InterpreterEngine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
+    setup.engine_data.cached_shader = GetDecodedShader(setup);
+}
+
+const DecodedShader* InterpreterEngine::GetDecodedShader(ShaderSetup& setup) {
+    // Keyed like the JIT caches, the program can be shared by the vertex and geometry shaders
+    const u64 key = setup.GetProgramCodeHash() ^ setup.GetSwizzleDataHash();
+    if (const auto iter = lookup.find(key); iter != lookup.end()) {
+        shaders.splice(shaders.begin(), shaders, iter->second);
+        return &iter->second->shader;
+    }
+
+    // The two most recently used programs may still be referenced by the vertex and geometry
+    // shader setups
+    while (shaders.size() >= MAX_DECODED_SHADERS && shaders.size() > 2) {
+        lookup.erase(shaders.back().key);
+        shaders.pop_back();
+    }
+
+    shaders.emplace_front(key, setup);
+    lookup.emplace(key, shaders.begin());
+    return &shaders.front().shader;
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
@@ -735,6 +764,12 @@ void InterpreterEngine::Run(const ShaderSetup& setup, UnitState& state) const {
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
+    if (setup.engine_data.cached_shader != nullptr) {
+        const auto* shader = static_cast<const DecodedShader*>(setup.engine_data.cached_shader);
+        shader->Run(setup, state, setup.engine_data.entry_point);
+        return;
+    }
+
     DebugData<false> dummy_debug_data;
     RunInterpreter(setup, state, dummy_debug_data, setup.engine_data.entry_point);
 }
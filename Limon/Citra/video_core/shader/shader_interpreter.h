@@ -4,13 +4,19 @@
 
 #pragma once
 
+#include <list>
+#include <unordered_map>
 #include "video_core/shader/debug_data.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_decoder.h"
 
 namespace Pica::Shader {
 
 class InterpreterEngine final : public ShaderEngine {
 public:
+    InterpreterEngine();
+    ~InterpreterEngine() override;
+
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
@@ -23,6 +29,21 @@ public:
      */
     DebugData<true> ProduceDebugInfo(const ShaderSetup& setup, const AttributeBuffer& input,
                                      const ShaderRegs& config) const;
+
+private:
+    struct CachedShader {
+        CachedShader(u64 key_, const ShaderSetup& setup)
+            : key{key_}, shader{setup.program_code, setup.swizzle_data} {}
+
+        u64 key;
+        DecodedShader shader;
+    };
+
+    /// Returns the decoded program of the setup, decoding it if it isn't cached.
+    const DecodedShader* GetDecodedShader(ShaderSetup& setup);
+
+    std::list<CachedShader> shaders; ///< Ordered from most to least recently used
+    std::unordered_map<u64, std::list<CachedShader>::iterator> lookup;
 };
 
 } // namespace Pica::Shader
@@ -9,6 +9,7 @@
 #if CITRA_ARCH(arm64)
 
 #include "common/assert.h"
+#include "common/literals.h"
 #include "common/microprofile.h"
 #include "video_core/shader/shader.h"
 #include "video_core/shader/shader_jit_a64.h"
@@ -16,32 +17,29 @@
 
 namespace Pica::Shader {
 
-JitA64Engine::JitA64Engine() = default;
+using namespace Common::Literals;
+
+namespace {
+// Each compiled shader reserves MAX_SHADER_SIZE bytes of executable memory
+constexpr std::size_t JitCacheBudget = 64_MiB;
+} // Anonymous namespace
+
+JitA64Engine::JitA64Engine() : cache{JitCacheBudget / MAX_SHADER_SIZE} {}
 JitA64Engine::~JitA64Engine() = default;
 
 void JitA64Engine::SetupBatch(ShaderSetup& setup, unsigned int entry_point) {
     ASSERT(entry_point < MAX_PROGRAM_CODE_LENGTH);
     setup.engine_data.entry_point = entry_point;
-
-    u64 code_hash = setup.GetProgramCodeHash();
-    u64 swizzle_hash = setup.GetSwizzleDataHash();
-
-    u64 cache_key = code_hash ^ swizzle_hash;
-    auto iter = cache.find(cache_key);
-    if (iter != cache.end()) {
-        setup.engine_data.cached_shader = iter->second.get();
-    } else {
-        auto shader = std::make_unique<JitShader>();
-        shader->Compile(&setup.program_code, &setup.swizzle_data);
-        setup.engine_data.cached_shader = shader.get();
-        cache.emplace_hint(iter, cache_key, std::move(shader));
-    }
+    setup.engine_data.cached_shader = cache.Get(setup);
 }
 
 MICROPROFILE_DECLARE(GPU_Shader);
 
 void JitA64Engine::Run(const ShaderSetup& setup, UnitState& state) const {
-    ASSERT(setup.engine_data.cached_shader != nullptr);
+    if (setup.engine_data.cached_shader == nullptr) {
+        interpreter.Run(setup, state);
+        return;
+    }
 
     MICROPROFILE_SCOPE(GPU_Shader);
 
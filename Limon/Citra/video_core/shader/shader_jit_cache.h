@@ -0,0 +1,122 @@
+// Copyright 2023 Citra Emulator Project
+// Licensed under GPLv2 or any later version
+// Refer to the license.txt file included.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include "common/common_types.h"
+#include "common/microprofile.h"
+#include "common/thread_worker.h"
+#include "video_core/shader/shader.h"
+
+namespace Pica::Shader {
+
+MICROPROFILE_DECLARE(GPU_ShaderJit);
+
+/**
+ * Bounded cache of JIT compiled shaders keyed by program and swizzle data. Shaders are compiled on
+ * a background thread; until a shader is ready, Get returns nullptr and the caller is expected to
+ * fall back to the interpreter so the batch is never blocked. Once more than max_shaders shaders
+ * are compiled, the least recently used one is evicted.
+ *
+ * @tparam JitShader the architecture specific shader compiler, which must be constructed and
+ *                   compiled on the same thread
+ */
+template <typename JitShader>
+class JitShaderCache {
+public:
+    explicit JitShaderCache(std::size_t max_shaders_) : max_shaders{max_shaders_} {}
+
+    /**
+     * Returns the compiled shader for the program of the given setup, or nullptr if it isn't
+     * available yet, in which case its compilation is queued.
+     */
+    const JitShader* Get(ShaderSetup& setup) {
+        const u64 key = setup.GetProgramCodeHash() ^ setup.GetSwizzleDataHash();
+        const auto iter = lookup.find(key);
+        if (iter != lookup.end()) {
+            Entry& entry = *iter->second;
+            if (!entry.ready.load(std::memory_order_acquire)) {
+                ++pending;
+                return nullptr;
+            }
+            lru.splice(lru.begin(), lru, iter->second);
+            ++hits;
+            return entry.shader.get();
+        }
+
+        ++misses;
+        lru.emplace_front(key);
+        lookup.emplace(key, lru.begin());
+        Queue(lru.front(), setup);
+        Evict();
+        return nullptr;
+    }
+
+    [[nodiscard]] JitCacheStats GetStats() const {
+        return {hits, misses, pending, evictions, compile_time_us.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Entry {
+        explicit Entry(u64 key_) : key{key_} {}
+
+        u64 key;
+        std::unique_ptr<JitShader> shader;
+        std::atomic_bool ready{false};
+    };
+
+    void Queue(Entry& entry, const ShaderSetup& setup) {
+        // The setup may be changed by the guest while the shader compiles
+        auto program_code = std::make_unique<ProgramCode>(setup.program_code);
+        auto swizzle_data = std::make_unique<SwizzleData>(setup.swizzle_data);
+        worker.QueueWork([this, &entry, program_code = std::move(program_code),
+                          swizzle_data = std::move(swizzle_data)] {
+            MICROPROFILE_SCOPE(GPU_ShaderJit);
+            const auto start = std::chrono::steady_clock::now();
+            auto shader = std::make_unique<JitShader>();
+            shader->Compile(program_code.get(), swizzle_data.get());
+            const auto elapsed = std::chrono::steady_clock::now() - start;
+            compile_time_us.fetch_add(
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(),
+                std::memory_order_relaxed);
+            entry.shader = std::move(shader);
+            entry.ready.store(true, std::memory_order_release);
+        });
+    }
+
+    void Evict() {
+        // The two most recently used shaders may still be referenced by the vertex and geometry
+        // shader setups, and shaders being compiled are owned by the worker until they are ready.
+        auto iter = lru.end();
+        for (std::size_t index = lru.size(); lru.size() > max_shaders && index > 2; --index) {
+            --iter;
+            if (!iter->ready.load(std::memory_order_acquire)) {
+                continue;
+            }
+            lookup.erase(iter->key);
+            iter = lru.erase(iter);
+            ++evictions;
+        }
+    }
+
+    std::size_t max_shaders;
+    std::list<Entry> lru;
+    std::unordered_map<u64, typename std::list<Entry>::iterator> lookup;
+
+    u64 hits = 0;
+    u64 misses = 0;
+    u64 pending = 0;
+    u64 evictions = 0;
+    std::atomic<u64> compile_time_us = 0;
+
+    // Destroyed first, so that a compilation in progress finishes before its entry is freed
+    Common::ThreadWorker worker{1, "ShaderJit"};
+};
+
+} // namespace Pica::Shader
@@ -7,10 +7,10 @@
 #include "common/arch.h"
 #if CITRA_ARCH(x86_64)
 
-#include <memory>
-#include <unordered_map>
 #include "common/common_types.h"
 #include "video_core/shader/shader.h"
+#include "video_core/shader/shader_interpreter.h"
+#include "video_core/shader/shader_jit_cache.h"
 
 namespace Pica::Shader {
 
@@ -24,8 +24,14 @@ public:
     void SetupBatch(ShaderSetup& setup, unsigned int entry_point) override;
     void Run(const ShaderSetup& setup, UnitState& state) const override;
 
+    [[nodiscard]] JitCacheStats GetCacheStats() const {
+        return cache.GetStats();
+    }
+
 private:
-    std::unordered_map<u64, std::unique_ptr<JitShader>> cache;
+    /// Runs batches whose shader is still being compiled
+    InterpreterEngine interpreter;
+    JitShaderCache<JitShader> cache;
 };
 
 } // namespace Pica::Shader
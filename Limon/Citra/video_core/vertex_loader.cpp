@@ -1,8 +1,10 @@
+#include <cstring>
 #include <memory>
 #include "common/alignment.h"
 #include "common/assert.h"
 #include "common/bit_field.h"
 #include "common/common_types.h"
+#include "common/hash.h"
 #include "common/logging/log.h"
 #include "common/vector_math.h"
 #include "core/memory.h"
@@ -16,6 +18,63 @@
 
 namespace Pica {
 
+namespace {
+
+using AttributeLoader = void (*)(const u8* source, Common::Vec4<f24>& attribute);
+
+template <typename T, u32 Elements>
+void LoadAttribute(const u8* source, Common::Vec4<f24>& attribute) {
+    // With the element count fixed, the conversion is unrolled and vectorized by the compiler
+    std::array<T, Elements> data;
+    std::memcpy(data.data(), source, sizeof(data));
+    for (u32 comp = 0; comp < Elements; ++comp) {
+        attribute[comp] = f24::FromFloat32(static_cast<float>(data[comp]));
+    }
+
+    // Default attribute values set if array elements have < 4 components. This
+    // is *not* carried over from the default attribute settings even if they're
+    // enabled for this attribute.
+    for (u32 comp = Elements; comp < 4; ++comp) {
+        attribute[comp] = comp == 3 ? f24::One() : f24::Zero();
+    }
+}
+
+template <typename T>
+AttributeLoader GetAttributeLoader(u32 elements) {
+    static constexpr std::array<AttributeLoader, 4> loaders = {
+        &LoadAttribute<T, 1>,
+        &LoadAttribute<T, 2>,
+        &LoadAttribute<T, 3>,
+        &LoadAttribute<T, 4>,
+    };
+    return loaders[elements - 1];
+}
+
+AttributeLoader GetAttributeLoader(PipelineRegs::VertexAttributeFormat format, u32 elements) {
+    switch (format) {
+    case PipelineRegs::VertexAttributeFormat::BYTE:
+        return GetAttributeLoader<s8>(elements);
+    case PipelineRegs::VertexAttributeFormat::UBYTE:
+        return GetAttributeLoader<u8>(elements);
+    case PipelineRegs::VertexAttributeFormat::SHORT:
+        return GetAttributeLoader<s16>(elements);
+    case PipelineRegs::VertexAttributeFormat::FLOAT:
+        return GetAttributeLoader<float>(elements);
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+} // Anonymous namespace
+
+u64 VertexLoader::ComputeLayoutHash(const PipelineRegs& regs) {
+    // Everything but the base address, which is passed when loading
+    const auto& attribute_config = regs.vertex_attributes;
+    constexpr std::size_t offset = sizeof(u32);
+    return Common::ComputeHash64(reinterpret_cast<const u8*>(&attribute_config) + offset,
+                                 sizeof(attribute_config) - offset);
+}
+
 void VertexLoader::Setup(const PipelineRegs& regs) {
     ASSERT_MSG(!is_setup, "VertexLoader is not intended to be setup more than once.");
 
@@ -54,6 +113,9 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
                     attribute_config.GetFormat(attribute_index);
                 vertex_attribute_elements[attribute_index] =
                     attribute_config.GetNumElements(attribute_index);
+                vertex_attribute_loaders[attribute_index] =
+                    GetAttributeLoader(vertex_attribute_formats[attribute_index],
+                                       vertex_attribute_elements[attribute_index]);
                 offset += attribute_config.GetStride(attribute_index);
             } else if (attribute_index < 16) {
                 // Attribute ids 12, 13, 14 and 15 signify 4, 8, 12 and 16-byte paddings,
@@ -72,7 +134,7 @@ void VertexLoader::Setup(const PipelineRegs& regs) {
 
 void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                               Shader::AttributeBuffer& input,
-                              DebugUtils::MemoryAccessTracker& memory_accesses) {
+                              DebugUtils::MemoryAccessTracker& memory_accesses) const {
     ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
 
     for (int i = 0; i < num_total_attributes; ++i) {
@@ -93,47 +155,8 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
                              : 1));
             }
 
-            switch (vertex_attribute_formats[i]) {
-            case PipelineRegs::VertexAttributeFormat::BYTE: {
-                const s8* srcdata = reinterpret_cast<const s8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::UBYTE: {
-                const u8* srcdata = reinterpret_cast<const u8*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::SHORT: {
-                const s16* srcdata = reinterpret_cast<const s16*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            case PipelineRegs::VertexAttributeFormat::FLOAT: {
-                const float* srcdata = reinterpret_cast<const float*>(
-                    VideoCore::g_memory->GetPhysicalPointer(source_addr));
-                for (unsigned int comp = 0; comp < vertex_attribute_elements[i]; ++comp) {
-                    input.attr[i][comp] = f24::FromFloat32(srcdata[comp]);
-                }
-                break;
-            }
-            }
-
-            // Default attribute values set if array elements have < 4 components. This
-            // is *not* carried over from the default attribute settings even if they're
-            // enabled for this attribute.
-            for (unsigned int comp = vertex_attribute_elements[i]; comp < 4; ++comp) {
-                input.attr[i][comp] = comp == 3 ? f24::One() : f24::Zero();
-            }
+            vertex_attribute_loaders[i](VideoCore::g_memory->GetPhysicalPointer(source_addr),
+                                        input.attr[i]);
 
             LOG_TRACE(HW_GPU,
                       "Loaded {} components of attribute {:x} for vertex {:x} (index {:x}) from "
@@ -158,4 +181,54 @@ void VertexLoader::LoadVertex(u32 base_address, int index, int vertex,
     }
 }
 
+void VertexLoader::LoadVertices(u32 base_address, int first_index, int first_vertex,
+                                std::span<Shader::AttributeBuffer> inputs,
+                                DebugUtils::MemoryAccessTracker& memory_accesses) const {
+    ASSERT_MSG(is_setup, "A VertexLoader needs to be setup before loading vertices.");
+
+    // Memory accesses are recorded per vertex
+    if (g_debug_context && Pica::g_debug_context->recorder) {
+        for (std::size_t i = 0; i < inputs.size(); ++i) {
+            const int offset = static_cast<int>(i);
+            LoadVertex(base_address, first_index + offset, first_vertex + offset, inputs[i],
+                       memory_accesses);
+        }
+        return;
+    }
+    if (inputs.empty()) {
+        return;
+    }
+
+    const u32 last = static_cast<u32>(inputs.size() - 1);
+    for (int i = 0; i < num_total_attributes; ++i) {
+        if (vertex_attribute_elements[i] != 0) {
+            const AttributeLoader load = vertex_attribute_loaders[i];
+            const u32 stride = vertex_attribute_strides[i];
+            const u32 source_addr = base_address + vertex_attribute_sources[i] +
+                                    stride * static_cast<u32>(first_vertex);
+            const u8* first_data = VideoCore::g_memory->GetPhysicalPointer(source_addr);
+            const u8* last_data =
+                VideoCore::g_memory->GetPhysicalPointer(source_addr + stride * last);
+
+            if (first_data && last_data == first_data + stride * last) {
+                // The attribute array of the whole run is in one memory region
+                const u8* data = first_data;
+                for (auto& input : inputs) {
+                    load(data, input.attr[i]);
+                    data += stride;
+                }
+            } else {
+                for (u32 v = 0; v <= last; ++v) {
+                    load(VideoCore::g_memory->GetPhysicalPointer(source_addr + stride * v),
+                         inputs[v].attr[i]);
+                }
+            }
+        } else if (vertex_attribute_is_default[i]) {
+            for (auto& input : inputs) {
+                input.attr[i] = g_state.input_default_attributes.attr[i];
+            }
+        }
+    }
+}
+
 } // namespace Pica
@@ -1,7 +1,10 @@
 #pragma once
 
 #include <array>
+#include <span>
 #include "common/common_types.h"
+#include "common/vector_math.h"
+#include "video_core/pica_types.h"
 #include "video_core/regs_pipeline.h"
 
 namespace Pica {
@@ -23,13 +26,32 @@ public:
 
     void Setup(const PipelineRegs& regs);
     void LoadVertex(u32 base_address, int index, int vertex, Shader::AttributeBuffer& input,
-                    DebugUtils::MemoryAccessTracker& memory_accesses);
+                    DebugUtils::MemoryAccessTracker& memory_accesses) const;
+
+    /**
+     * Loads a run of consecutive vertices, converting each attribute for all of them in one loop.
+     * @param first_index Index of the first vertex in the draw, only used for logging.
+     * @param first_vertex Vertex loaded into inputs[0]; inputs[i] receives first_vertex + i.
+     */
+    void LoadVertices(u32 base_address, int first_index, int first_vertex,
+                      std::span<Shader::AttributeBuffer> inputs,
+                      DebugUtils::MemoryAccessTracker& memory_accesses) const;
+
+    /**
+     * Returns a hash of the attribute layout a loader is set up from. Loaders set up from
+     * configurations with the same hash are interchangeable.
+     */
+    static u64 ComputeLayoutHash(const PipelineRegs& regs);
 
     int GetNumTotalAttributes() const {
         return num_total_attributes;
     }
 
 private:
+    /// Converts the array elements of an attribute and fills in the missing components
+    using AttributeLoader = void (*)(const u8* source, Common::Vec4<f24>& attribute);
+
+    std::array<AttributeLoader, 16> vertex_attribute_loaders{};
     std::array<u32, 16> vertex_attribute_sources;
     std::array<u32, 16> vertex_attribute_strides{};
     std::array<PipelineRegs::VertexAttributeFormat, 16> vertex_attribute_formats;
@@ -8,6 +8,7 @@
 #include "common/settings.h"
 #include "core/core.h"
 #include "core/frontend/emu_window.h"
+#include "video_core/gpu_thread.h"
 #include "video_core/pica.h"
 #include "video_core/pica_state.h"
 #include "video_core/renderer_base.h"
@@ -18,6 +19,7 @@
 namespace VideoCore {
 
 std::unique_ptr<RendererBase> g_renderer{}; ///< Renderer plugin
+std::unique_ptr<GPUThread> g_gpu_thread{};
 
 std::atomic<bool> g_shader_jit_enabled;
 std::atomic<bool> g_hw_shader_enabled;
@@ -43,10 +45,19 @@ void Init(Frontend::EmuWindow& emu_window, Frontend::EmuWindow* secondary_window
         LOG_CRITICAL(Render, "Unknown graphics API {}, using Vulkan", graphics_api);
         g_renderer = std::make_unique<Vulkan::RendererVulkan>(system, emu_window, secondary_window);
     }
+
+    if (Settings::values.async_gpu.GetValue()) {
+        g_gpu_thread = std::make_unique<GPUThread>();
+    }
 }
 
 /// Shutdown the video core
 void Shutdown() {
+    // The queued GPU work still references the renderer and the PICA state
+    if (g_gpu_thread) {
+        g_gpu_thread->Synchronize();
+        g_gpu_thread.reset();
+    }
     Pica::Shutdown();
     g_renderer.reset();
 
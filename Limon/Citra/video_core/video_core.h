@@ -22,9 +22,11 @@ class MemorySystem;
 
 namespace VideoCore {
 
+class GPUThread;
 class RendererBase;
 
 extern std::unique_ptr<RendererBase> g_renderer; ///< Renderer plugin
+extern std::unique_ptr<GPUThread> g_gpu_thread; ///< GPU thread, only created when async_gpu is set
 
 // TODO: Wrap these in a user settings struct along with any other graphics settings (often set from
 // qt ui)
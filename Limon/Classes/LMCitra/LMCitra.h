@@ -26,6 +26,10 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property (nonatomic) NSUInteger _layoutOption;
 
+/// Called from the emulation thread while shaders cached from previous sessions are rebuilt,
+/// with the loading stage, the number of finished shaders and pipelines, and their total.
+@property (nonatomic, copy, nullable) void (^diskCacheLoadProgress)(NSUInteger stage, NSUInteger value, NSUInteger total);
+
 +(LMCitra *) sharedInstance NS_SWIFT_NAME(shared());
 
 -(NSMutableArray<NSString *> *) installedGamePaths;
@@ -44,12 +48,17 @@ NS_ASSUME_NONNULL_BEGIN
 -(void) run;
 -(void) stop;
 
+/// Steps the emulation back by about the given number of seconds, handled by the next frame
+/// of the run loop. Does nothing unless rewind is enabled in the configuration.
+-(void) rewind:(NSUInteger)seconds NS_SWIFT_NAME(rewind(seconds:));
+
 -(void) touchesBegan:(CGPoint)point NS_SWIFT_NAME(touchesBegan(point:));
 -(void) touchesEnded NS_SWIFT_NAME(touchesEnded());
 -(void) touchesMoved:(CGPoint)point NS_SWIFT_NAME(touchesMoved(point:));
 
 -(BOOL) isPaused;
 -(BOOL) isRunning;
+-(BOOL) isRewindEnabled;
 @end
 
 NS_ASSUME_NONNULL_END
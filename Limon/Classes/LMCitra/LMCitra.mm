@@ -17,8 +17,13 @@
 #include "common/logging/backend.h"
 #include "common/logging/log.h"
 #include "core/core.h"
+#include "core/hw/gpu.h"
 #include "core/loader/loader.h"
+#include "video_core/rasterizer_interface.h"
+#include "video_core/renderer_base.h"
+#include "video_core/video_core.h"
 
+#include <atomic>
 #include <dlfcn.h>
 #include <memory>
 #endif
@@ -201,7 +206,19 @@ std::shared_ptr<Common::DynamicLibrary> vulkan_library;
 
 -(void) run {
     window->MakeCurrent();
-    core.Load(*window, std::string([_path UTF8String]));
+    const Core::System::ResultStatus load_result = core.Load(*window, std::string([_path UTF8String]));
+    if (load_result != Core::System::ResultStatus::Success) {
+        // Nothing was initialised, including the renderer
+        _isRunning = FALSE;
+        return;
+    }
+    
+    std::atomic_bool stop_loading{false};
+    void (^progress)(NSUInteger, NSUInteger, NSUInteger) = _diskCacheLoadProgress;
+    VideoCore::g_renderer->Rasterizer()->LoadDiskResources(stop_loading, [progress](VideoCore::LoadCallbackStage stage, std::size_t value, std::size_t total) {
+        if (progress)
+            progress(static_cast<NSUInteger>(stage), value, total);
+    });
     
     Core::TimingEventType* audio_stretching_event{};
     const s64 audio_stretching_ticks{msToCycles(500)};
@@ -237,6 +254,10 @@ std::shared_ptr<Common::DynamicLibrary> vulkan_library;
     
 }
 
+-(void) rewind:(NSUInteger)seconds {
+    core.SendSignal(Core::System::Signal::Rewind, static_cast<u32>(seconds * GPU::SCREEN_REFRESH_RATE));
+}
+
 
 -(void) touchesBegan:(CGPoint)point {
     window->OnTouchEvent((point.x/* * [[UIScreen mainScreen] nativeScale]*/) + 0.5, (point.y/* * [[UIScreen mainScreen] nativeScale]*/) + 0.5);
@@ -257,4 +278,8 @@ std::shared_ptr<Common::DynamicLibrary> vulkan_library;
 -(BOOL) isRunning {
     return _isRunning;
 }
+
+-(BOOL) isRewindEnabled {
+    return Settings::values.enable_rewind.GetValue();
+}
 @end
@@ -141,7 +141,13 @@ void LMConfiguration::ReadValues() {
 
     // Core
     ReadSetting("Core", Settings::values.use_cpu_jit);
+    ReadSetting("Core", Settings::values.multithreaded_cpu);
+    ReadSetting("Core", Settings::values.deterministic_cpu);
     ReadSetting("Core", Settings::values.cpu_clock_percentage);
+    ReadSetting("Core", Settings::values.enable_rewind);
+    ReadSetting("Core", Settings::values.rewind_memory_budget);
+    ReadSetting("Core", Settings::values.rewind_keyframe_interval);
+    ReadSetting("Core", Settings::values.rewind_frame_interval);
 
     // Premium
     ReadSetting("Premium", Settings::values.texture_filter);
@@ -158,6 +164,8 @@ void LMConfiguration::ReadValues() {
     ReadSetting("Renderer", Settings::values.resolution_factor);
     ReadSetting("Renderer", Settings::values.use_disk_shader_cache);
     ReadSetting("Renderer", Settings::values.use_vsync_new);
+    ReadSetting("Renderer", Settings::values.surface_cache_budget);
+    ReadSetting("Renderer", Settings::values.async_gpu);
 
     // Work around to map Android setting for enabling the frame limiter to the format Citra expects
     if (sdl2_config->GetBoolean("Renderer", "use_frame_limit", true)) {
@@ -206,6 +214,7 @@ void LMConfiguration::ReadValues() {
     // Audio
     ReadSetting("Audio", Settings::values.audio_emulation);
     ReadSetting("Audio", Settings::values.enable_audio_stretching);
+    ReadSetting("Audio", Settings::values.parallel_audio_sources);
     ReadSetting("Audio", Settings::values.volume);
     ReadSetting("Audio", Settings::values.output_type);
     ReadSetting("Audio", Settings::values.output_device);
@@ -94,12 +94,37 @@ udp_pad_index=
 # 0: Interpreter (slow), 1 (default): JIT (fast)
 use_cpu_jit =
 
+# Whether to run each emulated ARM11 core on its own host thread (JIT only)
+# 0 (default): Off, 1: On
+multithreaded_cpu =
+
+# Whether to keep the serial core scheduler so movies and savestates reproduce exactly.
+# Always applied while a movie is being recorded or played back.
+# 0 (default): Off, 1: On
+deterministic_cpu =
+
 # Change the Clock Frequency of the emulated 3DS CPU.
 # Underclocking can increase the performance of the game at the risk of freezing.
 # Overclocking may fix lag that happens on console, but also comes with the risk of freezing.
 # Range is any positive integer (but we suspect 25 - 400 is a good idea) Default is 100
 cpu_clock_percentage =
 
+# Whether to record the emulation state into the in-memory rewind buffer
+# 0 (default): Off, 1: On
+enable_rewind =
+
+# Maximum amount of memory used by recorded rewind states, in megabytes. Default is 256
+# A copy of emulated RAM is kept in addition to this while rewind is enabled.
+rewind_memory_budget =
+
+# Seconds between full copies of emulated RAM in the rewind buffer.
+# Shorter intervals make long rewinds faster but use more of the memory budget. Default is 5
+rewind_keyframe_interval =
+
+# Frames between states recorded into the rewind buffer. Each state flushes the GPU caches to
+# emulated RAM, so shorter intervals cost more performance but rewind more precisely. Default is 6
+rewind_frame_interval =
+
 [Renderer]
 # Whether to render using Vulkan
 # 1: Software, 2: Vulkan (default)
@@ -134,6 +159,16 @@ use_vsync_new =
 # 0: Off, 1 (default. On)
 use_disk_shader_cache =
 
+# Host memory budget of the texture and framebuffer cache in MiB. Surfaces unused for the longest
+# are evicted once it is exceeded.
+# 0: Unlimited, 1024 (default)
+surface_cache_budget =
+
+# Whether to process GPU command lists, transfers and presentation on a dedicated thread, so that
+# they overlap with CPU emulation. Improves performance, but may cause issues in some games.
+# 0 (default): Off, 1: On
+async_gpu =
+
 # Resolution scale factor
 # 0: Auto (scales resolution to window size), 1: Native 3DS screen resolution, Otherwise a scale
 # factor for the 3DS resolution
@@ -243,6 +278,10 @@ enable_dsp_lle_thread =
 # 0: No, 1 (default): Yes
 enable_audio_stretching =
 
+# Whether to process the HLE DSP's audio sources on several threads. The output is identical.
+# 0: No, 1 (default): Yes
+parallel_audio_sources =
+
 # Output volume.
 # 1.0 (default): 100%, 0.0; mute
 volume =
@@ -285,6 +285,10 @@ class LMEmulationController : UIViewController {
                 self.citra().resume()
                 self.reloadInGameSettingsMenu()
             }, attributes: self.citra().isPaused() ? [] : [.disabled]),
+            (title: "Rewind", systemName: "backward.fill", action: { action in
+                self.citra().rewind(seconds: 5)
+                self.reloadInGameSettingsMenu()
+            }, attributes: self.citra().isRunning() && self.citra().isRewindEnabled() ? [] : [.disabled]),
             (title: "Stop", systemName: "stop.fill", action: { action in
                 self.citra().stop()
                 self.reloadInGameSettingsMenu()